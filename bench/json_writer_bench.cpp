@@ -0,0 +1,189 @@
+/**
+ * @file json_writer_bench.cpp
+ * @brief Gallery listing serialization: crow::json::wvalue vs. JsonWriter.
+ *
+ * Serializes the same synthetic gallery rows (the fields of /api/gallery items)
+ * once per row through a crow::json::wvalue + dump(), as the listings did
+ * before, and once through JsonWriter. Reports ns/row, heap allocations/row
+ * and the output size. Allocations are counted by interposing malloc (glibc),
+ * so Qt's and libstdc++'s allocations are both included.
+ *
+ * Build with -DBUILD_BENCHMARKS=ON, run: ./json_writer_bench [rows] [repetitions]
+ */
+#include "json_writer.hpp"
+#include "crow/json.h"
+
+#include <QDateTime>
+#include <QString>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// --- Allocation counter ---
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t n, std::size_t size);
+void* __libc_realloc(void* p, std::size_t size);
+}
+
+namespace {
+    std::atomic<std::uint64_t> allocations{0};
+}
+
+extern "C" {
+void* malloc(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+void* calloc(std::size_t n, std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+void* realloc(void* p, std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+}
+
+static std::uint64_t allocationCount() { return allocations.load(std::memory_order_relaxed); }
+#else
+static std::uint64_t allocationCount() { return 0; } // not counted on this platform
+#endif
+
+namespace {
+
+    struct Row {
+        int id;
+        QString fileName, filePath, title, description, copyright, city, country, camera, keywords;
+        QDateTime date;
+    };
+
+    std::vector<Row> makeRows(int n) {
+        std::vector<Row> rows;
+        rows.reserve(static_cast<std::size_t>(n));
+        const QDateTime base(QDate(2024, 5, 1), QTime(12, 0));
+        for (int i = 0; i < n; ++i) {
+            Row r;
+            r.id = 100000 + i;
+            r.fileName = QString("IMG_%1.jpg").arg(i, 5, 10, QChar('0'));
+            r.filePath = QString("2024/Urlaub/Tag %1").arg(i % 14 + 1);
+            r.title = i % 3 == 0 ? QString() : QString("Blick über den Hafen Nr. %1").arg(i);
+            r.description = QString("Abendstimmung am \"Alten Hafen\", Aufnahme %1").arg(i);
+            r.copyright = "© ZHENG Robert";
+            r.city = "Hamburg";
+            r.country = "Deutschland";
+            r.camera = i % 5 == 0 ? QString() : QString("ILCE-7M4");
+            r.keywords = "Hafen,Abend,Schiff,Elbe";
+            r.date = base.addSecs(i * 37);
+            rows.push_back(std::move(r));
+        }
+        return rows;
+    }
+
+    QString url(const Row& r) {
+        return "/media/" + r.filePath + "/" + r.fileName;
+    }
+
+    // Previous path: one wvalue object per row, std::string per field, dump() at the end
+    std::string viaWvalue(const std::vector<Row>& rows) {
+        std::vector<crow::json::wvalue> items;
+        for (const Row& r : rows) {
+            crow::json::wvalue item;
+            item["id"] = r.id;
+            item["filename"] = r.fileName.toStdString();
+            item["name"] = r.title.isEmpty() ? r.fileName.toStdString() : r.title.toStdString();
+            item["type"] = "image";
+            item["url"] = url(r).toStdString();
+            item["date"] = r.date.isValid() ? r.date.toString(Qt::ISODate).toStdString() : "";
+            item["city"] = r.city.toStdString();
+            item["country"] = r.country.toStdString();
+            if (!r.camera.isEmpty()) item["camera"] = r.camera.toStdString();
+            item["title"] = r.title.toStdString();
+            item["description"] = r.description.toStdString();
+            item["copyright"] = r.copyright.toStdString();
+            item["keywords_string"] = r.keywords.toStdString();
+            items.push_back(std::move(item));
+        }
+        crow::json::wvalue result = std::move(items);
+        return result.dump();
+    }
+
+    // Current path (writePhotoItem)
+    std::string viaJsonWriter(const std::vector<Row>& rows) {
+        JsonWriter w(rows.size() * 512 + 2);
+        w.beginArray();
+        for (const Row& r : rows) {
+            w.beginObject();
+            w.key("id").value(r.id);
+            w.key("filename").value(r.fileName);
+            w.key("name").value(r.title.isEmpty() ? r.fileName : r.title);
+            w.key("type").value("image");
+            w.key("url").value(url(r));
+            w.key("date").value(r.date.isValid() ? r.date.toString(Qt::ISODate) : QString());
+            w.key("city").value(r.city);
+            w.key("country").value(r.country);
+            if (!r.camera.isEmpty()) w.key("camera").value(r.camera);
+            w.key("title").value(r.title);
+            w.key("description").value(r.description);
+            w.key("copyright").value(r.copyright);
+            w.key("keywords_string").value(r.keywords);
+            w.endObject();
+        }
+        w.endArray();
+        return w.take();
+    }
+
+    struct Result {
+        double nsPerRow = 0;
+        double allocsPerRow = 0;
+        std::size_t bytes = 0;
+    };
+
+    template <typename F>
+    Result measure(F serialize, const std::vector<Row>& rows, int repetitions) {
+        Result result;
+        const double n = static_cast<double>(rows.size());
+
+        // Allocations of one (warm) run
+        result.bytes = serialize(rows).size();
+        const std::uint64_t before = allocationCount();
+        std::string out = serialize(rows);
+        result.allocsPerRow = static_cast<double>(allocationCount() - before) / n;
+
+        // Best of 'repetitions' runs
+        double best = 0;
+        for (int i = 0; i < repetitions; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            out = serialize(rows);
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            best = i == 0 ? ns : std::min(best, ns);
+        }
+        result.nsPerRow = best / n;
+        return result;
+    }
+
+    void print(const char* name, const Result& r) {
+        std::printf("%-12s %10.1f ns/row %8.1f allocs/row %10zu bytes\n", name, r.nsPerRow, r.allocsPerRow, r.bytes);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const int rowCount = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+    const int repetitions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+    const std::vector<Row> rows = makeRows(rowCount);
+    std::printf("%d rows, best of %d runs\n", rowCount, repetitions);
+    const Result wvalue = measure(viaWvalue, rows, repetitions);
+    const Result writer = measure(viaJsonWriter, rows, repetitions);
+    print("wvalue", wvalue);
+    print("JsonWriter", writer);
+    std::printf("speedup %.2fx, allocations %.1fx fewer\n", wvalue.nsPerRow / writer.nsPerRow,
+                writer.allocsPerRow > 0 ? wvalue.allocsPerRow / writer.allocsPerRow : 0.0);
+    return 0;
+}
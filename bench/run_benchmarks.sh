@@ -0,0 +1,16 @@
+#!/bin/bash
+# Builds the micro benchmarks in Release mode and runs them from the repository root.
+# Usage: bench/run_benchmarks.sh [rows] [repetitions] [renders]
+set -e
+
+cd "$(dirname "$0")/.."
+BUILD_DIR=build_bench
+
+cmake -S . -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release -DBUILD_BENCHMARKS=ON
+cmake --build "$BUILD_DIR" -j"$(nproc)" --target json_writer_bench template_render_bench
+
+echo "== json_writer_bench (gallery rows: wvalue vs. JsonWriter) =="
+"$BUILD_DIR/json_writer_bench" "${1:-2000}" "${2:-20}"
+
+echo "== template_render_bench (per-request compile vs. registry) =="
+"$BUILD_DIR/template_render_bench" templates template.html "${3:-2000}"
@@ -0,0 +1,111 @@
+/**
+ * @file template_render_bench.cpp
+ * @brief Concurrent Mustache render latency: compile per request vs. TemplateRegistry.
+ *
+ * N threads render the same template with the context of the /template route.
+ * "per request" reads and compiles the file for every render, as
+ * crow::mustache::load() did before; "registry" renders the template compiled
+ * once by TemplateRegistry. Reports p50 / p99 latency and throughput per
+ * thread count.
+ *
+ * Build with -DBUILD_BENCHMARKS=ON, run from the repository root:
+ *   ./build/template_render_bench [templates dir] [template] [renders per thread]
+ */
+#include "template_registry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    std::string readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream out;
+        out << in.rdbuf();
+        return out.str();
+    }
+
+    std::string render(const TemplateRegistry::Template& page) {
+        crow::mustache::context ctx;
+        ctx["user_name"] = "Guest";
+        ctx["message"] = "Welcome to the Refactored Server!";
+        ctx["time_is_morning"] = false;
+        return page.render_string(ctx);
+    }
+
+    struct Stats {
+        double p50Us = 0;
+        double p99Us = 0;
+        double rendersPerSecond = 0;
+    };
+
+    // Every thread renders 'renders' times; latencies of all threads are merged
+    template <typename F>
+    Stats run(int threads, int renders, F renderOnce) {
+        std::vector<std::vector<double>> latencies(static_cast<std::size_t>(threads));
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t] {
+                    auto& own = latencies[static_cast<std::size_t>(t)];
+                    own.reserve(static_cast<std::size_t>(renders));
+                    std::size_t sink = 0;
+                    for (int i = 0; i < renders; ++i) {
+                        const auto begin = std::chrono::steady_clock::now();
+                        sink += renderOnce().size();
+                        own.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+                    }
+                    if (sink == 0) std::fprintf(stderr, "empty render\n");
+                });
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<double> all;
+        for (auto& own : latencies) all.insert(all.end(), own.begin(), own.end());
+        std::sort(all.begin(), all.end());
+
+        Stats s;
+        s.p50Us = all[all.size() / 2];
+        s.p99Us = all[std::min(all.size() - 1, all.size() * 99 / 100)];
+        s.rendersPerSecond = static_cast<double>(all.size()) / seconds;
+        return s;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const std::string dir = argc > 1 ? argv[1] : "templates";
+    const std::string name = argc > 2 ? argv[2] : "template.html";
+    const int renders = argc > 3 ? std::max(1, std::atoi(argv[3])) : 2000;
+    const std::string path = dir + "/" + name;
+
+    TemplateRegistry::load(QString::fromStdString(dir));
+    if (!TemplateRegistry::get(name)) {
+        std::fprintf(stderr, "Template %s not found or does not compile\n", path.c_str());
+        return 1;
+    }
+
+    const int maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::printf("%-12s %7s %10s %10s %12s\n", "mode", "threads", "p50 us", "p99 us", "renders/s");
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        const Stats perRequest = run(threads, renders, [&] {
+            return render(crow::mustache::compile(readFile(path)));
+        });
+        const Stats registry = run(threads, renders, [&] {
+            return render(*TemplateRegistry::get(name));
+        });
+        std::printf("%-12s %7d %10.2f %10.2f %12.0f\n", "per request", threads, perRequest.p50Us, perRequest.p99Us,
+                    perRequest.rendersPerSecond);
+        std::printf("%-12s %7d %10.2f %10.2f %12.0f\n", "registry", threads, registry.p50Us, registry.p99Us,
+                    registry.rendersPerSecond);
+    }
+    return 0;
+}
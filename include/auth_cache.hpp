@@ -0,0 +1,134 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "db_manager.hpp"
+
+/**
+ * @brief In-process cache for user records and refresh tokens.
+ *
+ * The SQLite rows behind /api/auth/me and /refresh change rarely, so they are
+ * kept in a sharded map (one std::shared_mutex per shard). DbManager keeps the
+ * cache current: every writer updates or invalidates the affected entries after
+ * its statement succeeded. Expired refresh tokens are removed by the periodic
+ * sweeper (see DbManager::purgeExpiredRefreshTokens), not on read.
+ *
+ * Readers fill the cache after a miss from a row they read earlier. Every shard
+ * therefore counts its invalidations (generation); a reader takes the generation
+ * before its SELECT and passes it to putUser / putRefreshToken, which drop the
+ * row if an invalidation (logout, re-login, deactivation, ...) happened in
+ * between. Otherwise a revoked token or a deactivated user could be revived by
+ * a stale row and stay cached until restart.
+ */
+class AuthCache {
+public:
+    using Generation = std::uint64_t; ///< Invalidation count of a shard.
+
+    /**
+     * @brief Cached refresh token entry.
+     */
+    struct RefreshToken {
+        std::string username; ///< Owner of the token.
+        long long expiresAt = 0; ///< Expiry (seconds since epoch).
+    };
+
+    /**
+     * @brief Looks up a cached user record.
+     *
+     * @param username The username.
+     * @return The cached record, or std::nullopt on a cache miss.
+     */
+    static std::optional<UserData> getUser(const std::string& username);
+
+    /**
+     * @brief Generation of the shard holding a user; take it before reading the row.
+     *
+     * @param username The username.
+     */
+    static Generation userGeneration(const std::string& username);
+
+    /**
+     * @brief Stores a user record (only existing users, id != 0).
+     *
+     * @param user The user record as read from the database.
+     * @param seen userGeneration() taken before the row was read; the record is
+     *             dropped if the shard was invalidated since.
+     */
+    static void putUser(const UserData& user, Generation seen);
+
+    /**
+     * @brief Drops the cached record of a user.
+     *
+     * @param username The username.
+     */
+    static void invalidateUser(const std::string& username);
+
+    /**
+     * @brief Drops the cached record of a user identified by ID.
+     *
+     * Used by the admin writers which only know the ID.
+     *
+     * @param id The user ID.
+     */
+    static void invalidateUserId(int id);
+
+    /**
+     * @brief Looks up a cached refresh token.
+     *
+     * @param token The refresh token.
+     * @return The cached entry (may already be expired), or std::nullopt on a miss.
+     */
+    static std::optional<RefreshToken> getRefreshToken(const std::string& token);
+
+    /**
+     * @brief Generation of the shard holding a token; take it before reading the row.
+     *
+     * @param token The refresh token.
+     */
+    static Generation refreshTokenGeneration(const std::string& token);
+
+    /**
+     * @brief Stores a refresh token (write-through of the writer that created it).
+     *
+     * @param token The refresh token.
+     * @param username The owner.
+     * @param expiresAt Expiry (seconds since epoch).
+     */
+    static void putRefreshToken(const std::string& token, const std::string& username, long long expiresAt);
+
+    /**
+     * @brief Stores a refresh token read after a cache miss.
+     *
+     * @param token The refresh token.
+     * @param username The owner.
+     * @param expiresAt Expiry (seconds since epoch).
+     * @param seen refreshTokenGeneration() taken before the row was read; the
+     *             token is dropped if a revocation happened since.
+     */
+    static void putRefreshToken(const std::string& token, const std::string& username, long long expiresAt,
+                                Generation seen);
+
+    /**
+     * @brief Removes a single refresh token.
+     *
+     * @param token The refresh token.
+     */
+    static void revokeRefreshToken(const std::string& token);
+
+    /**
+     * @brief Removes all refresh tokens of a user.
+     *
+     * @param username The owner.
+     */
+    static void revokeRefreshTokensOf(const std::string& username);
+
+    /**
+     * @brief Removes all refresh tokens that expired before (or at) the given time.
+     *
+     * @param now Current time (seconds since epoch).
+     * @return Number of removed entries.
+     */
+    static std::size_t purgeExpiredRefreshTokens(long long now);
+};
@@ -1,5 +1,8 @@
 #pragma once
 #include "crow.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
 
 /**
@@ -8,6 +11,38 @@
  * Verifies JWT tokens and manages user context.
  */
 struct AuthMiddleware : crow::ILocalMiddleware {
+    /**
+     * @brief Counters of the verified-token cache.
+     */
+    struct CacheStats {
+        std::uint64_t hits = 0; ///< Tokens accepted from the cache.
+        std::uint64_t misses = 0; ///< Tokens that needed full verification.
+        std::size_t entries = 0; ///< Currently cached tokens.
+    };
+
+    /**
+     * @brief Builds the JWT verifier (key + issuer) once at startup.
+     */
+    AuthMiddleware();
+
+    /**
+     * @brief Returns the counters of the verified-token cache.
+     *
+     * @return Hits, misses and current size.
+     */
+    static CacheStats cacheStats();
+
+    /**
+     * @brief Verifies the bearer token of a request outside the middleware chain.
+     *
+     * For routes that are public by default but need the user in some
+     * configurations (signed media URLs). Uses the same verified-token cache.
+     *
+     * @param req The request.
+     * @return The username, or std::nullopt without a valid token.
+     */
+    static std::optional<std::string> userOf(const crow::request& req);
+
     /**
      * @brief Context structure for the middleware.
      */
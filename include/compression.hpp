@@ -0,0 +1,80 @@
+#pragma once
+#include <QString>
+#include <QtGlobal>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief gzip / zstd encoding for HTTP responses.
+ *
+ * gzip uses zlib and is always available; zstd is used when the server was built
+ * with libzstd (HAVE_ZSTD). Levels for on-the-fly compression are capped, so a
+ * misconfiguration cannot turn every response into a CPU hog:
+ *  - GZIP_LEVEL (default 5, 1..9)
+ *  - ZSTD_LEVEL (default 3, 1..9)
+ *  - COMPRESSION_MIN_BYTES (default 1024): smaller bodies are sent as they are
+ * Static assets are compressed once at the highest level: in memory by
+ * StaticAssets, on disk (.gz / .zst siblings) for the files too large for it.
+ */
+class Compression {
+public:
+    /**
+     * @brief A content coding.
+     */
+    enum class Encoding { Identity, Gzip, Zstd };
+
+    /**
+     * @brief Picks the best supported coding from an Accept-Encoding header.
+     *
+     * zstd is preferred over gzip; codings with q=0 are excluded.
+     *
+     * @param acceptEncoding The header value.
+     * @return The coding (Identity if nothing usable is accepted).
+     */
+    static Encoding negotiate(std::string_view acceptEncoding);
+
+    /**
+     * @brief Content-Encoding token ("gzip", "zstd").
+     */
+    static const char* name(Encoding encoding);
+
+    /**
+     * @brief File suffix of a precompressed variant (".gz", ".zst").
+     */
+    static const char* fileSuffix(Encoding encoding);
+
+    /**
+     * @brief Minimum body size for compression (COMPRESSION_MIN_BYTES).
+     */
+    static std::size_t minBytes();
+
+    /**
+     * @brief Whether responses of this Content-Type are worth compressing.
+     */
+    static bool isCompressible(std::string_view contentType);
+
+    /**
+     * @brief Compresses a buffer with the configured on-the-fly level.
+     *
+     * @param data The input.
+     * @param encoding Gzip or Zstd.
+     * @param maxLevel Use the strongest level (static assets, precompression).
+     * @return The compressed data, or std::nullopt if the coding is unavailable
+     *         or compression failed.
+     */
+    static std::optional<std::string> compress(std::string_view data, Encoding encoding, bool maxLevel = false);
+
+    /**
+     * @brief Writes .gz (and .zst) variants next to the compressible files of a directory.
+     *
+     * Existing variants are only rebuilt if the source file is newer. Files below
+     * COMPRESSION_MIN_BYTES and below minFileBytes are skipped.
+     *
+     * @param dir The directory (e.g. "static").
+     * @param minFileBytes Only files of at least this size (StaticAssets passes
+     *                     its in-memory limit: smaller files never come from disk).
+     */
+    static void precompressDirectory(const QString& dir, qint64 minFileBytes = 0);
+};
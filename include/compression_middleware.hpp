@@ -0,0 +1,50 @@
+#pragma once
+#include "crow.h"
+
+#include <cstdint>
+
+/**
+ * @brief Global middleware compressing response bodies (gzip / zstd).
+ *
+ * The coding is negotiated from Accept-Encoding (see Compression::negotiate).
+ * Only compressible Content-Types above COMPRESSION_MIN_BYTES are touched, and
+ * only if the handler did not set a Content-Encoding itself (precompressed static
+ * files). A strong ETag is turned into a weak one, since the compressed bytes
+ * differ from the identity representation; weak comparison is what
+ * If-None-Match uses anyway.
+ *
+ * Disabled with COMPRESSION_ENABLED=0. Must come before CORS etc. in the App
+ * (only the MetricsMiddleware precedes it), so its after_handle runs after theirs.
+ */
+struct CompressionMiddleware {
+    /**
+     * @brief Context structure for the middleware (unused).
+     */
+    struct context {};
+
+    /**
+     * @brief Executed before the request is handled.
+     */
+    void before_handle(crow::request& /*req*/, crow::response& /*res*/, context& /*ctx*/) {
+        // Nothing to do
+    }
+
+    /**
+     * @brief Compresses the body if the client accepts it.
+     *
+     * @param req The request (Accept-Encoding).
+     * @param res The response.
+     * @param ctx The middleware context.
+     */
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+
+    /**
+     * @brief Number of responses compressed on the fly since startup.
+     */
+    static std::uint64_t compressedCount();
+
+    /**
+     * @brief Bytes saved by on-the-fly compression since startup.
+     */
+    static std::uint64_t savedBytes();
+};
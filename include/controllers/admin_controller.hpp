@@ -1,8 +1,6 @@
 #pragma once
-#include "crow.h"
-#include "crow/middlewares/cors.h" // Wichtig
-#include "auth_middleware.hpp"
+#include "crow_app.hpp"
 
 namespace routes {
-    void setupAdminRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app);
+    void setupAdminRoutes(CrowApp& app);
 }
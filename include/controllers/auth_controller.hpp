@@ -1,8 +1,6 @@
 #pragma once
 
-#include "crow.h"
-#include "crow/middlewares/cors.h"
-#include "auth_middleware.hpp"
+#include "crow_app.hpp"
 
 /**
  * @brief Application routes namespace.
@@ -13,5 +11,5 @@ namespace routes {
      * 
      * @param app The Crow application instance.
      */
-    void setupAuthRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app);
+    void setupAuthRoutes(CrowApp& app);
 }
\ No newline at end of file
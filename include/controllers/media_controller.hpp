@@ -0,0 +1,15 @@
+#pragma once
+
+#include "crow_app.hpp"
+
+/**
+ * @brief Application routes namespace.
+ */
+namespace routes {
+    /**
+     * @brief Registers the /media route (originals and WebP versions from Photos/).
+     * 
+     * @param app The Crow application instance.
+     */
+    void setupMediaRoutes(CrowApp& app);
+}
\ No newline at end of file
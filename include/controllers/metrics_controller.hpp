@@ -0,0 +1,15 @@
+#pragma once
+
+#include "crow_app.hpp"
+
+/**
+ * @brief Application routes namespace.
+ */
+namespace routes {
+    /**
+     * @brief Registers the gauges read at scrape time and the /metrics route (Prometheus).
+     * 
+     * @param app The Crow application instance.
+     */
+    void setupMetricsRoutes(CrowApp& app);
+}
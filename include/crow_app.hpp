@@ -0,0 +1,18 @@
+#pragma once
+#include "crow.h"
+#include "crow/middlewares/cors.h"
+#include "auth_middleware.hpp"
+#include "rate_limit_middleware.hpp"
+#include "compression_middleware.hpp"
+#include "metrics_middleware.hpp"
+
+/**
+ * @brief The Crow application type with all middlewares.
+ *
+ * Order matters for the global middlewares: the CompressionMiddleware comes
+ * early so its after_handle sees the final response, and the MetricsMiddleware
+ * wraps everything (its timing includes compression).
+ * The AuthMiddleware is local (CROW_MIDDLEWARES on the protected routes) and
+ * runs after all global ones; it charges the per-user rate limit itself.
+ */
+using CrowApp = crow::App<MetricsMiddleware, CompressionMiddleware, crow::CORSHandler, AuthMiddleware, RateLimitMiddleware>;
@@ -0,0 +1,77 @@
+#pragma once
+#include <functional>
+#include <memory>
+
+namespace crow { struct response; }
+class RequestTrace;
+
+/**
+ * @brief Runs database work on dedicated threads instead of Crow I/O threads.
+ *
+ * The executor owns a QThreadPool (DB_POOL_SIZE threads, default 8) whose threads
+ * never expire, so every thread keeps its pooled PostgreSQL connection
+ * (DbManager::getPostgresConnection names connections per thread).
+ *
+ * Handlers take a crow::response& (asynchronous Crow handler), copy what they need
+ * from the request and hand the work over. The response is completed from the
+ * executor thread; the Crow worker is free for other requests in the meantime.
+ *
+ * Requests are admitted only while fewer than DB_QUEUE_MAX jobs (default 1024,
+ * 0 = unlimited) are queued or running; beyond that respond() answers 503 with
+ * Retry-After: 1 right away instead of letting the queue and its latency grow.
+ */
+class DbExecutor {
+public:
+    /**
+     * @brief Queues a job on the DB threads.
+     *
+     * @param job The work to execute.
+     */
+    static void submit(std::function<void()> job);
+
+    /**
+     * @brief Executes 'work' on a DB thread and completes 'res' with its result.
+     *
+     * Status, body and headers of the built response are moved into 'res';
+     * headers already set on 'res' (Content-Type, CORS, ...) are kept unless the
+     * built response sets the same header. Exceptions thrown by 'work' are
+     * turned into a 500 response; with DB_QUEUE_MAX jobs pending, 'res' is
+     * completed with 503 without running 'work'.
+     *
+     * @param res The (pending) response of an asynchronous Crow handler.
+     * @param work Builds the response; runs on a DB thread.
+     */
+    static void respond(crow::response& res, std::function<crow::response()> work);
+
+    /**
+     * @brief Like respond(), recording the stages "queue" (waiting for a DB thread)
+     *        and "db" (running 'work') in a trace, which is finished on the response.
+     *
+     * @param res The (pending) response of an asynchronous Crow handler.
+     * @param trace The request trace (Server-Timing header / OTLP spans).
+     * @param work Builds the response; runs on a DB thread.
+     */
+    static void respond(crow::response& res, std::shared_ptr<RequestTrace> trace,
+                        std::function<crow::response()> work);
+
+    /**
+     * @brief Number of jobs queued or running.
+     *
+     * @return The number of pending jobs.
+     */
+    static int pending();
+
+    /**
+     * @brief Number of DB threads.
+     *
+     * @return The pool size.
+     */
+    static int threadCount();
+
+    /**
+     * @brief Number of DB threads currently running a job.
+     *
+     * @return Busy threads (each holds its PostgreSQL connection).
+     */
+    static int activeThreads();
+};
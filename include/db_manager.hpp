@@ -3,10 +3,12 @@
 #include <string>
 #include <QSqlDatabase>
 #include <QString>
+#include <QStringList>
 #include <QDateTime>
 #include "metadata_extractor.hpp"
 #include <QFile>
 #include <vector>
+#include <optional>
 
 /**
  * @brief Structure for the Worker Payload.
@@ -32,6 +34,34 @@ struct PhotoUpdateData {
     std::vector<std::string> keywords; ///< New list of keywords.
 };
 
+/**
+ * @brief Selection of photos for batch operations (ID list or folder subtree).
+ */
+struct PhotoSelection {
+    std::vector<int> ids; ///< Explicit photo IDs (used if pathPrefix is empty).
+    std::string pathPrefix; ///< Folder; selects it and all subfolders.
+};
+
+/**
+ * @brief Structure for Batch Photo Updates (unset members stay unchanged).
+ */
+struct BatchUpdateData {
+    std::optional<std::string> title; ///< New title for all photos.
+    std::optional<std::string> description; ///< New description for all photos.
+    std::vector<std::string> addKeywords; ///< Keywords to link.
+    std::vector<std::string> removeKeywords; ///< Keywords to unlink.
+};
+
+/**
+ * @brief Summary of a batch operation.
+ */
+struct BatchResult {
+    bool ok = false; ///< Transaction committed.
+    int matched = 0; ///< Number of selected photos.
+    int keywordsAdded = 0; ///< Newly created photo/keyword links.
+    int keywordsRemoved = 0; ///< Removed photo/keyword links.
+};
+
 /**
  * @brief Structure for User Data.
  * 
@@ -57,6 +87,29 @@ public:
      */
     static void initAuthDatabase();
 
+    /**
+     * @brief Adds the server-maintained extensions to the PostgreSQL schema.
+     * 
+     * Idempotent: full-text search column, function and GIN index (incl. backfill),
+     * timeline aggregate table (incl. backfill), GiST index on the GPS position.
+     */
+    static void initGalleryDatabase();
+
+    /**
+     * @brief Loads all pictures into the in-memory facet index (see FacetIndex).
+     */
+    static void loadFacetIndex();
+
+    /**
+     * @brief Loads all keyword tags and their usage into the autocomplete index (see KeywordIndex).
+     */
+    static void loadKeywordIndex();
+
+    /**
+     * @brief Loads the GPS positions of all pictures into the map index (see GeoIndex).
+     */
+    static void loadGeoIndex();
+
     /**
      * @brief Returns a NEW connection to the PostgreSQL database (for Gallery/Uploads).
      * 
@@ -64,12 +117,31 @@ public:
      */
     static QSqlDatabase getPostgresConnection();
 
+    /**
+     * @brief Returns a connection for read-only queries.
+     * 
+     * Uses a healthy read replica (PG_REPLICA_HOSTS) unless the folder was written
+     * recently (read-your-writes) or no replica is available; then the primary.
+     * 
+     * @param path Folder the query reads ("" = root).
+     * @return QSqlDatabase of a replica or the primary.
+     */
+    static QSqlDatabase getReadConnection(const QString& path = QString());
+
+    /**
+     * @brief Measures reachability and replication lag of all replicas.
+     * 
+     * Called periodically from the main thread (see main.cpp).
+     */
+    static void checkReplicaHealth();
+
     /**
      * @brief Verifies the user credentials.
      * 
      * @param username The username to verify.
      * @param password The password to verify.
      * @return true if credentials are valid, false otherwise.
+     * @throws PasswordHasher::Overloaded if the bcrypt queue is full.
      */
     static bool verifyUser(const std::string& username, const std::string& password);
 
@@ -96,6 +168,15 @@ public:
      */
     static void revokeRefreshToken(const std::string& token);
 
+    /**
+     * @brief Deletes all expired refresh tokens (DB and cache).
+     *
+     * Called periodically by the token sweeper in main().
+     *
+     * @return Number of deleted rows.
+     */
+    static int purgeExpiredRefreshTokens();
+
     /**
      * @brief Inserts a photo and its metadata into the database.
      * 
@@ -121,6 +202,25 @@ public:
      */
     static bool deletePhoto(int id);
 
+    /**
+     * @brief Updates title/description/keywords of many photos in one transaction.
+     * 
+     * Set-based: one statement per kind of change, independent of the number of photos.
+     * 
+     * @param selection The photos.
+     * @param data The changes.
+     * @return Summary (ok = false if the transaction was rolled back).
+     */
+    static BatchResult batchUpdatePhotos(const PhotoSelection& selection, const BatchUpdateData& data);
+
+    /**
+     * @brief Deletes many photos with one statement; files are removed in the background.
+     * 
+     * @param selection The photos.
+     * @return Summary (matched = number of deleted photos).
+     */
+    static BatchResult deletePhotos(const PhotoSelection& selection);
+
     // User Management (SQLite)
     /**
      * @brief Gets all users from the database.
@@ -144,6 +244,7 @@ public:
      * @param username The username.
      * @param password The password.
      * @return true if creation was successful, false otherwise.
+     * @throws PasswordHasher::Overloaded if the bcrypt queue is full.
      */
     static bool createUser(const std::string& username, const std::string& password);
     /**
@@ -170,6 +271,7 @@ public:
      * @param newTempPassword 
      * @return true 
      * @return false 
+     * @throws PasswordHasher::Overloaded if the bcrypt queue is full.
      */
      static bool adminResetPassword(int id, const std::string& newTempPassword);
 
@@ -182,6 +284,7 @@ public:
      * @param oldPass 
      * @param newPass 
      * @return int 
+     * @throws PasswordHasher::Overloaded if the bcrypt queue is full.
      */
     static int changeOwnPassword(const std::string& username, const std::string& oldPass, const std::string& newPass);
 
@@ -194,7 +297,15 @@ public:
     */
     static bool updateUserStatus(int id, bool active);
 
-
+    /**
+     * @brief LIKE pattern matching everything below a folder ("2024/Trip" -> "2024/Trip/%").
+     * 
+     * %, _ and \ in the folder are escaped; use the pattern with ESCAPE '\'.
+     * 
+     * @param folder The folder (without trailing slash).
+     * @return The pattern.
+     */
+    static QString subfolderPattern(const QString& folder);
 
 private:
     /**
@@ -213,6 +324,42 @@ private:
      * @return The ID of the keyword.
      */
     static int getOrCreateKeywordId(QSqlDatabase& db, const QString& tag);
+
+    /**
+     * @brief Decrements the timeline aggregate for pictures that are about to be deleted.
+     * 
+     * @param db The database connection (inside the caller's transaction).
+     * @param idArray PostgreSQL array literal of picture IDs, e.g. "{1,2,3}".
+     * @return true on success.
+     */
+    static bool removeFromTimeline(QSqlDatabase& db, const QString& idArray);
+
+    /**
+     * @brief Resolves and locks (FOR UPDATE) the photos of a selection.
+     * 
+     * @param db The database connection (inside the caller's transaction).
+     * @param selection The photos.
+     * @param ok Set to false on SQL errors.
+     * @return (ID, folder) of every selected photo.
+     */
+    static std::vector<std::pair<int, QString>> selectPhotos(QSqlDatabase& db, const PhotoSelection& selection, bool& ok);
+
+    /**
+     * @brief Returns the keyword tags linked to a picture.
+     * 
+     * @param db The database connection.
+     * @param pictureId The ID of the picture.
+     * @return The tags.
+     */
+    static QStringList keywordsOf(QSqlDatabase& db, qint64 pictureId);
+
+    /**
+     * @brief Recomputes the full-text search vector of a picture.
+     * 
+     * @param db The database connection (inside the caller's transaction).
+     * @param pictureId The ID of the picture.
+     */
+    static void refreshSearchVector(QSqlDatabase& db, qint64 pictureId);
     
     static const QString SQLITE_DB_FILENAME; ///< Filename for the SQLite database.
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Removal of deleted photos: original into the trash, WebP versions deferred.
+ *
+ * After the DB change is committed, the original is moved into TRASH_DIR
+ * (default "Trash", a rename on the same filesystem) right away, so a photo
+ * uploaded again under the same name is never caught by the deletion. Only the
+ * WebP versions are removed later by a background worker, in batches
+ * (DELETE_BATCH_SIZE, default 200) with one directory listing per folder; it
+ * skips files that exist again and versions written after the file's own
+ * deletion. Versions still being generated when the photo is deleted are
+ * removed by the generation job itself once it sees the original is gone.
+ * Trash entries older than TRASH_GRACE_HOURS (default 72) are purged; 0
+ * disables the trash and deletes originals. Until then an admin can restore them.
+ *
+ * Trash layout: TRASH_DIR/<deletion batch timestamp>/<original path>.
+ */
+class DeletionQueue {
+public:
+    /**
+     * @brief A file in the trash.
+     */
+    struct TrashEntry {
+        QString id; ///< "<batch>/<original path>", used for restore.
+        QString originalPath; ///< Path the file had before deletion.
+        QDateTime deletedAt; ///< When it was moved to the trash.
+        QDateTime expiresAt; ///< When it will be purged.
+        qint64 size = 0; ///< File size in bytes.
+    };
+
+    /**
+     * @brief Starts the background worker (call once from main()).
+     */
+    static void start();
+
+    /**
+     * @brief Moves the originals of deleted photos into the trash and queues
+     *        the removal of their WebP versions.
+     *
+     * @param fullPaths Paths of the originals (as stored in pictures.full_path).
+     */
+    static void remove(const QStringList& fullPaths);
+
+    /**
+     * @brief Number of files whose WebP versions wait for the worker.
+     */
+    static int pending();
+
+    /**
+     * @brief Lists the files in the trash (newest first).
+     */
+    static std::vector<TrashEntry> trash();
+
+    /**
+     * @brief Moves a file from the trash back to its original path.
+     *
+     * The photo has to be re-ingested by the caller (metadata, WebP, DB row).
+     *
+     * @param id The TrashEntry::id.
+     * @return The original path, or std::nullopt if the entry does not exist or
+     *         the original path is occupied.
+     */
+    static std::optional<QString> restore(const QString& id);
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Reload-on-change for directories loaded into memory (static/, templates/).
+ *
+ * Watches a directory tree with QFileSystemWatcher (inotify) and calls a reload
+ * function once the changes have settled: directories report added / removed
+ * files, files report in-place changes. After each reload the tree is watched
+ * again, because editors and deployments often replace files (new inode, the
+ * old watch is gone).
+ */
+class DirectoryWatcher {
+public:
+    /**
+     * @brief Starts watching; the watcher lives as long as the application.
+     *
+     * Must be called from the thread running the Qt event loop, which is also
+     * the thread 'reload' runs on.
+     *
+     * @param dir The directory.
+     * @param debounceMs Quiet time after the last change before reloading.
+     * @param reload Called after changes.
+     */
+    static void watch(const QString& dir, int debounceMs, std::function<void()> reload);
+};
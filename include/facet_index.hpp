@@ -0,0 +1,148 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief In-memory facet index over all pictures (camera, country, city, year, keyword).
+ *
+ * For every facet value a RoaringBitmap of picture IDs is kept, plus one bitmap per
+ * folder. Filters are answered by intersecting bitmaps, counts by intersection
+ * cardinalities, so no SQL joins are needed per click. The index is loaded once at
+ * startup (DbManager::loadFacetIndex) and kept current by insertPhoto,
+ * updatePhotoMetadata and deletePhoto after their commit.
+ *
+ * Thread-safe (one std::shared_mutex; readers run in parallel).
+ */
+class FacetIndex {
+public:
+    /**
+     * @brief The indexed facets.
+     */
+    enum Facet { Camera, Country, City, Year, Keyword, FacetCount };
+
+    /**
+     * @brief Facet values of one picture.
+     */
+    struct PhotoFacets {
+        QString folder; ///< Relative folder path (pictures.file_path).
+        qint64 sortKey = 0; ///< file_datetime in ms (listing order).
+        QString camera; ///< meta_exif.model.
+        QString country; ///< meta_location.country.
+        QString city; ///< meta_location.city.
+        int year = 0; ///< Year of file_datetime (0 = unknown).
+        QStringList keywords; ///< Keyword tags.
+    };
+
+    /**
+     * @brief Active filter (empty members are ignored, keywords are AND-combined).
+     */
+    struct Filter {
+        std::array<QString, Keyword> values; ///< Camera, Country, City, Year.
+        QStringList keywords; ///< All of these keywords.
+
+        bool isEmpty() const;
+    };
+
+    /**
+     * @brief One page of matching pictures.
+     */
+    struct Page {
+        std::vector<std::uint32_t> ids; ///< IDs in listing order (newest first).
+        std::uint64_t total = 0; ///< Number of matches over all pages.
+    };
+
+    /**
+     * @brief A facet value and the number of matching pictures.
+     */
+    struct Count {
+        QString value;
+        std::uint64_t count = 0;
+    };
+
+    using Counts = std::array<std::vector<Count>, FacetCount>;
+
+    /**
+     * @brief Replaces the whole index (startup).
+     *
+     * @param photos All pictures with their facet values.
+     */
+    static void rebuild(const std::vector<std::pair<std::uint32_t, PhotoFacets>>& photos);
+
+    /**
+     * @brief Adds or replaces a picture.
+     *
+     * @param id The picture ID.
+     * @param facets Its facet values.
+     */
+    static void put(std::uint32_t id, const PhotoFacets& facets);
+
+    /**
+     * @brief Replaces the keywords of a picture.
+     *
+     * @param id The picture ID.
+     * @param keywords The new keyword tags.
+     */
+    static void setKeywords(std::uint32_t id, const QStringList& keywords);
+
+    /**
+     * @brief Applies added / removed keyword links (batch updates).
+     *
+     * @param added (picture ID, tag) links that were created.
+     * @param removed (picture ID, tag) links that were deleted.
+     */
+    static void applyKeywordChanges(const std::vector<std::pair<std::uint32_t, QString>>& added,
+                                    const std::vector<std::pair<std::uint32_t, QString>>& removed);
+
+    /**
+     * @brief Removes a picture.
+     *
+     * @param id The picture ID.
+     */
+    static void remove(std::uint32_t id);
+
+    /**
+     * @brief Whether the index has been loaded.
+     */
+    static bool isReady();
+
+    /**
+     * @brief Number of indexed pictures.
+     */
+    static std::size_t size();
+
+    /**
+     * @brief Returns one page of matches, ordered like the gallery listing.
+     *
+     * @param filter The active filter.
+     * @param folder Restrict to this folder (std::nullopt = whole library).
+     * @param offset Number of matches to skip.
+     * @param limit Page size.
+     * @param before Only pictures older than this sort key (timeline seek, ms).
+     * @return The page.
+     */
+    static Page page(const Filter& filter, const std::optional<QString>& folder, int offset, int limit,
+                     std::optional<qint64> before = std::nullopt);
+
+    /**
+     * @brief Counts per facet value for the current filter.
+     *
+     * Counts for a single-valued facet ignore that facet's own filter, so the
+     * alternatives stay visible; keyword counts honour all filters (drill-down).
+     *
+     * @param filter The active filter.
+     * @param folder Restrict to this folder (std::nullopt = whole library).
+     * @param limit Maximum number of values per facet (highest counts first).
+     * @param total Receives the number of pictures matching the full filter.
+     * @return Counts for every facet.
+     */
+    static Counts counts(const Filter& filter, const std::optional<QString>& folder, int limit, std::uint64_t& total);
+
+    /**
+     * @brief JSON / URL parameter name of a facet ("camera", "country", ...).
+     */
+    static const char* name(Facet facet);
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/**
+ * @brief In-process LRU cache of serialized /api/gallery responses.
+ *
+ * Every folder has a version counter. A write to a folder (insertPhoto,
+ * updatePhotoMetadata, deletePhoto, batch operations) bumps the counter of the
+ * folder and of all parent folders, since their listings contain the subfolder.
+ * Cached entries remember the version they were built for; an entry whose
+ * version is no longer current is never served. The ETag of a listing is derived
+ * from the folder version, so If-None-Match can be answered without the database.
+ *
+ * The cache is bounded by GALLERY_CACHE_MB (default 64; 0 disables storing,
+ * ETags still work). Thread-safe (one mutex).
+ */
+class GalleryCache {
+public:
+    /**
+     * @brief A cached response.
+     */
+    struct Entry {
+        std::string body; ///< Serialized JSON.
+        std::string totalCount; ///< X-Total-Count header (empty = none).
+    };
+
+    /**
+     * @brief Cache counters for /system/stats.
+     */
+    struct Stats {
+        std::uint64_t hits = 0; ///< Responses served from the cache.
+        std::uint64_t misses = 0; ///< Responses built from the database.
+        std::uint64_t notModified = 0; ///< 304 answers.
+        std::size_t entries = 0; ///< Cached responses.
+        std::size_t bytes = 0; ///< Size of the cached bodies.
+    };
+
+    /**
+     * @brief Current version of a folder.
+     *
+     * @param folder Relative folder path ("" = root).
+     */
+    static std::uint64_t version(const QString& folder);
+
+    /**
+     * @brief ETag of a listing (quoted, ready for the header).
+     *
+     * @param key The cache key of the request.
+     * @param version The folder version the response belongs to.
+     */
+    static std::string etag(const std::string& key, std::uint64_t version);
+
+    /**
+     * @brief Checks an If-None-Match header against an ETag (counts 304s).
+     *
+     * @param ifNoneMatch The header value (may list several tags or be "*").
+     * @param etag The current ETag.
+     */
+    static bool notModified(const std::string& ifNoneMatch, const std::string& etag);
+
+    /**
+     * @brief Looks up a response built for the given version.
+     *
+     * @param key The cache key.
+     * @param version The current folder version.
+     * @return The entry, or std::nullopt on a miss.
+     */
+    static std::optional<Entry> get(const std::string& key, std::uint64_t version);
+
+    /**
+     * @brief Stores a response.
+     *
+     * @param key The cache key.
+     * @param version The folder version read before the response was built.
+     * @param entry The response.
+     */
+    static void put(const std::string& key, std::uint64_t version, Entry entry);
+
+    /**
+     * @brief Invalidates the listings of a folder and of all its parents.
+     *
+     * Called after the write is committed and the in-memory indexes are updated.
+     *
+     * @param folder Relative folder path ("" = root).
+     */
+    static void invalidate(const QString& folder);
+
+    /**
+     * @brief Returns the cache counters.
+     */
+    static Stats stats();
+};
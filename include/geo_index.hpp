@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief In-memory grid aggregation of all geotagged pictures for map clustering.
+ *
+ * For every zoom level 0..MAX_ZOOM the world is divided into a lat/lon grid of
+ * 2^(zoom+2) x 2^(zoom+2) cells (about four clusters per map tile). Each occupied
+ * cell stores its photo count, the coordinate sums (-> centroid) and one
+ * representative photo. Cluster queries only visit the cells of the bounding box.
+ * Above MAX_ZOOM the map shows single photos, which are queried from PostgreSQL
+ * (GiST index on meta_exif, see DbManager::initGalleryDatabase).
+ *
+ * Loaded at startup (DbManager::loadGeoIndex), kept current by insertPhoto and
+ * deletePhoto. Thread-safe (std::shared_mutex).
+ */
+class GeoIndex {
+public:
+    static constexpr int MAX_ZOOM = 8; ///< Highest zoom level answered with clusters.
+
+    /**
+     * @brief Bounding box in degrees (west > east crosses the antimeridian).
+     */
+    struct BBox {
+        double west = -180.0;
+        double south = -90.0;
+        double east = 180.0;
+        double north = 90.0;
+    };
+
+    /**
+     * @brief A cluster of photos.
+     */
+    struct Cluster {
+        double lat = 0.0; ///< Centroid latitude.
+        double lon = 0.0; ///< Centroid longitude.
+        std::uint32_t count = 0; ///< Number of photos.
+        std::uint32_t representative = 0; ///< ID of one photo of the cluster.
+    };
+
+    /**
+     * @brief Checks whether a coordinate is a real GPS position (0/0 = not geotagged).
+     */
+    static bool isValid(double lat, double lon);
+
+    /**
+     * @brief Replaces the whole index (startup).
+     *
+     * @param photos (picture ID, (latitude, longitude)) of all geotagged pictures.
+     */
+    static void rebuild(const std::vector<std::pair<std::uint32_t, std::pair<double, double>>>& photos);
+
+    /**
+     * @brief Adds a picture (ignored if the position is not valid).
+     *
+     * @param id The picture ID.
+     * @param lat Latitude.
+     * @param lon Longitude.
+     */
+    static void add(std::uint32_t id, double lat, double lon);
+
+    /**
+     * @brief Removes a picture.
+     *
+     * @param id The picture ID.
+     */
+    static void remove(std::uint32_t id);
+
+    /**
+     * @brief Returns the clusters inside a bounding box.
+     *
+     * @param box The visible area.
+     * @param zoom Map zoom level (clamped to 0..MAX_ZOOM).
+     * @return Clusters of the occupied cells.
+     */
+    static std::vector<Cluster> clusters(const BBox& box, int zoom);
+
+    /**
+     * @brief Number of indexed pictures.
+     */
+    static std::size_t size();
+};
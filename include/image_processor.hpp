@@ -1,5 +1,8 @@
 #pragma once
+#include <QDateTime>
+#include <QHash>
 #include <QString>
+#include <QStringList>
 #include <vector>
 
 /**
@@ -17,6 +20,23 @@ public:
      */
     static void generateWebPVersions(const QString& sourcePath, const QString& parentDir);
 
+    /**
+     * @brief Runs generateWebPVersions() in the background (global QThreadPool).
+     * 
+     * Tracks the queue depth and the processing time (see Metrics). When the job
+     * ends, the gallery cache of the folder is invalidated so listings pick up the
+     * new versions in their srcset.
+     * 
+     * @param sourcePath The path to the original image.
+     * @param parentDir The directory where the 'webp' folder should be created.
+     */
+    static void enqueueWebPVersions(const QString& sourcePath, const QString& parentDir);
+
+    /**
+     * @brief Number of queued or running background WebP jobs.
+     */
+    static int pendingJobs();
+
     /**
      * @brief Deletes all generated WebP versions for a file.
      * 
@@ -24,6 +44,31 @@ public:
      */
     static void deleteAllVersions(const QString& sourcePath);
 
-private:
-    static const std::vector<int> TARGET_WIDTHS; ///< List of target widths for resizing.
+    /**
+     * @brief Deletes the WebP versions of many files (one directory listing per folder).
+     * 
+     * @param cutoffs Source path -> deletion time of that file. Versions modified
+     *                later are kept (they belong to a file uploaded again under
+     *                the same name in the meantime); an invalid time removes all.
+     */
+    static void deleteAllVersions(const QHash<QString, QDateTime>& cutoffs);
+
+    /**
+     * @brief File name of a WebP version inside the 'webp' folder.
+     * 
+     * @param baseName File name of the original without extension ("Vacation_01").
+     * @param width Target width.
+     * @return e.g. "Vacation_01_800.webp".
+     */
+    static QString versionFileName(const QString& baseName, int width);
+
+    /**
+     * @brief Widths of the WebP versions generated for an original (no upscaling).
+     * 
+     * @param originalWidth Width of the original in pixels.
+     * @return The target widths smaller than the original, ascending.
+     */
+    static std::vector<int> versionWidths(int originalWidth);
+
+    static const std::vector<int> TARGET_WIDTHS; ///< List of target widths for resizing (ascending).
 };
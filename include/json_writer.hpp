@@ -0,0 +1,91 @@
+#pragma once
+#include <QString>
+#include <QStringView>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Streaming JSON writer for large listings.
+ *
+ * Appends escaped output directly to one pre-reserved std::string while the
+ * caller iterates its query, instead of building a crow::json::wvalue per row.
+ * QStrings are encoded from UTF-16 straight into the buffer (no intermediate
+ * std::string). Commas are inserted automatically; the caller is responsible for
+ * a well-formed nesting of begin/end calls and for calling key() inside objects.
+ *
+ * @code
+ * JsonWriter w;
+ * w.beginArray();
+ * w.beginObject().key("id").value(1).key("name").value(name).endObject();
+ * w.endArray();
+ * return crow::response(w.take());
+ * @endcode
+ */
+class JsonWriter {
+public:
+    /**
+     * @brief Creates a writer.
+     *
+     * @param reserveBytes Initial buffer capacity.
+     */
+    explicit JsonWriter(std::size_t reserveBytes = 16 * 1024);
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    /**
+     * @brief Writes an object key (the next call has to write its value).
+     */
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(QStringView s);
+    JsonWriter& value(const QString& s) { return value(QStringView(s)); }
+    JsonWriter& value(std::string_view s);
+    JsonWriter& value(const char* s) { return value(std::string_view(s)); }
+    template <typename T>
+        requires(std::is_integral_v<T> && !std::is_same_v<T, bool>)
+    JsonWriter& value(T v) {
+        if constexpr (std::is_signed_v<T>) return integer(static_cast<std::int64_t>(v));
+        else return unsignedInteger(static_cast<std::uint64_t>(v));
+    }
+    JsonWriter& value(double v); ///< Non-finite values are written as null.
+    JsonWriter& value(bool v);
+    JsonWriter& null();
+
+    /**
+     * @brief Appends an already serialized JSON value as is.
+     */
+    JsonWriter& raw(std::string_view json);
+
+    /**
+     * @brief Current output size in bytes.
+     */
+    std::size_t size() const { return out.size(); }
+
+    /**
+     * @brief Read access to the output written so far.
+     */
+    const std::string& str() const { return out; }
+
+    /**
+     * @brief Moves the output out of the writer (the writer is empty afterwards).
+     */
+    std::string take();
+
+private:
+    void separator();
+    JsonWriter& integer(std::int64_t v);
+    JsonWriter& unsignedInteger(std::uint64_t v);
+    void appendEscaped(QStringView s);
+    void appendEscaped(std::string_view s);
+
+    std::string out; ///< Output buffer.
+    std::vector<bool> hasItems; ///< Per open container: an element was written.
+    bool afterKey = false; ///< A key was written, its value follows (no comma).
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief In-memory prefix index of all keyword tags for autocomplete.
+ *
+ * Tags are kept in one array sorted by their case-folded form, so all tags with a
+ * given prefix form a contiguous range (found with a binary search). Each tag
+ * carries its usage count (number of linked pictures); suggestions are the most
+ * used tags of the range.
+ *
+ * Loaded at startup (DbManager::loadKeywordIndex). The photo writers adjust the
+ * usage counts (registering new tags) only after their commit succeeded. Thread-safe (std::shared_mutex).
+ */
+class KeywordIndex {
+public:
+    /**
+     * @brief A suggested tag.
+     */
+    struct Suggestion {
+        QString tag; ///< The tag as stored in the database.
+        std::uint32_t usage = 0; ///< Number of pictures using it.
+    };
+
+    /**
+     * @brief Replaces the whole index (startup).
+     *
+     * @param tags All tags with their usage counts.
+     */
+    static void rebuild(const std::vector<std::pair<QString, std::uint32_t>>& tags);
+
+    /**
+     * @brief Changes the usage count of a tag.
+     *
+     * @param tag The tag (registered if unknown).
+     * @param delta Number of added (positive) or removed (negative) links.
+     */
+    static void adjustUsage(const QString& tag, int delta);
+
+    /**
+     * @brief Returns the most used tags starting with a prefix (case-insensitive).
+     *
+     * @param prefix The typed prefix ("" = most used tags overall).
+     * @param limit Maximum number of suggestions.
+     * @return Suggestions, highest usage first.
+     */
+    static std::vector<Suggestion> suggest(const QString& prefix, int limit);
+
+    /**
+     * @brief Number of indexed tags.
+     */
+    static std::size_t size();
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include <QDebug>
+
+#include <atomic>
+#include <cstdint>
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0 ///< Compile-time minimum (0 debug, 1 info, 2 warning, 3 critical), set via CMake.
+#endif
+
+/**
+ * @brief Asynchronous structured logging behind qDebug / qInfo / qWarning / qCritical.
+ *
+ * start() installs a Qt message handler: every thread writes its records into
+ * its own lock-free single-producer ring (LOG_RING_SIZE slots, default 1024),
+ * one background thread drains all rings and writes them as JSON lines
+ * ({"ts", "level", "thread", "category", "msg", "file", "line", "function"})
+ * to stderr. Logging never waits for stderr: if a ring is full the record is
+ * dropped and counted (log_messages_dropped_total on /metrics).
+ *
+ * Levels are filtered twice:
+ * - at compile time (CMake option LOG_MIN_LEVEL): the LOG_DEBUG .. LOG_CRITICAL
+ *   macros below that level compile to nothing, their arguments are not evaluated;
+ * - at run time (environment LOG_LEVEL=debug|info|warning|critical, default info):
+ *   the macros check the level before anything is formatted, records of plain
+ *   q* calls are discarded in the handler.
+ *
+ * Hot paths use the macros, they stream like qDebug():
+ * @code
+ * LOG_DEBUG << "DB Insert success for ID:" << picId;
+ * @endcode
+ *
+ * Fatal messages and records after stop() are written synchronously.
+ */
+class Logger {
+public:
+    enum Level : int { Debug = 0, Info = 1, Warning = 2, Critical = 3 };
+
+    /**
+     * @brief Reads LOG_LEVEL, starts the writer thread and installs the message handler.
+     */
+    static void start();
+
+    /**
+     * @brief Writes all queued records and stops the writer thread (idempotent).
+     *
+     * Registered with std::atexit by start().
+     */
+    static void stop();
+
+    /**
+     * @brief Runtime filter: should a record of this level be produced?
+     *
+     * @param level The level.
+     */
+    static bool enabled(Level level) { return level >= minLevel.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Number of records dropped because a ring was full.
+     */
+    static std::uint64_t dropped();
+
+private:
+    static std::atomic<int> minLevel; ///< Runtime level (LOG_LEVEL).
+};
+
+// "if (...) {} else qDebug()" keeps the streaming syntax and skips the formatting;
+// the constant first operand lets the compiler drop the statement entirely.
+#define LOG_AT(level, stream) \
+    if ((level) < LOG_MIN_LEVEL || !Logger::enabled(level)) {} else stream()
+
+#define LOG_DEBUG LOG_AT(Logger::Debug, qDebug)
+#define LOG_INFO LOG_AT(Logger::Info, qInfo)
+#define LOG_WARNING LOG_AT(Logger::Warning, qWarning)
+#define LOG_CRITICAL LOG_AT(Logger::Critical, qCritical)
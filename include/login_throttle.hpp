@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+
+/**
+ * @brief Token bucket throttling for /login.
+ *
+ * Every login attempt takes one token from the bucket of the client IP and one from
+ * the bucket of the submitted username (kept in a lock-free RateLimiter table).
+ * Buckets refill continuously:
+ *  - per IP:   LOGIN_IP_BURST (default 10) tokens, LOGIN_IP_PER_MINUTE (default 10) per minute
+ *  - per user: LOGIN_USER_BURST (default 5) tokens, LOGIN_USER_PER_MINUTE (default 5) per minute
+ */
+class LoginThrottle {
+public:
+    /**
+     * @brief Checks (and consumes) a login attempt.
+     *
+     * @param ip The client IP address.
+     * @param username The submitted username.
+     * @param retryAfterSeconds Set to the wait time if the attempt is rejected.
+     * @return true if the attempt may proceed, false if it is throttled.
+     */
+    static bool allow(const std::string& ip, const std::string& username, int& retryAfterSeconds);
+};
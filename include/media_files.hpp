@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Bounded cache of open file descriptors for the /media route.
+ *
+ * Hot files (thumbnails of the current page) are served with pread() from an
+ * already open descriptor instead of open()/close() per request. Every lookup
+ * stat()s the path and reopens the file if it was replaced or changed (inode,
+ * size or mtime differ), so uploads and deletions are picked up immediately.
+ *
+ * The cache holds MEDIA_FD_CACHE descriptors (default 256, LRU). Evicted files
+ * stay open until the last request using them has finished (shared_ptr).
+ * Thread-safe (one mutex).
+ */
+class MediaFiles {
+public:
+    /**
+     * @brief An open file and its stat() data.
+     */
+    struct File {
+        int fd = -1; ///< Read-only descriptor (closed by the destructor).
+        std::uint64_t size = 0; ///< Size in bytes.
+        std::uint64_t inode = 0; ///< Inode number.
+        timespec mtime{}; ///< Modification time.
+
+        File() = default;
+        File(const File&) = delete;
+        File& operator=(const File&) = delete;
+        ~File();
+
+        /**
+         * @brief Strong validator: inode, size and mtime (quoted).
+         */
+        std::string etag() const;
+
+        /**
+         * @brief Reads a byte range.
+         *
+         * @param offset First byte.
+         * @param length Number of bytes.
+         * @param out Receives the data.
+         * @return true if all bytes were read.
+         */
+        bool read(std::uint64_t offset, std::uint64_t length, std::string& out) const;
+    };
+
+    /**
+     * @brief Returns the open file for a path (from the cache or freshly opened).
+     *
+     * @param path Path of a regular file.
+     * @return The file, or nullptr if it does not exist or is not readable.
+     */
+    static std::shared_ptr<const File> open(const std::string& path);
+
+    /**
+     * @brief Directory served below /media/ (MEDIA_ROOT, default "Photos").
+     */
+    static const std::string& root();
+
+    /**
+     * @brief Number of cached descriptors.
+     */
+    static std::size_t cachedCount();
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include "crow.h"
+
+#include <QString>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/**
+ * @brief Issues the /media URLs of one response.
+ *
+ * With MEDIA_SIGNING=1 every URL is signed for one user (see MediaSigner); all
+ * URLs of a response share one expiry. Every response that hands out a media
+ * URL (gallery, search, map, upload, trash restore) builds it here.
+ */
+struct MediaLinks {
+    std::string user; ///< The user the URLs are issued to.
+    std::int64_t expires = 0; ///< 0 = unsigned URLs.
+
+    /**
+     * @brief URL of a file below the media root.
+     *
+     * @param relDir Folder below the media root ("" for the root).
+     * @param fileName The file name.
+     * @return "/media/<relDir>/<fileName>", with the signature query if signing is on.
+     */
+    QString url(const QString& relDir, const QString& fileName) const;
+
+    /**
+     * @brief Links for an already authenticated user (AuthMiddleware routes).
+     *
+     * @param user The username from the AuthMiddleware context.
+     */
+    static MediaLinks forUser(std::string user);
+
+    /**
+     * @brief Links for a request to a public route.
+     *
+     * @param req The request (bearer token checked only if signing is on).
+     * @return std::nullopt if signing is on and the request has no valid token.
+     */
+    static std::optional<MediaLinks> forRequest(const crow::request& req);
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Short-lived signed /media URLs.
+ *
+ * With MEDIA_SIGNING=1 every media URL the API returns (built by MediaLinks)
+ * carries "?exp=<unix time>&u=<user>&sig=<mac>", and /media only serves
+ * requests carrying a valid signature. The MAC is HMAC-SHA256 over (path, expiry, user), truncated
+ * to 128 bit and base64url encoded, so checking a thumbnail request is a single
+ * keyed hash: no JWT decoding, and <img> tags need no Authorization header.
+ *
+ * Expiry times are aligned to MEDIA_URL_TTL (seconds, default 3600): all URLs
+ * issued within one window share the same expiry and stay valid for at least
+ * one more window. URLs therefore remain identical (browser cache hits, stable
+ * gallery ETags) until the window changes.
+ *
+ * The key is MEDIA_SIGNING_KEY, or derived from JWT_SECRET if not set.
+ */
+class MediaSigner {
+public:
+    /**
+     * @brief Whether media URLs are signed and verified (MEDIA_SIGNING=1).
+     */
+    static bool enabled();
+
+    /**
+     * @brief Expiry for URLs issued now (end of the next TTL window).
+     *
+     * @return Unix time in seconds.
+     */
+    static std::int64_t expiry();
+
+    /**
+     * @brief Query string of a signed URL.
+     *
+     * @param relPath Path below the media root, not percent-encoded ("2024/Rome/IMG_1.jpg").
+     * @param user The user the URL is issued to.
+     * @param expires Expiry from expiry().
+     * @return "exp=...&u=...&sig=..." (without '?').
+     */
+    static std::string query(std::string_view relPath, std::string_view user, std::int64_t expires);
+
+    /**
+     * @brief Checks a signature and its expiry.
+     *
+     * @param relPath Decoded path below the media root.
+     * @param user Value of the 'u' parameter.
+     * @param expires Value of the 'exp' parameter.
+     * @param signature Value of the 'sig' parameter.
+     * @return true if the signature matches and has not expired.
+     */
+    static bool verify(std::string_view relPath, std::string_view user, std::int64_t expires,
+                       std::string_view signature);
+};
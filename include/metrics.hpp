@@ -0,0 +1,162 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Process-wide metrics in the Prometheus text format (GET /metrics).
+ *
+ * Counters and histograms are recorded without locks: every metric has
+ * SHARDS cache-line aligned slots of atomics, each thread increments "its"
+ * slot (relaxed), a scrape adds the slots up. Gauges are callbacks evaluated
+ * at scrape time (queue depths, pool usage, RSS).
+ *
+ * Metrics are registered by name + label set and live as long as the process;
+ * the returned references can be kept in function-local statics. Registration
+ * takes a mutex, so hot paths look a metric up once and keep the reference.
+ */
+class Metrics {
+public:
+    static constexpr std::size_t SHARDS = 16; ///< Slots per metric (threads share them round-robin).
+    static constexpr std::size_t MAX_BUCKETS = 24; ///< Upper bound for histogram buckets.
+
+    /**
+     * @brief Monotonic counter.
+     */
+    class Counter {
+    public:
+        /**
+         * @brief Adds n (default 1).
+         */
+        void inc(std::uint64_t n = 1);
+
+        /**
+         * @brief Sum over all shards.
+         */
+        std::uint64_t value() const;
+
+    private:
+        struct alignas(64) Slot {
+            std::atomic<std::uint64_t> value{0};
+        };
+        std::array<Slot, SHARDS> slots_;
+    };
+
+    /**
+     * @brief Histogram of durations (seconds) with fixed bucket bounds.
+     */
+    class Histogram {
+    public:
+        /**
+         * @param bounds Ascending upper bounds in seconds (at most MAX_BUCKETS).
+         */
+        explicit Histogram(std::vector<double> bounds);
+
+        /**
+         * @brief Records one observation.
+         *
+         * @param seconds The observed value.
+         */
+        void observe(double seconds);
+
+        /**
+         * @brief Merged view for the exposition format.
+         */
+        struct Snapshot {
+            std::vector<double> bounds; ///< Upper bounds (without +Inf).
+            std::vector<std::uint64_t> cumulative; ///< Per bound, last entry = +Inf = count.
+            double sum = 0; ///< Sum of all observations.
+        };
+
+        /**
+         * @brief Adds up all shards.
+         */
+        Snapshot snapshot() const;
+
+    private:
+        struct alignas(64) Slot {
+            std::array<std::atomic<std::uint64_t>, MAX_BUCKETS + 1> buckets{}; ///< Last = +Inf.
+            std::atomic<std::uint64_t> sumNanos{0};
+        };
+        std::vector<double> bounds_;
+        std::array<Slot, SHARDS> slots_;
+    };
+
+    /**
+     * @brief Measures the lifetime of a scope into a histogram.
+     */
+    class Timer {
+    public:
+        explicit Timer(Histogram& histogram) : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+        ~Timer() { histogram_.observe(elapsed()); }
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+        /**
+         * @brief Seconds since construction.
+         */
+        double elapsed() const {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+        }
+
+    private:
+        Histogram& histogram_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    /**
+     * @brief Default latency buckets (0.5 ms .. 10 s).
+     */
+    static const std::vector<double>& latencyBuckets();
+
+    /**
+     * @brief Returns (and registers on first use) a counter.
+     *
+     * @param name Metric name, e.g. "http_requests_total".
+     * @param help Description for the # HELP line.
+     * @param labels Label set from labels() (empty = none).
+     */
+    static Counter& counter(const std::string& name, const std::string& help, const std::string& labels = {});
+
+    /**
+     * @brief Returns (and registers on first use) a histogram.
+     *
+     * @param name Metric name, e.g. "http_request_duration_seconds".
+     * @param help Description for the # HELP line.
+     * @param labels Label set from labels() (empty = none).
+     * @param bounds Bucket bounds, used when the histogram is created.
+     */
+    static Histogram& histogram(const std::string& name, const std::string& help, const std::string& labels = {},
+                                const std::vector<double>& bounds = latencyBuckets());
+
+    /**
+     * @brief Registers a gauge read at scrape time.
+     *
+     * @param name Metric name.
+     * @param help Description for the # HELP line.
+     * @param read Returns the current value (called from the scraping thread).
+     * @param labels Label set from labels() (empty = none).
+     */
+    static void gauge(const std::string& name, const std::string& help, std::function<double()> read,
+                      const std::string& labels = {});
+
+    /**
+     * @brief Formats a label set: {{"route", "/api"}, {"method", "GET"}} -> route="/api",method="GET".
+     *
+     * Values are escaped (backslash, quote, newline).
+     */
+    static std::string labels(std::initializer_list<std::pair<std::string_view, std::string_view>> pairs);
+
+    /**
+     * @brief All metrics in the Prometheus text exposition format (version 0.0.4).
+     */
+    static std::string render();
+};
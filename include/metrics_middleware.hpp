@@ -0,0 +1,54 @@
+#pragma once
+#include "crow.h"
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Global middleware recording per-route request counts and latencies.
+ *
+ * Feeds http_requests_total{route,method,code} and
+ * http_request_duration_seconds{route,method} (see Metrics). Asynchronous
+ * handlers are measured until the response is completed on the DB executor.
+ *
+ * The route label is the registered route template the URL matches, with the
+ * parameters named ("/api/gallery/:id", "/media/:path"). URLs matching no
+ * route are counted as "unmatched" whatever their status, so the number of
+ * label sets stays bounded.
+ *
+ * Must be the first middleware of the App: its before_handle runs first and
+ * its after_handle last, so the measurement covers all other middlewares.
+ */
+struct MetricsMiddleware {
+    /**
+     * @brief Context structure for the middleware.
+     */
+    struct context {
+        std::chrono::steady_clock::time_point start; ///< Set by before_handle.
+    };
+
+    /**
+     * @brief Starts the measurement.
+     */
+    void before_handle(crow::request& /*req*/, crow::response& /*res*/, context& ctx) {
+        ctx.start = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * @brief Records count and duration of the finished request.
+     *
+     * @param req The request.
+     * @param res The response.
+     * @param ctx The middleware context.
+     */
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+
+    /**
+     * @brief Route label of a URL path ("/api/gallery/42" -> "/api/gallery/:id").
+     *
+     * @param path The URL path (without query).
+     * @return The label, or "unmatched" if no route template matches.
+     */
+    static std::string routeLabel(std::string_view path);
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Runs bcrypt hashing / verification on a dedicated, size-capped thread pool.
+ *
+ * bcrypt is expensive by design. Instead of burning Crow worker threads directly,
+ * every call is executed on its own QThreadPool (BCRYPT_THREADS) and the number of
+ * calls in flight (running + waiting) is capped by BCRYPT_QUEUE_LIMIT. When the cap
+ * is reached the call fails fast with PasswordHasher::Overloaded, so a burst of
+ * logins can only ever occupy a bounded number of request threads.
+ */
+class PasswordHasher {
+public:
+    /**
+     * @brief Thrown when the bcrypt queue is full.
+     */
+    struct Overloaded : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    /**
+     * @brief Generates a bcrypt hash.
+     *
+     * @param password The plain text password.
+     * @return The bcrypt hash.
+     * @throws Overloaded if the queue limit is reached.
+     */
+    static std::string hash(const std::string& password);
+
+    /**
+     * @brief Validates a password against a bcrypt hash.
+     *
+     * @param password The plain text password.
+     * @param hash The stored bcrypt hash.
+     * @return true if the password matches, false otherwise.
+     * @throws Overloaded if the queue limit is reached.
+     */
+    static bool verify(const std::string& password, const std::string& hash);
+
+    /**
+     * @brief Number of bcrypt calls currently running or waiting.
+     *
+     * @return The current queue depth.
+     */
+    static int queueDepth();
+};
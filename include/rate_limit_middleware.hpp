@@ -0,0 +1,61 @@
+#pragma once
+#include "crow.h"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Global middleware for request rate limiting.
+ *
+ * Every request takes tokens from the bucket of its client IP. Requests to
+ * protected routes additionally take tokens from the bucket of the user:
+ * the AuthMiddleware is a local middleware that runs at route dispatch, after
+ * all global ones, so it charges the user itself (chargeUser()) once the token
+ * is verified. The number of tokens depends on the route (an upload costs more
+ * than a listing). Rejected requests get 429 with a Retry-After header.
+ *
+ * Configuration (environment):
+ *  - RATE_LIMIT_ENABLED (default 1)
+ *  - RATE_LIMIT_IP_BURST / RATE_LIMIT_IP_PER_SECOND (default 120 / 20)
+ *  - RATE_LIMIT_USER_BURST / RATE_LIMIT_USER_PER_SECOND (default 240 / 40)
+ *  - RATE_LIMIT_SLOTS: number of tracked keys (default 65536)
+ */
+struct RateLimitMiddleware {
+    /**
+     * @brief Context structure for the middleware (unused).
+     */
+    struct context {};
+
+    /**
+     * @brief Executed before the request is handled: charges the IP bucket.
+     *
+     * @param req The incoming request.
+     * @param res The response (429 if the request is throttled).
+     * @param ctx The middleware context.
+     */
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+
+    /**
+     * @brief Executed after the request is handled.
+     */
+    void after_handle(crow::request& /*req*/, crow::response& /*res*/, context& /*ctx*/) {
+        // Nothing to do
+    }
+
+    /**
+     * @brief Number of requests rejected with 429 since startup.
+     *
+     * @return The rejected request count.
+     */
+    static std::uint64_t rejectedCount();
+
+    /**
+     * @brief Charges the bucket of an authenticated user (called by the AuthMiddleware).
+     *
+     * @param req The request (determines the cost).
+     * @param res The response, ended with 429 if the bucket is empty.
+     * @param user The verified username.
+     * @return false if the request was rejected.
+     */
+    static bool chargeUser(const crow::request& req, crow::response& res, const std::string& user);
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+/**
+ * @brief Lock-free table of token buckets.
+ *
+ * The table has a fixed number of slots (memory never grows). Slots are grouped into
+ * small sets (8 ways); a key hashes to one set. Each slot holds the key hash and a
+ * packed 64-bit state (last refill time | milli-tokens) which is updated with CAS.
+ * If a set is full, the way that was idle the longest is taken over by the new key
+ * (LRU eviction of idle keys). Under contention the accounting is approximate,
+ * which is fine for rate limiting.
+ */
+class RateLimiter {
+public:
+    /**
+     * @brief Bucket parameters.
+     */
+    struct Limit {
+        double burst; ///< Bucket capacity (tokens).
+        double perSecond; ///< Refill rate (tokens per second).
+    };
+
+    /**
+     * @brief Creates a table with (at least) the given number of slots.
+     *
+     * @param slots Number of buckets that can be tracked at the same time.
+     */
+    explicit RateLimiter(std::size_t slots);
+
+    /**
+     * @brief Takes 'cost' tokens from the bucket of 'key'.
+     *
+     * @param key The bucket key (e.g. "ip:1.2.3.4").
+     * @param cost Number of tokens to take.
+     * @param limit Capacity and refill rate of the bucket.
+     * @return 0 if the request is allowed, otherwise the seconds until enough tokens are available.
+     */
+    int consume(std::string_view key, double cost, const Limit& limit);
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> key{0};
+        std::atomic<std::uint64_t> state{0};
+    };
+
+    static constexpr std::size_t WAYS = 8; ///< Slots per set.
+
+    int consumeSlot(Slot& slot, std::uint32_t now, std::uint32_t cost, const Limit& limit);
+
+    std::size_t setCount;
+    std::unique_ptr<Slot[]> slots;
+};
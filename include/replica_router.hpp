@@ -0,0 +1,66 @@
+#pragma once
+#include <QString>
+#include <vector>
+
+/**
+ * @brief Routing state for PostgreSQL read replicas.
+ *
+ * Replicas are configured via PG_REPLICA_HOSTS ("host1,host2:5433", port defaults to
+ * PG_PORT). A periodic health check (DbManager::checkReplicaHealth) records whether a
+ * replica is reachable and how far it lags behind. Reads are spread round-robin over
+ * healthy replicas whose lag is below PG_REPLICA_MAX_LAG seconds (default 5).
+ *
+ * Read-your-writes: every write marks its folder (and all parent folders, since their
+ * listings contain the subfolder). Reads of a marked folder stay on the primary for
+ * PG_READ_AFTER_WRITE_MS (default 5000) plus the current replica lag.
+ */
+class ReplicaRouter {
+public:
+    /**
+     * @brief A configured replica endpoint and its health.
+     */
+    struct Replica {
+        QString host; ///< Hostname.
+        int port = 5432; ///< Port.
+        bool healthy = false; ///< Reachable and lag below the limit.
+        double lagSeconds = 0.0; ///< Last measured replication lag.
+    };
+
+    /**
+     * @brief Returns a snapshot of all configured replicas.
+     *
+     * @return The replicas (empty if PG_REPLICA_HOSTS is not set).
+     */
+    static std::vector<Replica> replicas();
+
+    /**
+     * @brief Picks a healthy replica (round-robin).
+     *
+     * @return Index of the replica, or -1 if reads must go to the primary.
+     */
+    static int pick();
+
+    /**
+     * @brief Records the result of a health check.
+     *
+     * @param index Index of the replica.
+     * @param reachable Whether the replica answered.
+     * @param lagSeconds Measured replication lag.
+     */
+    static void reportHealth(int index, bool reachable, double lagSeconds);
+
+    /**
+     * @brief Marks a folder (and its parents) as recently written.
+     *
+     * @param path Relative folder path ("" = root).
+     */
+    static void markWrite(const QString& path);
+
+    /**
+     * @brief Checks whether reads of a folder have to stay on the primary.
+     *
+     * @param path Relative folder path.
+     * @return true if the folder was written within the read-after-write window.
+     */
+    static bool recentlyWritten(const QString& path);
+};
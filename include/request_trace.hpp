@@ -0,0 +1,95 @@
+#pragma once
+#include "crow.h"
+#include "metrics.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Stage timings of one request: Server-Timing header and trace spans.
+ *
+ * A handler creates a trace, wraps its stages in scoped stage() spans and
+ * finally calls finish() on the response. The stages are reported in a
+ * Server-Timing header ("parse;dur=0.41, metadata;dur=3.20, total;dur=5.02",
+ * milliseconds) and, if TRACE_FILE is set, appended as one OTLP/JSON line
+ * (ExportTraceServiceRequest: one root span + one child span per stage) that
+ * an OpenTelemetry collector reads with its otlpjsonfile receiver.
+ *
+ * Durations are measured with steady_clock; the wall clock is read once per
+ * trace and only used for the OTLP timestamps. The OTLP lines are written by a
+ * background thread (at most TRACE_QUEUE_MAX lines queued, default 4096, more
+ * are dropped), so finish() never waits for the file.
+ *
+ * A trace may move between threads (Crow worker -> DB executor), stages are
+ * sequential. SERVER_TIMING=0 suppresses the header.
+ */
+class RequestTrace {
+public:
+    /**
+     * @brief Starts a trace.
+     *
+     * @param name Name of the root span, e.g. "POST /upload".
+     */
+    static std::shared_ptr<RequestTrace> start(std::string name);
+
+    /**
+     * @brief Scoped stage: measures from construction to destruction (or end()).
+     */
+    class Stage {
+    public:
+        Stage(RequestTrace& trace, const char* name, Metrics::Histogram* histogram);
+        ~Stage() { end(); }
+        Stage(const Stage&) = delete;
+        Stage& operator=(const Stage&) = delete;
+
+        /**
+         * @brief Ends the stage early (idempotent).
+         */
+        void end();
+
+    private:
+        RequestTrace* trace_;
+        const char* name_;
+        Metrics::Histogram* histogram_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    /**
+     * @brief Opens a stage.
+     *
+     * @param name Stage name (a string literal; Server-Timing token).
+     * @param histogram Optional histogram that additionally receives the duration.
+     */
+    Stage stage(const char* name, Metrics::Histogram* histogram = nullptr) { return Stage(*this, name, histogram); }
+
+    /**
+     * @brief Sets the Server-Timing header and exports the spans.
+     *
+     * Call once, right before the response is completed.
+     *
+     * @param res The response.
+     */
+    void finish(crow::response& res);
+
+private:
+    explicit RequestTrace(std::string name);
+
+    struct Span {
+        const char* name;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point end;
+    };
+
+    void add(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    std::string name_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::system_clock::time_point wallStart_; ///< Wall time of start_ (OTLP timestamps).
+    std::mutex mutex_;
+    std::vector<Span> spans_;
+    bool finished_ = false;
+};
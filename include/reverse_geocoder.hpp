@@ -0,0 +1,57 @@
+#pragma once
+#include <QString>
+#include <cstddef>
+#include <optional>
+
+/**
+ * @brief Offline reverse geocoding from a local GeoNames gazetteer.
+ *
+ * The places of GEONAMES_FILE (GeoNames "cities" dump, e.g. cities15000.txt) are
+ * loaded once at startup into a k-d tree over 3D unit vectors, so a nearest
+ * neighbour lookup is a few dozen distance computations and needs no external
+ * service. Optional files add readable names:
+ *  - GEONAMES_COUNTRY_INFO (countryInfo.txt): country code -> country name
+ *  - GEONAMES_ADMIN1 (admin1CodesASCII.txt): "CC.admin1" -> province/state
+ *
+ * Matches farther away than GEOCODER_MAX_KM (default 30) are ignored. The tree is
+ * immutable after load(), lookups need no locking.
+ */
+class ReverseGeocoder {
+public:
+    /**
+     * @brief Location resolved from a GPS position.
+     */
+    struct Place {
+        QString city; ///< Name of the nearest place.
+        QString province; ///< Admin1 name (empty if unknown).
+        QString country; ///< Country name (falls back to the code).
+        QString countryCode; ///< ISO 3166-1 alpha-2 code.
+    };
+
+    /**
+     * @brief Loads the gazetteer files configured in the environment.
+     *
+     * Does nothing if GEONAMES_FILE is not set.
+     */
+    static void load();
+
+    /**
+     * @brief Whether a gazetteer is loaded.
+     */
+    static bool isLoaded();
+
+    /**
+     * @brief Number of loaded places.
+     */
+    static std::size_t size();
+
+    /**
+     * @brief Finds the nearest place to a position.
+     *
+     * @param lat Latitude in degrees.
+     * @param lon Longitude in degrees.
+     * @return The place, or std::nullopt if nothing is loaded, the position is 0/0
+     *         or the nearest place is farther away than GEOCODER_MAX_KM.
+     */
+    static std::optional<Place> lookup(double lat, double lon);
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Compressed bitmap of 32-bit IDs (roaring layout).
+ *
+ * IDs are split into a 16-bit chunk key (high bits) and a 16-bit value (low bits).
+ * Each chunk is stored either as a sorted array of values (sparse, up to 4096
+ * entries) or as a 65536-bit bitset (dense), whichever is smaller. A bitset
+ * turns back into an array only below 3072 entries, so a chunk hovering around
+ * 4096 does not convert on every add/remove. Intersections and intersection
+ * counts work chunk by chunk and never materialize the IDs.
+ *
+ * Not thread-safe; the owner (FacetIndex) synchronizes access.
+ */
+class RoaringBitmap {
+public:
+    /**
+     * @brief Adds an ID.
+     *
+     * @param id The ID.
+     */
+    void add(std::uint32_t id);
+
+    /**
+     * @brief Removes an ID.
+     *
+     * @param id The ID.
+     * @return true if the ID was present.
+     */
+    bool remove(std::uint32_t id);
+
+    /**
+     * @brief Checks whether an ID is present.
+     *
+     * @param id The ID.
+     * @return true if present.
+     */
+    bool contains(std::uint32_t id) const;
+
+    /**
+     * @brief Number of IDs in the bitmap.
+     */
+    std::uint64_t cardinality() const;
+
+    /**
+     * @brief Whether the bitmap contains no IDs.
+     */
+    bool empty() const { return chunks.empty(); }
+
+    /**
+     * @brief Intersects this bitmap with another one (in place).
+     *
+     * @param other The other bitmap.
+     * @return Reference to this bitmap.
+     */
+    RoaringBitmap& operator&=(const RoaringBitmap& other);
+
+    /**
+     * @brief Size of the intersection with another bitmap (without building it).
+     *
+     * @param other The other bitmap.
+     * @return Number of IDs present in both bitmaps.
+     */
+    std::uint64_t andCardinality(const RoaringBitmap& other) const;
+
+    /**
+     * @brief Returns all IDs in ascending order.
+     */
+    std::vector<std::uint32_t> toVector() const;
+
+private:
+    static constexpr std::size_t ARRAY_MAX = 4096; ///< Above this a chunk becomes a bitset.
+    static constexpr std::size_t BITSET_MIN = ARRAY_MAX * 3 / 4; ///< Below this a bitset becomes an array again.
+    static constexpr std::size_t BITSET_WORDS = 1024; ///< 65536 bits.
+
+    struct Chunk {
+        std::uint16_t key = 0; ///< High 16 bits of the IDs in this chunk.
+        std::uint32_t count = 0; ///< Number of IDs in this chunk.
+        std::vector<std::uint16_t> values; ///< Sorted low bits (array chunk).
+        std::vector<std::uint64_t> bits; ///< Bitset (bitset chunk, otherwise empty).
+
+        bool isBitset() const { return !bits.empty(); }
+    };
+
+    std::vector<Chunk>::iterator findChunk(std::uint16_t key);
+    std::vector<Chunk>::const_iterator findChunk(std::uint16_t key) const;
+
+    static void toBitset(Chunk& chunk);
+    static void toArray(Chunk& chunk);
+    static std::uint32_t intersectCount(const Chunk& a, const Chunk& b);
+    static Chunk intersect(const Chunk& a, const Chunk& b);
+
+    std::vector<Chunk> chunks; ///< Sorted by key.
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <QString>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/**
+ * @brief The frontend files of static/, held in memory.
+ *
+ * All files are read once at startup; compressible ones are gzip (and zstd)
+ * encoded at the highest level right away, so serving an asset is a map lookup
+ * and a copy, without stat(), read() or compression per request. Every asset
+ * gets a content-hash ETag. Fingerprinted file names ("main.3f2a9c0d1e4b5a67.js",
+ * "chunk-AB12CD34.js") and requests carrying ?v=<hash> are cached by the browser
+ * as immutable; everything else is revalidated (304).
+ *
+ * With STATIC_RELOAD=1 the directory is watched (QFileSystemWatcher / inotify)
+ * and reloaded after changes. Files larger than STATIC_MAX_FILE_KB (default
+ * 8192) stay on disk; compressible ones get .gz / .zst siblings written by
+ * Compression::precompressDirectory(), which the /static route serves. Lookups are thread-safe; a reload swaps the whole set.
+ */
+class StaticAssets {
+public:
+    /**
+     * @brief An asset in memory.
+     */
+    struct Asset {
+        std::string body; ///< Original content.
+        std::string gzip; ///< gzip variant (empty if not compressible).
+        std::string zstd; ///< zstd variant (empty if not compressible / no zstd).
+        std::string contentType; ///< MIME type.
+        std::string hash; ///< Content hash (hex).
+        std::string etag; ///< Quoted hash.
+        bool fingerprinted = false; ///< File name contains a content hash.
+    };
+
+    /**
+     * @brief (Re)loads all files of a directory.
+     *
+     * @param dir The directory (e.g. "static").
+     */
+    static void load(const QString& dir);
+
+    /**
+     * @brief Reloads the directory after changes (if STATIC_RELOAD=1).
+     *
+     * Must be called from the thread running the Qt event loop.
+     *
+     * @param dir The directory passed to load().
+     */
+    static void watch(const QString& dir);
+
+    /**
+     * @brief Looks up an asset.
+     *
+     * @param relPath Path relative to the directory ("index.html", "assets/logo.svg").
+     * @return The asset, or nullptr if it is not in memory.
+     */
+    static std::shared_ptr<const Asset> find(const std::string& relPath);
+
+    /**
+     * @brief Number of assets in memory.
+     */
+    static std::size_t count();
+
+    /**
+     * @brief Memory used by all assets and their variants.
+     */
+    static std::size_t bytes();
+};
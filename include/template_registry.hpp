@@ -0,0 +1,52 @@
+#pragma once
+#include "crow.h"
+
+#include <QString>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Mustache templates of templates/, compiled once.
+ *
+ * load() reads and compiles every file of the directory at startup; routes
+ * render from the compiled form instead of crow::mustache::load() per request.
+ * The registry also installs itself as crow::mustache loader, so partials
+ * ({{>name}}) come from memory as well.
+ *
+ * With TEMPLATE_RELOAD=1 (development) the directory is watched and recompiled
+ * after changes. Thread-safe: renders use an immutable snapshot, a reload swaps it.
+ */
+class TemplateRegistry {
+public:
+    using Template = crow::mustache::template_t;
+
+    /**
+     * @brief Reads and compiles all templates of a directory.
+     *
+     * @param dir The directory (e.g. "templates").
+     */
+    static void load(const QString& dir);
+
+    /**
+     * @brief Recompiles after changes (if TEMPLATE_RELOAD=1).
+     *
+     * Must be called from the thread running the Qt event loop.
+     *
+     * @param dir The directory passed to load().
+     */
+    static void watch(const QString& dir);
+
+    /**
+     * @brief Returns a compiled template.
+     *
+     * @param name File name relative to the directory ("template.html").
+     * @return The template, or nullptr if it does not exist or did not compile.
+     */
+    static std::shared_ptr<const Template> get(const std::string& name);
+
+    /**
+     * @brief Number of compiled templates.
+     */
+    static std::size_t count();
+};
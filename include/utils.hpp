@@ -1,5 +1,8 @@
 #pragma once
 #include <string>
+#include <string_view>
+
+namespace crow { struct request; }
 
 /**
  * @brief Utility functions.
@@ -26,9 +29,33 @@ namespace utils {
      * @brief Retrieves the JWT Secret.
      * 
      * Tries to read JWT_SECRET from environment variables, otherwise returns a fallback.
+     * The value is read once (after the .env file was loaded) and cached.
      * 
      * @return The JWT secret key.
      */
-    std::string getJwtSecret();
+    const std::string& getJwtSecret();
+
+    /**
+     * @brief Determines the client IP address of a request.
+     * 
+     * Uses X-Real-IP / X-Forwarded-For only if TRUST_PROXY=1 (server behind NGINX),
+     * otherwise the peer address of the connection.
+     * 
+     * @param req The request.
+     * @return The client IP address.
+     */
+    std::string clientIp(const crow::request& req);
+
+    /**
+     * @brief Checks an If-None-Match header against an ETag (weak comparison).
+     * 
+     * The header is a comma-separated list of entity tags, each optionally
+     * prefixed with W/, or "*". Commas inside a quoted tag do not separate.
+     * 
+     * @param ifNoneMatch The header value.
+     * @param etag The quoted ETag of the response (with or without W/).
+     * @return true if any listed tag matches (-> 304).
+     */
+    bool etagMatches(std::string_view ifNoneMatch, std::string_view etag);
 
 }
\ No newline at end of file
@@ -0,0 +1,143 @@
+/**
+ * @file auth_cache.cpp
+ * @brief Implementation of the sharded user / refresh token cache.
+ */
+#include "auth_cache.hpp"
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+    constexpr std::size_t SHARD_COUNT = 16; ///< Number of independently locked shards.
+
+    template <typename Value>
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, Value> map;
+        AuthCache::Generation generation = 0; ///< Bumped by every invalidation.
+    };
+
+    template <typename Value>
+    using ShardedMap = std::array<Shard<Value>, SHARD_COUNT>;
+
+    ShardedMap<UserData> userShards;
+    ShardedMap<AuthCache::RefreshToken> tokenShards;
+
+    template <typename Value>
+    Shard<Value>& shardFor(ShardedMap<Value>& shards, const std::string& key) {
+        return shards[std::hash<std::string>{}(key) % SHARD_COUNT];
+    }
+
+    template <typename Value>
+    std::optional<Value> lookup(ShardedMap<Value>& shards, const std::string& key) {
+        auto& shard = shardFor(shards, key);
+        std::shared_lock lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) return std::nullopt;
+        return it->second;
+    }
+
+    template <typename Value>
+    AuthCache::Generation generationOf(ShardedMap<Value>& shards, const std::string& key) {
+        auto& shard = shardFor(shards, key);
+        std::shared_lock lock(shard.mutex);
+        return shard.generation;
+    }
+
+    template <typename Value>
+    void store(ShardedMap<Value>& shards, const std::string& key, Value value) {
+        auto& shard = shardFor(shards, key);
+        std::unique_lock lock(shard.mutex);
+        shard.map.insert_or_assign(key, std::move(value));
+    }
+
+    // Store of a row read after a miss: skipped if the shard was invalidated meanwhile
+    template <typename Value>
+    void storeIfUnchanged(ShardedMap<Value>& shards, const std::string& key, Value value, AuthCache::Generation seen) {
+        auto& shard = shardFor(shards, key);
+        std::unique_lock lock(shard.mutex);
+        if (shard.generation == seen) shard.map.insert_or_assign(key, std::move(value));
+    }
+
+    template <typename Value>
+    void erase(ShardedMap<Value>& shards, const std::string& key) {
+        auto& shard = shardFor(shards, key);
+        std::unique_lock lock(shard.mutex);
+        shard.map.erase(key);
+        ++shard.generation;
+    }
+
+    // Removes every entry matching the predicate (walks all shards)
+    template <typename Value, typename Pred>
+    std::size_t eraseIf(ShardedMap<Value>& shards, Pred pred) {
+        std::size_t removed = 0;
+        for (auto& shard : shards) {
+            std::unique_lock lock(shard.mutex);
+            removed += std::erase_if(shard.map, [&](const auto& entry) { return pred(entry.second); });
+            ++shard.generation;
+        }
+        return removed;
+    }
+}
+
+// ------------------------------------------------------------------
+// USERS
+// ------------------------------------------------------------------
+
+std::optional<UserData> AuthCache::getUser(const std::string& username) {
+    return lookup(userShards, username);
+}
+
+AuthCache::Generation AuthCache::userGeneration(const std::string& username) {
+    return generationOf(userShards, username);
+}
+
+void AuthCache::putUser(const UserData& user, Generation seen) {
+    if (user.id == 0 || user.username.empty()) return;
+    storeIfUnchanged(userShards, user.username, user, seen);
+}
+
+void AuthCache::invalidateUser(const std::string& username) {
+    erase(userShards, username);
+}
+
+void AuthCache::invalidateUserId(int id) {
+    eraseIf(userShards, [id](const UserData& u) { return u.id == id; });
+}
+
+// ------------------------------------------------------------------
+// REFRESH TOKENS
+// ------------------------------------------------------------------
+
+std::optional<AuthCache::RefreshToken> AuthCache::getRefreshToken(const std::string& token) {
+    return lookup(tokenShards, token);
+}
+
+AuthCache::Generation AuthCache::refreshTokenGeneration(const std::string& token) {
+    return generationOf(tokenShards, token);
+}
+
+void AuthCache::putRefreshToken(const std::string& token, const std::string& username, long long expiresAt) {
+    store(tokenShards, token, RefreshToken{username, expiresAt});
+}
+
+void AuthCache::putRefreshToken(const std::string& token, const std::string& username, long long expiresAt,
+                                Generation seen) {
+    storeIfUnchanged(tokenShards, token, RefreshToken{username, expiresAt}, seen);
+}
+
+void AuthCache::revokeRefreshToken(const std::string& token) {
+    erase(tokenShards, token);
+}
+
+void AuthCache::revokeRefreshTokensOf(const std::string& username) {
+    eraseIf(tokenShards, [&username](const RefreshToken& t) { return t.username == username; });
+}
+
+std::size_t AuthCache::purgeExpiredRefreshTokens(long long now) {
+    return eraseIf(tokenShards, [now](const RefreshToken& t) { return t.expiresAt <= now; });
+}
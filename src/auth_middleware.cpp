@@ -4,11 +4,143 @@
  */
 #include "auth_middleware.hpp"
 #include "utils.hpp" // For getJwtSecret
+#include "rate_limit_middleware.hpp"
 
 #include <jwt-cpp/jwt.h>
+#include <openssl/evp.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
 
 const std::string JWT_ISSUER = "crow_qt_server"; ///< JWT Issuer claim value.
 
+namespace {
+
+    using Verifier = jwt::verifier<jwt::default_clock, jwt::traits::kazuho_picojson>;
+
+    // Key + issuer check are built once; verify() is const and thread-safe.
+    const Verifier& verifier() {
+        static const Verifier instance = jwt::verify()
+            .allow_algorithm(jwt::algorithm::hs256{ utils::getJwtSecret() })
+            .with_issuer(JWT_ISSUER);
+        return instance;
+    }
+
+    // ------------------------------------------------------------------
+    // VERIFIED TOKEN CACHE
+    // Key: SHA-256 of the raw token, Value: username + 'exp' of the token.
+    // ------------------------------------------------------------------
+    struct CachedToken {
+        std::string username;
+        std::chrono::system_clock::time_point expiresAt;
+    };
+
+    struct CacheShard {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string, CachedToken> map;
+    };
+
+    constexpr std::size_t CACHE_SHARDS = 8;
+    std::array<CacheShard, CACHE_SHARDS> cacheShards;
+    std::size_t shardCapacity = 512; ///< Overridden by JWT_CACHE_SIZE.
+
+    std::atomic<std::uint64_t> cacheHits{0};
+    std::atomic<std::uint64_t> cacheMisses{0};
+
+    std::string tokenDigest(const std::string& token) {
+        unsigned char md[EVP_MAX_MD_SIZE];
+        unsigned int len = 0;
+        EVP_Digest(token.data(), token.size(), md, &len, EVP_sha256(), nullptr);
+        return std::string(reinterpret_cast<const char*>(md), len);
+    }
+
+    CacheShard& shardFor(const std::string& digest) {
+        return cacheShards[static_cast<unsigned char>(digest[0]) % CACHE_SHARDS];
+    }
+
+    bool lookupCached(const std::string& digest, std::string& username) {
+        auto& shard = shardFor(digest);
+        std::shared_lock lock(shard.mutex);
+        auto it = shard.map.find(digest);
+        if (it == shard.map.end() || it->second.expiresAt <= std::chrono::system_clock::now()) {
+            return false;
+        }
+        username = it->second.username;
+        return true;
+    }
+
+    void storeCached(const std::string& digest, CachedToken entry) {
+        auto& shard = shardFor(digest);
+        std::unique_lock lock(shard.mutex);
+        if (shard.map.size() >= shardCapacity) {
+            // Make room: first drop expired tokens, then an arbitrary one
+            auto now = std::chrono::system_clock::now();
+            std::erase_if(shard.map, [now](const auto& e) { return e.second.expiresAt <= now; });
+            if (shard.map.size() >= shardCapacity) shard.map.erase(shard.map.begin());
+        }
+        shard.map.insert_or_assign(digest, std::move(entry));
+    }
+
+    /**
+     * Verifies a bearer token (cache first, then signature / issuer / expiry).
+     * On failure 'error' holds the reason.
+     */
+    bool verifyToken(const std::string& token, std::string& username, std::string& error) {
+        // Already verified (and not yet expired)?
+        std::string digest = tokenDigest(token);
+        if (lookupCached(digest, username)) {
+            cacheHits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        cacheMisses.fetch_add(1, std::memory_order_relaxed);
+
+        // Full verification
+        try {
+            auto decoded = jwt::decode(token);
+            verifier().verify(decoded);
+
+            if (!decoded.has_payload_claim("username")) {
+                error = "Missing username claim";
+                return false;
+            }
+            username = decoded.get_payload_claim("username").as_string();
+            if (decoded.has_expires_at()) {
+                storeCached(digest, CachedToken{username, decoded.get_expires_at()});
+            }
+            return true;
+        } catch (const std::exception& e) {
+            error = e.what();
+            return false;
+        }
+    }
+}
+
+AuthMiddleware::AuthMiddleware() {
+    if (const char* env = std::getenv("JWT_CACHE_SIZE")) {
+        long size = std::atol(env);
+        if (size > 0) shardCapacity = std::max<std::size_t>(1, static_cast<std::size_t>(size) / CACHE_SHARDS);
+    }
+    verifier();
+}
+
+AuthMiddleware::CacheStats AuthMiddleware::cacheStats() {
+    CacheStats stats;
+    stats.hits = cacheHits.load(std::memory_order_relaxed);
+    stats.misses = cacheMisses.load(std::memory_order_relaxed);
+    for (auto& shard : cacheShards) {
+        std::shared_lock lock(shard.mutex);
+        stats.entries += shard.map.size();
+    }
+    return stats;
+}
+
 void AuthMiddleware::before_handle(crow::request& req, crow::response& res, context& ctx) {
 
     // -----------------------------------------------------------------------
@@ -18,12 +150,12 @@ void AuthMiddleware::before_handle(crow::request& req, crow::response& res, cont
     if (req.method == crow::HTTPMethod::OPTIONS) {
         // We do nothing here and let Crow (CORS Handler) continue.
         // A return here does not end the middleware chain for this request as an error.
-        return; 
+        return;
     }
-    
+
     // 1. Get Authorization Header
-    std::string authHeader = req.get_header_value("Authorization");
-    
+    const std::string& authHeader = req.get_header_value("Authorization");
+
     // Always JSON in case of error
     res.set_header("Content-Type", "application/json");
 
@@ -33,7 +165,7 @@ void AuthMiddleware::before_handle(crow::request& req, crow::response& res, cont
         return;
     }
 
-    if (authHeader.substr(0, 7) != "Bearer ") {
+    if (authHeader.compare(0, 7, "Bearer ") != 0) {
         res.code = 401;
         res.end(R"({"error": "Invalid Authorization Header format. Expected 'Bearer <token>'"})");
         return;
@@ -41,24 +173,26 @@ void AuthMiddleware::before_handle(crow::request& req, crow::response& res, cont
 
     std::string token = authHeader.substr(7);
 
-    try {
-        auto decoded = jwt::decode(token);
-        
-        auto verifier = jwt::verify()
-            .allow_algorithm(jwt::algorithm::hs256{ utils::getJwtSecret() })
-            .with_issuer(JWT_ISSUER);
+    // 2. Cached or full verification
+    std::string error;
+    if (verifyToken(token, ctx.current_user, error)) {
+        ctx.is_authenticated = true;
+        // Per-user rate limit: only known here (global middlewares run before us)
+        RateLimitMiddleware::chargeUser(req, res, ctx.current_user);
+        return;
+    }
 
-        verifier.verify(decoded);
+    res.code = 401;
+    // Simple JSON escaping
+    res.end("{\"error\": \"Token verification failed\", \"details\": \"" + error + "\"}");
+}
 
-        if (decoded.has_payload_claim("username")) {
-            ctx.current_user = decoded.get_payload_claim("username").as_string();
-            ctx.is_authenticated = true;
-        }
+std::optional<std::string> AuthMiddleware::userOf(const crow::request& req) {
+    const std::string& authHeader = req.get_header_value("Authorization");
+    if (authHeader.compare(0, 7, "Bearer ") != 0) return std::nullopt;
 
-    } catch (const std::exception& e) {
-        res.code = 401;
-        std::string msg = e.what();
-        // Simple JSON escaping
-        res.end("{\"error\": \"Token verification failed\", \"details\": \"" + msg + "\"}");
-    }
-}
\ No newline at end of file
+    std::string username;
+    std::string error;
+    if (!verifyToken(authHeader.substr(7), username, error)) return std::nullopt;
+    return username;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file compression.cpp
+ * @brief Implementation of gzip / zstd response encoding.
+ */
+#include "compression.hpp"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+
+#include <algorithm>
+#include <cstdlib>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+    int envLevel(const char* name, int fallback, int maxLevel) {
+        const char* env = std::getenv(name);
+        int level = env ? std::atoi(env) : 0;
+        return std::clamp(level > 0 ? level : fallback, 1, maxLevel);
+    }
+
+    std::optional<std::string> gzip(std::string_view data, int level) {
+        z_stream zs{};
+        // 15 window bits + 16 = gzip header instead of zlib
+        if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return std::nullopt;
+
+        std::string out;
+        out.resize(deflateBound(&zs, static_cast<uLong>(data.size())));
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        zs.avail_in = static_cast<uInt>(data.size());
+        zs.next_out = reinterpret_cast<Bytef*>(out.data());
+        zs.avail_out = static_cast<uInt>(out.size());
+
+        const int rc = deflate(&zs, Z_FINISH);
+        out.resize(zs.total_out);
+        deflateEnd(&zs);
+        if (rc != Z_STREAM_END) return std::nullopt;
+        return out;
+    }
+
+#ifdef HAVE_ZSTD
+    std::optional<std::string> zstd(std::string_view data, int level) {
+        std::string out;
+        out.resize(ZSTD_compressBound(data.size()));
+        const std::size_t n = ZSTD_compress(out.data(), out.size(), data.data(), data.size(), level);
+        if (ZSTD_isError(n)) return std::nullopt;
+        out.resize(n);
+        return out;
+    }
+#endif
+
+    // Extensions of text-like assets (binary images are already compressed)
+    bool isCompressibleFile(const QString& fileName) {
+        static const QSet<QString> extensions = {"html", "htm", "css", "js", "mjs", "json", "map",
+                                                 "svg", "txt", "xml", "ico", "wasm"};
+        return extensions.contains(QFileInfo(fileName).suffix().toLower());
+    }
+
+    void writeVariant(const QString& source, const QByteArray& content, Compression::Encoding encoding) {
+        const QString target = source + Compression::fileSuffix(encoding);
+        QFileInfo targetInfo(target);
+        if (targetInfo.exists() && targetInfo.lastModified() >= QFileInfo(source).lastModified()) return;
+
+        auto compressed = Compression::compress(std::string_view(content.constData(), content.size()), encoding, true);
+        if (!compressed) return;
+
+        // Write atomically, the file may be served while we are still writing
+        QSaveFile file(target);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << "Cannot write precompressed file:" << target;
+            return;
+        }
+        file.write(compressed->data(), static_cast<qint64>(compressed->size()));
+        file.commit();
+    }
+}
+
+Compression::Encoding Compression::negotiate(std::string_view acceptEncoding) {
+    bool gzipOk = false;
+    bool zstdOk = false;
+
+    while (!acceptEncoding.empty()) {
+        std::size_t comma = acceptEncoding.find(',');
+        std::string_view item = acceptEncoding.substr(0, comma);
+        acceptEncoding = comma == std::string_view::npos ? std::string_view() : acceptEncoding.substr(comma + 1);
+
+        // "gzip;q=0.8" -> token "gzip", q "0.8"
+        std::size_t semi = item.find(';');
+        std::string_view token = item.substr(0, semi);
+        while (!token.empty() && token.front() == ' ') token.remove_prefix(1);
+        while (!token.empty() && token.back() == ' ') token.remove_suffix(1);
+
+        bool refused = false;
+        if (semi != std::string_view::npos) {
+            std::string_view params = item.substr(semi + 1);
+            std::size_t q = params.find("q=");
+            if (q != std::string_view::npos) refused = std::atof(std::string(params.substr(q + 2)).c_str()) <= 0.0;
+        }
+        if (refused) continue;
+
+        if (token == "gzip" || token == "*") gzipOk = true;
+        if (token == "zstd" || token == "*") zstdOk = true;
+    }
+
+#ifdef HAVE_ZSTD
+    if (zstdOk) return Encoding::Zstd;
+#else
+    (void)zstdOk;
+#endif
+    return gzipOk ? Encoding::Gzip : Encoding::Identity;
+}
+
+const char* Compression::name(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::Gzip: return "gzip";
+        case Encoding::Zstd: return "zstd";
+        default: return "identity";
+    }
+}
+
+const char* Compression::fileSuffix(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::Gzip: return ".gz";
+        case Encoding::Zstd: return ".zst";
+        default: return "";
+    }
+}
+
+std::size_t Compression::minBytes() {
+    static const std::size_t bytes = [] {
+        const char* env = std::getenv("COMPRESSION_MIN_BYTES");
+        return env ? static_cast<std::size_t>(std::atoll(env)) : std::size_t{1024};
+    }();
+    return bytes;
+}
+
+bool Compression::isCompressible(std::string_view contentType) {
+    return contentType.starts_with("text/") || contentType.starts_with("application/json") ||
+           contentType.starts_with("application/javascript") || contentType.starts_with("application/xml") ||
+           contentType.starts_with("image/svg+xml");
+}
+
+std::optional<std::string> Compression::compress(std::string_view data, Encoding encoding, bool maxLevel) {
+    switch (encoding) {
+        case Encoding::Gzip:
+            return gzip(data, maxLevel ? 9 : envLevel("GZIP_LEVEL", 5, 9));
+#ifdef HAVE_ZSTD
+        case Encoding::Zstd:
+            return zstd(data, maxLevel ? 19 : envLevel("ZSTD_LEVEL", 3, 9));
+#endif
+        default:
+            return std::nullopt;
+    }
+}
+
+void Compression::precompressDirectory(const QString& dir, qint64 minFileBytes) {
+    const qint64 threshold = std::max(minFileBytes, static_cast<qint64>(minBytes()));
+    int count = 0;
+    QDirIterator it(dir, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if (!isCompressibleFile(path) || QFileInfo(path).size() < threshold) continue;
+
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        const QByteArray content = file.readAll();
+
+        writeVariant(path, content, Encoding::Gzip);
+#ifdef HAVE_ZSTD
+        writeVariant(path, content, Encoding::Zstd);
+#endif
+        ++count;
+    }
+    if (count > 0) qInfo() << "Precompressed" << count << "large static files in" << dir;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file compression_middleware.cpp
+ * @brief Implementation of the Compression Middleware.
+ */
+#include "compression_middleware.hpp"
+#include "compression.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+
+    bool enabled() {
+        static const bool on = [] {
+            const char* env = std::getenv("COMPRESSION_ENABLED");
+            return !env || std::string_view(env) != "0";
+        }();
+        return on;
+    }
+
+    std::atomic<std::uint64_t> compressed{0};
+    std::atomic<std::uint64_t> saved{0};
+}
+
+void CompressionMiddleware::after_handle(crow::request& req, crow::response& res, context& /*ctx*/) {
+    if (!enabled() || req.method == crow::HTTPMethod::HEAD) return;
+    if (res.code != 200 || res.body.size() < Compression::minBytes()) return;
+    if (!res.get_header_value("Content-Encoding").empty()) return;
+    if (!Compression::isCompressible(res.get_header_value("Content-Type"))) return;
+
+    // From here on the representation depends on Accept-Encoding
+    res.set_header("Vary", "Accept-Encoding");
+
+    const Compression::Encoding encoding = Compression::negotiate(req.get_header_value("Accept-Encoding"));
+    if (encoding == Compression::Encoding::Identity) return;
+
+    auto body = Compression::compress(res.body, encoding);
+    if (!body || body->size() >= res.body.size()) return;
+
+    saved.fetch_add(res.body.size() - body->size(), std::memory_order_relaxed);
+    compressed.fetch_add(1, std::memory_order_relaxed);
+
+    res.body = std::move(*body);
+    res.set_header("Content-Encoding", Compression::name(encoding));
+
+    const std::string etag = res.get_header_value("ETag");
+    if (!etag.empty() && !etag.starts_with("W/")) res.set_header("ETag", "W/" + etag);
+}
+
+std::uint64_t CompressionMiddleware::compressedCount() {
+    return compressed.load(std::memory_order_relaxed);
+}
+
+std::uint64_t CompressionMiddleware::savedBytes() {
+    return saved.load(std::memory_order_relaxed);
+}
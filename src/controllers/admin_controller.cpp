@@ -1,9 +1,19 @@
 #include "controllers/admin_controller.hpp"
 #include "db_manager.hpp"
+#include "password_hasher.hpp"
+#include "db_executor.hpp"
+#include "deletion_queue.hpp"
+#include "json_writer.hpp"
+#include "metadata_extractor.hpp"
+#include "image_processor.hpp"
+#include "request_trace.hpp"
+#include "media_links.hpp"
+
+#include <QFileInfo>
 
 namespace routes {
 
-void setupAdminRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
+void setupAdminRoutes(CrowApp& app) {
 
     // TRICK: Wir speichern die Adresse der App in einem Pointer.
     // Dieser Pointer ist sicher, da die App in main() lebt und nicht gelöscht wird.
@@ -23,25 +33,31 @@ void setupAdminRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
             return; 
         }
 
-        auto users = DbManager::getAllUsers();
-        
-        std::vector<crow::json::wvalue> jsonList;
-        for (const auto& u : users) {
-            crow::json::wvalue j;
-            j["id"] = u.id;
-            j["username"] = u.username;
-            j["created_at"] = u.createdAt;
-            j["is_active"] = u.isActive;
-            // Neue Felder für Admin-Ansicht (optional)
-            j["force_password_change"] = u.forcePasswordChange;
-            j["password_changed_at"] = u.passwordChangedAt;
-            jsonList.push_back(j);
-        }
-        
-        crow::json::wvalue result = std::move(jsonList);
-        res.end(result.dump());
+        DbExecutor::respond(res, RequestTrace::start("GET /api/admin/users"), []() {
+            auto users = DbManager::getAllUsers();
+            
+            // Direkt in einen Puffer schreiben (kein wvalue pro User)
+            JsonWriter w(users.size() * 192 + 2);
+            w.beginArray();
+            for (const auto& u : users) {
+                w.beginObject();
+                w.key("id").value(u.id);
+                w.key("username").value(u.username);
+                w.key("created_at").value(u.createdAt);
+                w.key("is_active").value(u.isActive);
+                // Neue Felder für Admin-Ansicht (optional)
+                w.key("force_password_change").value(u.forcePasswordChange);
+                w.key("password_changed_at").value(u.passwordChangedAt);
+                w.endObject();
+            }
+            w.endArray();
+            
+            return crow::response(w.take());
+        });
     });
     // 2. USER ANLEGEN
+    // Bleibt im Crow-Thread: die Zeit steckt in bcrypt (eigener, begrenzter Pool),
+    // die DB-Threads sollen nicht darauf warten.
     CROW_ROUTE(app, "/api/admin/users")
         .methods(crow::HTTPMethod::POST)
         .CROW_MIDDLEWARES(app, AuthMiddleware)
@@ -51,7 +67,24 @@ void setupAdminRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
             res.code = 400; res.end("Missing data"); return;
         }
 
-        if (DbManager::createUser(json["username"].s(), json["password"].s())) {
+        // Zeitmessung (Server-Timing / OTLP): bcrypt + INSERT
+        auto trace = RequestTrace::start("POST /api/admin/users");
+        bool created = false;
+        bool busy = false;
+        try {
+            auto stage = trace->stage("create_user");
+            created = DbManager::createUser(json["username"].s(), json["password"].s());
+        } catch (const PasswordHasher::Overloaded&) {
+            busy = true;
+        }
+        // Vor jedem res.end(): auch die 503-Antwort bekommt Server-Timing und Span
+        trace->finish(res);
+
+        if (busy) {
+            res.code = 503;
+            res.set_header("Retry-After", "1");
+            res.end("Server busy, please retry");
+        } else if (created) {
             res.code = 201; 
             res.end("User created");
         } else {
@@ -71,11 +104,10 @@ void setupAdminRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
              res.end("Cannot delete root admin"); return;
         }
 
-        if (DbManager::deleteUser(id)) {
-            res.code = 200; res.end("User deleted");
-        } else {
-            res.code = 404; res.end("User not found");
-        }
+        DbExecutor::respond(res, RequestTrace::start("DELETE /api/admin/users/:id"), [id]() {
+            if (DbManager::deleteUser(id)) return crow::response(200, "User deleted");
+            return crow::response(404, "User not found");
+        });
     });
 
     // --- 4. USER STATUS ÄNDERN (Aktivieren/Deaktivieren) ---
@@ -104,16 +136,15 @@ void setupAdminRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
 
         bool active = json["active"].b();
 
-        if (DbManager::updateUserStatus(id, active)) {
-            res.code = 200; 
-            res.end(R"({"status": "updated"})");
-        } else {
-            res.code = 500; 
-            res.end("Update failed");
-        }
+        DbExecutor::respond(res, RequestTrace::start("PUT /api/admin/users/:id/status"), [id, active]() {
+            if (DbManager::updateUserStatus(id, active)) {
+                return crow::response(200, R"({"status": "updated"})");
+            }
+            return crow::response(500, "Update failed");
+        });
     });
 
-    // --- 5. PASSWORD RESET (Admin force) ---
+    // --- 5. PASSWORD RESET (Admin force, bcrypt -> bleibt im Crow-Thread) ---
     CROW_ROUTE(app, "/api/admin/users/<int>/reset-password")
         .methods(crow::HTTPMethod::POST)
         .CROW_MIDDLEWARES(app, AuthMiddleware)
@@ -132,7 +163,22 @@ void setupAdminRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
 
         std::string newTempPass = json["password"].s();
 
-        if (DbManager::adminResetPassword(id, newTempPass)) {
+        auto trace = RequestTrace::start("POST /api/admin/users/:id/reset-password");
+        bool reset = false;
+        bool busy = false;
+        try {
+            auto stage = trace->stage("reset_password");
+            reset = DbManager::adminResetPassword(id, newTempPass);
+        } catch (const PasswordHasher::Overloaded&) {
+            busy = true;
+        }
+        trace->finish(res);
+
+        if (busy) {
+            res.code = 503;
+            res.set_header("Retry-After", "1");
+            res.end("Server busy, please retry");
+        } else if (reset) {
             // Frontend erwartet text response
             res.code = 200; 
             res.end("Password reset. User forced to change.");
@@ -142,5 +188,98 @@ void setupAdminRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
         }
     });
 
+
+    // --- 6. PAPIERKORB (gelöschte Fotos bis TRASH_GRACE_HOURS) ---
+    CROW_ROUTE(app, "/api/admin/trash")
+        .methods(crow::HTTPMethod::GET)
+        .CROW_MIDDLEWARES(app, AuthMiddleware)
+    ([appPtr](const crow::request& req, crow::response& res){
+        auto& ctx = appPtr->get_context<AuthMiddleware>(req);
+        if (ctx.current_user != "admin") { 
+            res.code = 403; res.end("Forbidden"); return; 
+        }
+
+        // Nur Dateisystem, kein DB-Zugriff
+        auto trace = RequestTrace::start("GET /api/admin/trash");
+        auto scan = trace->stage("scan");
+        std::vector<crow::json::wvalue> jsonList;
+        for (const auto& e : DeletionQueue::trash()) {
+            crow::json::wvalue j;
+            j["id"] = e.id.toStdString();
+            j["path"] = e.originalPath.toStdString();
+            j["deleted_at"] = e.deletedAt.toString(Qt::ISODate).toStdString();
+            j["expires_at"] = e.expiresAt.toString(Qt::ISODate).toStdString();
+            j["size"] = e.size;
+            jsonList.push_back(std::move(j));
+        }
+
+        crow::json::wvalue result;
+        result["items"] = std::move(jsonList);
+        result["pending"] = DeletionQueue::pending();
+        scan.end();
+        trace->finish(res);
+        res.end(result.dump());
+    });
+
+    // --- 7. AUS DEM PAPIERKORB WIEDERHERSTELLEN ---
+    // Datei zurückschieben, dann wie ein Upload neu einlesen (Metadaten, WebP, DB-Zeile)
+    CROW_ROUTE(app, "/api/admin/trash/restore")
+        .methods(crow::HTTPMethod::POST)
+        .CROW_MIDDLEWARES(app, AuthMiddleware)
+    ([appPtr](const crow::request& req, crow::response& res){
+        auto& ctx = appPtr->get_context<AuthMiddleware>(req);
+        if (ctx.current_user != "admin") { 
+            res.code = 403; res.end("Forbidden"); return; 
+        }
+
+        auto json = crow::json::load(req.body);
+        if (!json || !json.has("id")) {
+            res.code = 400; res.end(R"({"error": "Missing 'id'"})"); return;
+        }
+
+        auto trace = RequestTrace::start("POST /api/admin/trash/restore");
+        auto move = trace->stage("restore");
+        std::optional<QString> restored = DeletionQueue::restore(QString::fromStdString(json["id"].s()));
+        move.end();
+        if (!restored) {
+            trace->finish(res);
+            res.code = 409;
+            res.end(R"({"error": "Entry not found or original path is occupied"})");
+            return;
+        }
+
+        const QString fullPath = *restored;
+        const std::string user = ctx.current_user;
+        DbExecutor::respond(res, trace, [fullPath, user]() {
+            QFileInfo info(fullPath);
+
+            // "Photos/2025/Bild.jpg" -> relPath "2025"
+            QString relDir = info.path();
+            if (relDir == "Photos") relDir.clear();
+            else if (relDir.startsWith("Photos/")) relDir = relDir.mid(7);
+
+            QString parentDir = info.path();
+            ImageProcessor::enqueueWebPVersions(fullPath, parentDir);
+
+            WorkerPayload payload;
+            payload.filename = info.fileName().toStdString();
+            payload.relPath = relDir.toStdString();
+            payload.fullPath = fullPath.toStdString();
+            payload.user = user;
+            payload.fileSize = info.size();
+            payload.meta = MetadataExtractor::extract(fullPath.toStdString());
+            payload.fileDate = payload.meta.takenAt.isValid() ? payload.meta.takenAt : info.lastModified();
+
+            if (!DbManager::insertPhoto(payload)) {
+                return crow::response(500, R"({"error": "File restored, DB error."})");
+            }
+            crow::json::wvalue result;
+            result["status"] = "restored";
+            result["path"] = fullPath.toStdString();
+            result["url"] = MediaLinks::forUser(user).url(relDir, info.fileName()).toStdString();
+            return crow::response(200, result.dump());
+        });
+    });
+
 }
 }
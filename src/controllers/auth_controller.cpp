@@ -1,11 +1,13 @@
 #include "controllers/auth_controller.hpp"
 #include "db_manager.hpp"
 #include "utils.hpp"
+#include "login_throttle.hpp"
+#include "password_hasher.hpp"
 #include <jwt-cpp/jwt.h>
 
 namespace routes {
 
-void setupAuthRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
+void setupAuthRoutes(CrowApp& app) {
     
     // WICHTIG: Diese Zeile muss oben stehen, damit die Lambdas 'appPtr' kennen
     auto* appPtr = &app;
@@ -22,7 +24,24 @@ void setupAuthRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
         std::string user = json["username"].s();
         std::string pass = json["password"].s();
 
-        if (DbManager::verifyUser(user, pass)) {
+        // Throttle per IP and per username (before any bcrypt work)
+        int retryAfter = 0;
+        if (!LoginThrottle::allow(utils::clientIp(req), user, retryAfter)) {
+            crow::response res(429, "Too many login attempts");
+            res.set_header("Retry-After", std::to_string(retryAfter));
+            return res;
+        }
+
+        bool valid = false;
+        try {
+            valid = DbManager::verifyUser(user, pass);
+        } catch (const PasswordHasher::Overloaded&) {
+            crow::response res(503, "Server busy, please retry");
+            res.set_header("Retry-After", "1");
+            return res;
+        }
+
+        if (valid) {
             // 1. Access Token (15 Min)
             auto accessToken = jwt::create()
                 .set_issuer("crow_qt_server")
@@ -124,7 +143,14 @@ void setupAuthRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
         if (newPass.length() < 8) return crow::response(400, "New password too short");
 
         // Aufruf DbManager
-        int resCode = DbManager::changeOwnPassword(ctx.current_user, oldPass, newPass);
+        int resCode = 1;
+        try {
+            resCode = DbManager::changeOwnPassword(ctx.current_user, oldPass, newPass);
+        } catch (const PasswordHasher::Overloaded&) {
+            crow::response res(503, "Server busy, please retry");
+            res.set_header("Retry-After", "1");
+            return res;
+        }
 
         if (resCode == 0) {
             return crow::response(200, "Password changed successfully");
@@ -4,17 +4,666 @@
  */
 #include "controllers/gallery_controller.hpp"
 #include "db_manager.hpp"
+#include "db_executor.hpp"
+#include "facet_index.hpp"
+#include "keyword_index.hpp"
+#include "geo_index.hpp"
+#include "gallery_cache.hpp"
+#include "json_writer.hpp"
+#include "request_trace.hpp"
+#include "image_processor.hpp"
+#include "media_links.hpp"
+#include "media_files.hpp"
+#include "auth_middleware.hpp"
+#include "logger.hpp"
 #include <QSqlQuery>
+#include <QSqlRecord>
 #include <QVariant>
 #include <QSqlError> // IMPORTANT
 #include <QDebug>
+#include <QStringList>
+#include <QDateTime>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+
+namespace {
+
+// UPDATE: We join meta_iptc and fetch keywords via subselect (Postgres string_agg)
+const QString PHOTO_COLUMNS = R"(
+    p.id, p.file_name, p.file_path, p.file_datetime, p.width,
+    l.city, l.country,
+    e.iso, e.aperture, e.exposure_time, e.model,
+    i.object_name as title, i.caption as description, i.copyright,
+    (
+        SELECT string_agg(k.tag, ',') 
+        FROM keywords k 
+        JOIN picture_keywords pk ON k.id = pk.keyword_id 
+        WHERE pk.picture_id = p.id
+    ) as keyword_string
+)";
+
+const QString PHOTO_JOINS = R"(
+    LEFT JOIN meta_location l ON p.id = l.ref_picture
+    LEFT JOIN meta_exif e ON p.id = e.ref_picture
+    LEFT JOIN meta_iptc i ON p.id = i.ref_picture
+)";
+
+/**
+ * @brief srcset of the WebP versions of a picture ("/media/a/webp/x_480.webp 480w, ...").
+ * 
+ * Candidates are the widths generateWebPVersions() produces for an original of
+ * this width; only versions that exist on disk are listed, since they are
+ * generated in the background after the upload (or may have failed). Empty if
+ * none exists yet. The gallery cache is invalidated when a generation job ends.
+ */
+QString srcset(const QString& relDir, const QString& fileName, int originalWidth, const MediaLinks& links) {
+    const QString baseName = fileName.left(fileName.lastIndexOf('.'));
+    const QString webpDir = relDir.isEmpty() ? QString("webp") : relDir + "/webp";
+    const QString diskDir = QString::fromStdString(MediaFiles::root()) + '/' + webpDir + '/';
+    QString out;
+    for (int width : ImageProcessor::versionWidths(originalWidth)) {
+        if (!QFileInfo::exists(diskDir + ImageProcessor::versionFileName(baseName, width))) continue;
+        if (!out.isEmpty()) out += ", ";
+        out += links.url(webpDir, ImageProcessor::versionFileName(baseName, width)) + ' ' + QString::number(width) + 'w';
+    }
+    return out;
+}
+
+/**
+ * @brief Result column positions of a query over PHOTO_COLUMNS.
+ * 
+ * Resolved once per query instead of a by-name lookup per field and row.
+ */
+struct PhotoColumnIndex {
+    int id, fileName, filePath, fileDatetime, width, city, country, model, title, description, copyright, keywords;
+
+    explicit PhotoColumnIndex(const QSqlRecord& r)
+        : id(r.indexOf("id")), fileName(r.indexOf("file_name")), filePath(r.indexOf("file_path")),
+          fileDatetime(r.indexOf("file_datetime")), width(r.indexOf("width")), city(r.indexOf("city")), country(r.indexOf("country")),
+          model(r.indexOf("model")), title(r.indexOf("title")), description(r.indexOf("description")),
+          copyright(r.indexOf("copyright")), keywords(r.indexOf("keyword_string")) {}
+};
+
+/**
+ * @brief Writes the current row of a query over PHOTO_COLUMNS as a JSON object.
+ */
+void writePhotoItem(JsonWriter& w, const QSqlQuery& q, const PhotoColumnIndex& c, const MediaLinks& links) {
+    const QString fileName = q.value(c.fileName).toString();
+    // We use 'name' in frontend as title if present, otherwise filename
+    const QString dbTitle = q.value(c.title).toString();
+
+    w.beginObject();
+    w.key("id").value(q.value(c.id).toInt());
+    w.key("filename").value(fileName);
+    w.key("name").value(dbTitle.isEmpty() ? fileName : dbTitle);
+    w.key("type").value("image");
+
+    // Paths
+    const QString relDir = q.value(c.filePath).toString();
+    w.key("url").value(links.url(relDir, fileName));
+    const QString versions = srcset(relDir, fileName, q.value(c.width).toInt(), links);
+    if (!versions.isEmpty()) w.key("srcset").value(versions);
+
+    // Date
+    QDateTime dt = q.value(c.fileDatetime).toDateTime();
+    w.key("date").value(dt.isValid() ? dt.toString(Qt::ISODate) : QString());
+
+    // Metadata
+    w.key("city").value(q.value(c.city).toString());
+    w.key("country").value(q.value(c.country).toString());
+
+    QString cam = q.value(c.model).toString();
+    if (!cam.isEmpty()) w.key("camera").value(cam);
+
+    // --- NEW: Send IPTC Data ---
+    w.key("title").value(dbTitle);
+    w.key("description").value(q.value(c.description).toString());
+    w.key("copyright").value(q.value(c.copyright).toString());
+
+    // Keywords come as "Tag1,Tag2,Tag3" string from DB
+    // We send it as string, the frontend splits it
+    w.key("keywords_string").value(q.value(c.keywords).toString());
+    w.endObject();
+}
+
+/**
+ * @brief JSON response from a finished writer.
+ */
+crow::response jsonResponse(JsonWriter& w) {
+    crow::response response(w.take());
+    response.set_header("Content-Type", "application/json");
+    return response;
+}
+
+/**
+ * @brief Reads the facet filter parameters (camera, country, city, year, keyword).
+ * 
+ * 'keyword' may contain several comma-separated tags, all of which must match.
+ */
+FacetIndex::Filter facetFilter(const crow::request& req) {
+    FacetIndex::Filter filter;
+    for (int f = 0; f < FacetIndex::Keyword; ++f) {
+        if (const char* v = req.url_params.get(FacetIndex::name(static_cast<FacetIndex::Facet>(f)))) {
+            filter.values[f] = QString::fromUtf8(v).trimmed();
+        }
+    }
+    if (const char* k = req.url_params.get(FacetIndex::name(FacetIndex::Keyword))) {
+        for (const QString& tag : QString::fromUtf8(k).split(',', Qt::SkipEmptyParts)) {
+            if (!tag.trimmed().isEmpty()) filter.keywords << tag.trimmed();
+        }
+    }
+    return filter;
+}
+
+/**
+ * @brief Loads the pictures of a facet-filtered page.
+ * 
+ * The bitmap index already decided which IDs are on the page and in which order,
+ * SQL only fetches their rows.
+ */
+bool loadFilteredPhotos(QSqlDatabase& db, const std::vector<std::uint32_t>& ids, JsonWriter& out,
+                        const MediaLinks& links) {
+    if (ids.empty()) return true;
+
+    QStringList idList;
+    for (std::uint32_t id : ids) idList << QString::number(id);
+
+    QSqlQuery q(db);
+    q.prepare("SELECT " + PHOTO_COLUMNS + " FROM pictures p " + PHOTO_JOINS +
+              " WHERE p.id = ANY(CAST(:ids AS bigint[]))");
+    q.bindValue(":ids", "{" + idList.join(',') + "}");
+    if (!q.exec()) {
+        LOG_CRITICAL << "Filtered Image Query Failed:" << q.lastError().text();
+        return false;
+    }
+
+    // Rows arrive in any order: serialize them into one scratch buffer, then
+    // copy the spans over in index order
+    const PhotoColumnIndex columns(q.record());
+    JsonWriter rows(ids.size() * 512);
+    std::unordered_map<std::uint32_t, std::pair<std::size_t, std::size_t>> spans;
+    spans.reserve(ids.size());
+    while (q.next()) {
+        const std::size_t begin = rows.size();
+        writePhotoItem(rows, q, columns, links);
+        spans.try_emplace(q.value(columns.id).toUInt(), begin, rows.size() - begin);
+    }
+    const std::string_view buffer = rows.str();
+    for (std::uint32_t id : ids) {
+        auto it = spans.find(id);
+        if (it != spans.end()) out.raw(buffer.substr(it->second.first, it->second.second));
+    }
+    return true;
+}
+
+/**
+ * @brief Cache key / ETag input of a gallery request.
+ * 
+ * Starts with the folder; contains every parameter that changes the response,
+ * including user and expiry of signed media URLs.
+ */
+std::string galleryCacheKey(int page, int limit, const QString& qPath, bool foldersOnly,
+                            const FacetIndex::Filter& filter, const QDateTime& before, const MediaLinks& links) {
+    QStringList parts{qPath, QString::number(page), QString::number(limit), foldersOnly ? "1" : "0",
+                      before.isValid() ? before.toString(Qt::ISODateWithMs) : QString()};
+    for (const QString& value : filter.values) parts << value;
+    parts << filter.keywords.join(',');
+    if (links.expires != 0) parts << QString::fromStdString(links.user) << QString::number(links.expires);
+    return parts.join('\n').toStdString();
+}
+
+/**
+ * @brief Builds the gallery listing (folders + pictures of one path).
+ * 
+ * With an active facet filter the pictures are selected via FacetIndex and the
+ * total number of matches is returned in the X-Total-Count header.
+ * Runs on a DbExecutor thread.
+ */
+crow::response listGallery(int page, int limit, const QString& qPath, bool foldersOnly, const FacetIndex::Filter& filter,
+                           const QDateTime& before, const MediaLinks& links) {
+    const bool filtered = !filter.isEmpty();
+    if (filtered && !foldersOnly && !FacetIndex::isReady()) {
+        return crow::response(503, R"({"error": "Facet index not loaded"})");
+    }
+    std::uint64_t total = 0;
+
+    // Read-only: replica if available (primary right after writes to this folder)
+    QSqlDatabase db = DbManager::getReadConnection(qPath);
+    
+    if (!db.isOpen()) return crow::response(500, "DB Connection Error");
+
+    // Streamed into one buffer (~1 KB per picture)
+    JsonWriter w(static_cast<std::size_t>(limit) * 1024);
+    w.beginArray();
+
+    // ---------------------------------------------------------
+    // 1. FIND SUBFOLDERS
+    // ---------------------------------------------------------
+    // We only load folders on page 1, to avoid duplicates when scrolling
+    if (page == 1) {
+        QSqlQuery qFolders(db);
+        QString folderSql;
+
+        if (qPath.isEmpty()) {
+            // Root: First part of the path
+            folderSql = "SELECT DISTINCT split_part(file_path, '/', 1) as folder "
+                        "FROM pictures WHERE file_path <> ''";
+        } else {
+            // Subfolder: Part after current path
+            folderSql = "SELECT DISTINCT split_part(substring(file_path, length(:base) + 2), '/', 1) as folder "
+                        "FROM pictures WHERE file_path LIKE :pattern ESCAPE '\\'";
+        }
+        
+        qFolders.prepare(folderSql);
+        if (!qPath.isEmpty()) {
+            qFolders.bindValue(":base", qPath);
+            qFolders.bindValue(":pattern", DbManager::subfolderPattern(qPath));
+        }
+        
+        if (qFolders.exec()) {
+            while(qFolders.next()) {
+                QString folderName = qFolders.value(0).toString();
+                if (folderName.isEmpty()) continue;
+
+                QString fullFolderPath = qPath.isEmpty() ? folderName : qPath + "/" + folderName;
+
+                w.beginObject();
+                w.key("name").value(folderName);
+                w.key("type").value("folder");
+                w.key("path").value(fullFolderPath);
+                w.endObject();
+            }
+        } else {
+            LOG_WARNING << "Folder Query Failed:" << qFolders.lastError().text();
+        }
+    }
+
+    // ---------------------------------------------------------
+    // 2. PICTURES IN CURRENT FOLDER
+    // ---------------------------------------------------------
+    // Only execute if we are not in pure Tree-Mode
+    if (!foldersOnly) { 
+        int offset = (page - 1) * limit;
+
+        if (filtered) {
+            std::optional<qint64> beforeKey;
+            if (before.isValid()) beforeKey = before.toMSecsSinceEpoch();
+            FacetIndex::Page hits = FacetIndex::page(filter, qPath, offset, limit, beforeKey);
+            total = hits.total;
+            if (!loadFilteredPhotos(db, hits.ids, w, links)) {
+                return crow::response(500, R"({"error": "Query failed"})");
+            }
+        } else {
+            QSqlQuery qImages(db);
+        
+            // 'before' = seek to a date (from /api/timeline), pages continue from there
+            qImages.prepare("SELECT " + PHOTO_COLUMNS + " FROM pictures p " + PHOTO_JOINS +
+                            " WHERE p.file_path = :path" +
+                            (before.isValid() ? " AND p.file_datetime < :before" : "") +
+                            " ORDER BY p.file_datetime DESC"
+                            " LIMIT :lim OFFSET :off");
+            qImages.bindValue(":path", qPath);
+            if (before.isValid()) qImages.bindValue(":before", before);
+            qImages.bindValue(":lim", limit);
+            qImages.bindValue(":off", offset);
+        
+            if (qImages.exec()) {
+                const PhotoColumnIndex columns(qImages.record());
+                while(qImages.next()) {
+                    writePhotoItem(w, qImages, columns, links);
+                }
+            } else {
+                 LOG_CRITICAL << "Image Query Failed:" << qImages.lastError().text();
+                 // No partial listing, it would end up in the GalleryCache
+                 return crow::response(500, R"({"error": "Query failed"})");
+            }
+        }
+    }
+
+    w.endArray();
+    crow::response response = jsonResponse(w);
+    if (filtered && !foldersOnly) response.set_header("X-Total-Count", std::to_string(total));
+    return response;
+    
+    // IMPORTANT: Connection is NOT closed, remains in Pool.
+}
+
+/**
+ * @brief Keyset position of /api/search: rank and id of the last item of a page.
+ */
+struct SearchCursor {
+    float rank = 0;
+    qint64 id = 0;
+};
+
+/**
+ * @brief Parses a next_cursor value "<rank>:<id>".
+ * 
+ * @return The cursor, or std::nullopt if the value is malformed (-> 400).
+ */
+std::optional<SearchCursor> parseSearchCursor(const QString& value) {
+    const QStringList parts = value.split(':');
+    if (parts.size() != 2) return std::nullopt;
+
+    bool rankOk = false;
+    bool idOk = false;
+    SearchCursor cursor;
+    cursor.rank = parts[0].toFloat(&rankOk);
+    cursor.id = parts[1].toLongLong(&idOk);
+    if (!rankOk || !idOk || !std::isfinite(cursor.rank)) return std::nullopt;
+    return cursor;
+}
+
+/**
+ * @brief Full-text search over title, caption, keywords and location.
+ * 
+ * Ranked by ts_rank, keyset-paginated by (rank, id). The cursor is "<rank>:<id>"
+ * of the last item of the previous page. Runs on a DbExecutor thread.
+ */
+crow::response searchPhotos(const QString& text, int limit, const std::optional<SearchCursor>& cursor,
+                            const MediaLinks& links) {
+    QSqlDatabase db = DbManager::getReadConnection();
+    if (!db.isOpen()) return crow::response(500, "DB Connection Error");
+
+    const bool hasCursor = cursor.has_value();
+
+    QSqlQuery q(db);
+    q.prepare("SELECT " + PHOTO_COLUMNS + ", ts_rank(p.search_vector, query)::real AS rank "
+              "FROM pictures p CROSS JOIN websearch_to_tsquery('simple', :q) query " + PHOTO_JOINS +
+              " WHERE p.search_vector @@ query" +
+              (hasCursor ? " AND (ts_rank(p.search_vector, query)::real, p.id) < (CAST(:crank AS real), :cid)" : "") +
+              " ORDER BY rank DESC, p.id DESC"
+              " LIMIT :lim");
+    q.bindValue(":q", text);
+    if (hasCursor) {
+        q.bindValue(":crank", cursor->rank);
+        q.bindValue(":cid", cursor->id);
+    }
+    q.bindValue(":lim", limit);
+
+    if (!q.exec()) {
+        LOG_CRITICAL << "Search Query Failed:" << q.lastError().text();
+        return crow::response(500, R"({"error": "Search failed"})");
+    }
+
+    const PhotoColumnIndex columns(q.record());
+    const int rankColumn = q.record().indexOf("rank");
+    JsonWriter w(static_cast<std::size_t>(limit) * 1024);
+    w.beginObject().key("items").beginArray();
+
+    int count = 0;
+    QString nextCursor;
+    while (q.next()) {
+        writePhotoItem(w, q, columns, links);
+        ++count;
+        // float4 needs 9 significant digits for an exact round trip
+        nextCursor = QString::number(q.value(rankColumn).toFloat(), 'g', 9) + ":" + q.value(columns.id).toString();
+    }
+    w.endArray();
+
+    w.key("next_cursor");
+    if (count == limit) {
+        w.value(nextCursor);
+    } else {
+        w.null();
+    }
+    w.endObject();
+    return jsonResponse(w);
+}
+
+/**
+ * @brief Reads the photo selection of a batch request ("ids" or "path_prefix").
+ * 
+ * Checks the JSON types first: crow's accessors throw on a type mismatch,
+ * which would surface as a 500.
+ * 
+ * @return false (with 'error' set) if the body is malformed, selects nothing or too much.
+ */
+bool parseSelection(const crow::json::rvalue& json, PhotoSelection& selection, std::string& error) {
+    constexpr std::size_t MAX_BATCH_IDS = 10000;
+
+    if (json.t() != crow::json::type::Object) {
+        error = "body must be a JSON object";
+        return false;
+    }
+
+    if (json.has("path_prefix")) {
+        if (json["path_prefix"].t() != crow::json::type::String) {
+            error = "path_prefix must be a string";
+            return false;
+        }
+        std::string prefix = json["path_prefix"].s();
+        while (!prefix.empty() && prefix.back() == '/') prefix.pop_back();
+        while (!prefix.empty() && prefix.front() == '/') prefix.erase(0, 1);
+        if (prefix.empty()) {
+            error = "path_prefix must name a folder";
+            return false;
+        }
+        selection.pathPrefix = prefix;
+        return true;
+    }
+
+    if (json.has("ids")) {
+        const auto& ids = json["ids"];
+        if (ids.t() != crow::json::type::List) {
+            error = "ids must be an array of photo ids";
+            return false;
+        }
+        if (ids.size() > MAX_BATCH_IDS) {
+            error = "too many ids (max 10000)";
+            return false;
+        }
+        for (const auto& id : ids) {
+            if (id.t() != crow::json::type::Number || id.nt() == crow::json::num_type::Floating_point ||
+                id.i() <= 0 || id.i() > std::numeric_limits<int>::max()) {
+                error = "ids must be positive integers";
+                return false;
+            }
+            selection.ids.push_back(static_cast<int>(id.i()));
+        }
+    }
+    if (selection.ids.empty()) {
+        error = "ids or path_prefix required";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads an optional array of strings.
+ * 
+ * @return false (with 'error' set) if the field is not an array of strings.
+ */
+bool parseStringList(const crow::json::rvalue& json, const char* field, std::vector<std::string>& out, std::string& error) {
+    if (!json.has(field)) return true;
+    const auto& list = json[field];
+    if (list.t() != crow::json::type::List) {
+        error = std::string(field) + " must be an array of strings";
+        return false;
+    }
+    for (const auto& item : list) {
+        if (item.t() != crow::json::type::String) {
+            error = std::string(field) + " must be an array of strings";
+            return false;
+        }
+        out.push_back(item.s());
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the changes of a batch update (title, description, keyword lists).
+ * 
+ * @return false (with 'error' set) if a field has the wrong JSON type.
+ */
+bool parseBatchUpdate(const crow::json::rvalue& json, BatchUpdateData& data, std::string& error) {
+    for (const char* field : {"title", "description"}) {
+        if (json.has(field) && json[field].t() != crow::json::type::String) {
+            error = std::string(field) + " must be a string";
+            return false;
+        }
+    }
+    if (json.has("title")) data.title = std::string(json["title"].s());
+    if (json.has("description")) data.description = std::string(json["description"].s());
+    return parseStringList(json, "add_keywords", data.addKeywords, error) &&
+           parseStringList(json, "remove_keywords", data.removeKeywords, error);
+}
+
+crow::json::wvalue batchSummary(const BatchResult& r) {
+    crow::json::wvalue x;
+    x["matched"] = r.matched;
+    x["keywords_added"] = r.keywordsAdded;
+    x["keywords_removed"] = r.keywordsRemoved;
+    return x;
+}
+
+/**
+ * @brief Photo counts per time bucket from the photo_timeline aggregate.
+ * 
+ * @param granularity "year", "month" or "day" (validated by the caller).
+ * @param folder Restrict to this folder (std::nullopt = whole library).
+ * @param recursive Include subfolders of 'folder'.
+ * Runs on a DbExecutor thread.
+ */
+crow::response timeline(const QString& granularity, const std::optional<QString>& folder, bool recursive) {
+    QSqlDatabase db = DbManager::getReadConnection(folder.value_or(QString()));
+    if (!db.isOpen()) return crow::response(500, "DB Connection Error");
+
+    QString where = "count > 0";
+    if (folder && !folder->isEmpty()) {
+        where += recursive ? " AND (file_path = :base OR file_path LIKE :pattern ESCAPE '\\')" : " AND file_path = :base";
+    } else if (folder && !recursive) {
+        where += " AND file_path = ''";
+    }
+
+    QSqlQuery q(db);
+    q.prepare("SELECT date_trunc(:g, day::timestamp)::date AS bucket, "
+              "(date_trunc(:g, day::timestamp) + CAST('1 ' || :g AS interval))::date AS next_bucket, "
+              "sum(count) AS total "
+              "FROM photo_timeline WHERE " + where +
+              " GROUP BY 1, 2 ORDER BY 1 DESC");
+    q.bindValue(":g", granularity);
+    if (folder && !folder->isEmpty()) q.bindValue(":base", *folder);
+    if (folder && !folder->isEmpty() && recursive) q.bindValue(":pattern", DbManager::subfolderPattern(*folder));
+
+    if (!q.exec()) {
+        LOG_CRITICAL << "Timeline Query Failed:" << q.lastError().text();
+        return crow::response(500, R"({"error": "Query failed"})");
+    }
+
+    std::vector<crow::json::wvalue> buckets;
+    while (q.next()) {
+        crow::json::wvalue b;
+        b["date"] = q.value("bucket").toDate().toString(Qt::ISODate).toStdString();
+        b["count"] = q.value("total").toLongLong();
+        // Gallery lists newest first: everything older than the end of the bucket
+        b["before"] = QDateTime(q.value("next_bucket").toDate(), QTime(0, 0)).toString(Qt::ISODate).toStdString();
+        buckets.push_back(std::move(b));
+    }
+
+    crow::json::wvalue result;
+    result["granularity"] = granularity.toStdString();
+    result["buckets"] = std::move(buckets);
+    return crow::response(result);
+}
+
+/**
+ * @brief Map data for a bounding box.
+ * 
+ * Up to GeoIndex::MAX_ZOOM: clusters from the in-memory grid (the representative
+ * photo of each cluster is resolved with one query). Above: single photos from
+ * PostgreSQL via the GiST index on meta_exif. Runs on a DbExecutor thread.
+ */
+crow::response mapPhotos(const GeoIndex::BBox& box, int zoom, int limit, const MediaLinks& links) {
+    QSqlDatabase db = DbManager::getReadConnection();
+    if (!db.isOpen()) return crow::response(500, "DB Connection Error");
+
+    crow::json::wvalue result;
+    std::vector<crow::json::wvalue> items;
+
+    if (zoom <= GeoIndex::MAX_ZOOM) {
+        std::vector<GeoIndex::Cluster> clusters = GeoIndex::clusters(box, zoom);
+
+        QStringList idList;
+        for (const auto& c : clusters) idList << QString::number(c.representative);
+
+        std::unordered_map<std::uint32_t, QString> urls;
+        if (!idList.isEmpty()) {
+            QSqlQuery q(db);
+            q.prepare("SELECT id, file_name, file_path FROM pictures WHERE id = ANY(CAST(:ids AS bigint[]))");
+            q.bindValue(":ids", "{" + idList.join(',') + "}");
+            if (!q.exec()) {
+                LOG_CRITICAL << "Map Representative Query Failed:" << q.lastError().text();
+                return crow::response(500, R"({"error": "Query failed"})");
+            }
+            while (q.next()) {
+                urls[q.value(0).toUInt()] = links.url(q.value(2).toString(), q.value(1).toString());
+            }
+        }
+
+        for (const auto& c : clusters) {
+            crow::json::wvalue item;
+            item["lat"] = c.lat;
+            item["lon"] = c.lon;
+            item["count"] = c.count;
+            item["photo"]["id"] = c.representative;
+            item["photo"]["url"] = urls[c.representative].toStdString();
+            items.push_back(std::move(item));
+        }
+        result["mode"] = "clusters";
+    } else {
+        // Same expression and predicate as idx_meta_exif_gps, so the GiST index is used
+        const QString inBox = "point(e.gps_longitude::float8, e.gps_latitude::float8) <@ box(point(%1, :s), point(%2, :n))";
+        QString boxSql = box.west <= box.east
+            ? inBox.arg(":w", ":e")
+            : "(" + inBox.arg(":w", "180") + " OR " + inBox.arg("-180", ":e") + ")"; // crosses the antimeridian
+
+        QSqlQuery q(db);
+        q.prepare("SELECT p.id, p.file_name, p.file_path, e.gps_latitude, e.gps_longitude "
+                  "FROM meta_exif e JOIN pictures p ON p.id = e.ref_picture "
+                  "WHERE (e.gps_latitude <> 0 OR e.gps_longitude <> 0) AND " + boxSql +
+                  " LIMIT :lim");
+        q.bindValue(":w", box.west);
+        q.bindValue(":s", box.south);
+        q.bindValue(":e", box.east);
+        q.bindValue(":n", box.north);
+        q.bindValue(":lim", limit);
+        if (!q.exec()) {
+            LOG_CRITICAL << "Map Query Failed:" << q.lastError().text();
+            return crow::response(500, R"({"error": "Query failed"})");
+        }
+
+        while (q.next()) {
+            crow::json::wvalue item;
+            item["id"] = q.value(0).toInt();
+            item["name"] = q.value(1).toString().toStdString();
+            item["url"] = links.url(q.value(2).toString(), q.value(1).toString()).toStdString();
+            item["lat"] = q.value(3).toDouble();
+            item["lon"] = q.value(4).toDouble();
+            items.push_back(std::move(item));
+        }
+        result["mode"] = "photos";
+        result["truncated"] = static_cast<int>(items.size()) == limit;
+    }
+
+    result["items"] = std::move(items);
+    return crow::response(result);
+}
+
+}
 
 namespace routes {
 
-void setupGalleryRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
+void setupGalleryRoutes(CrowApp& app) {
 
     CROW_ROUTE(app, "/api/gallery").methods(crow::HTTPMethod::GET)
-    ([](const crow::request& req){
+    ([](const crow::request& req, crow::response& res){
         int page = 1;
         int limit = 100;
         std::string pathFilter = "";
@@ -30,143 +679,318 @@ void setupGalleryRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
         while (!pathFilter.empty() && pathFilter.front() == '/') pathFilter.erase(0, 1);
 
         QString qPath = QString::fromStdString(pathFilter);
+        FacetIndex::Filter filter = facetFilter(req);
 
-        // NEW: Get connection from pool
-        QSqlDatabase db = DbManager::getPostgresConnection();
-        
-        if (!db.isOpen()) return crow::response(500, "DB Connection Error");
-
-        std::vector<crow::json::wvalue> responseList;
-
-        // ---------------------------------------------------------
-        // 1. FIND SUBFOLDERS
-        // ---------------------------------------------------------
-        // We only load folders on page 1, to avoid duplicates when scrolling
-        if (page == 1) {
-            QSqlQuery qFolders(db);
-            QString folderSql;
-
-            if (qPath.isEmpty()) {
-                // Root: First part of the path
-                folderSql = "SELECT DISTINCT split_part(file_path, '/', 1) as folder "
-                            "FROM pictures WHERE file_path <> ''";
-            } else {
-                // Subfolder: Part after current path
-                folderSql = "SELECT DISTINCT split_part(substring(file_path, length(:base) + 2), '/', 1) as folder "
-                            "FROM pictures WHERE file_path LIKE :base || '/%'";
+        QDateTime before;
+        if (const char* b = req.url_params.get("before")) {
+            before = QDateTime::fromString(QString::fromUtf8(b), Qt::ISODate);
+            if (!before.isValid()) {
+                res.code = 400;
+                res.end(R"({"error": "Parameter 'before' must be an ISO date/time"})");
+                return;
             }
-            
-            qFolders.prepare(folderSql);
-            if (!qPath.isEmpty()) {
-                qFolders.bindValue(":base", qPath);
+        }
+
+        // Signed media URLs (MEDIA_SIGNING=1) are issued to a user
+        auto links = MediaLinks::forRequest(req);
+        if (!links) {
+            res.code = 401;
+            res.end(R"({"error": "Login required"})");
+            return;
+        }
+
+        // Unchanged folder: 304 / cached JSON without touching Postgres
+        auto trace = RequestTrace::start("GET /api/gallery");
+        auto cacheStage = trace->stage("cache");
+        const std::string key = galleryCacheKey(page, limit, qPath, foldersOnly, filter, before, *links);
+        const std::uint64_t version = GalleryCache::version(qPath);
+        const std::string etag = GalleryCache::etag(key, version);
+        res.set_header("ETag", etag);
+        res.set_header("Cache-Control", "no-cache");
+
+        if (GalleryCache::notModified(req.get_header_value("If-None-Match"), etag)) {
+            cacheStage.end();
+            trace->finish(res);
+            res.code = 304;
+            res.end();
+            return;
+        }
+        if (auto cached = GalleryCache::get(key, version)) {
+            cacheStage.end();
+            trace->finish(res);
+            res.set_header("Content-Type", "application/json");
+            if (!cached->totalCount.empty()) res.set_header("X-Total-Count", cached->totalCount);
+            res.end(cached->body);
+            return;
+        }
+        cacheStage.end();
+
+        // Query runs on the DB executor, this Crow worker is released immediately
+        DbExecutor::respond(res, trace, [page, limit, qPath, foldersOnly, filter, before, links = *links, key, version, etag]() {
+            crow::response response = listGallery(page, limit, qPath, foldersOnly, filter, before, links);
+            if (response.code == 200) {
+                GalleryCache::put(key, version, {response.body, response.get_header_value("X-Total-Count")});
+                response.set_header("ETag", etag);
+                response.set_header("Cache-Control", "no-cache");
             }
-            
-            if (qFolders.exec()) {
-                while(qFolders.next()) {
-                    QString folderName = qFolders.value(0).toString();
-                    if (folderName.isEmpty()) continue;
-
-                    crow::json::wvalue folderItem;
-                    folderItem["name"] = folderName.toStdString();
-                    folderItem["type"] = "folder";
-                    
-                    QString fullFolderPath = qPath.isEmpty() ? folderName : qPath + "/" + folderName;
-                    folderItem["path"] = fullFolderPath.toStdString();
-                    
-                    responseList.push_back(folderItem);
-                }
-            } else {
-                qWarning() << "Folder Query Failed:" << qFolders.lastError().text();
+            return response;
+        });
+    });
+
+    /**
+     * @brief TIMELINE (photo counts per year / month / day)
+     * 
+     * GET /api/timeline?granularity=year|month|day&path=<folder>&recursive=0|1
+     * Read from the photo_timeline aggregate. Every bucket carries a 'before' cursor
+     * for /api/gallery?before=... which starts the listing at the end of that bucket.
+     */
+    CROW_ROUTE(app, "/api/timeline").methods(crow::HTTPMethod::GET)
+    ([](const crow::request& req, crow::response& res){
+        QString granularity = req.url_params.get("granularity") ? QString::fromUtf8(req.url_params.get("granularity")) : "month";
+        if (granularity != "year" && granularity != "month" && granularity != "day") {
+            res.code = 400;
+            res.end(R"({"error": "granularity must be year, month or day"})");
+            return;
+        }
+
+        std::optional<QString> folder;
+        if (const char* p = req.url_params.get("path")) {
+            QString path = QString::fromUtf8(p);
+            while (path.endsWith('/')) path.chop(1);
+            while (path.startsWith('/')) path.remove(0, 1);
+            folder = path;
+        }
+        const char* rec = req.url_params.get("recursive");
+        bool recursive = !rec || std::string(rec) != "0";
+
+        DbExecutor::respond(res, [granularity, folder, recursive]() {
+            return timeline(granularity, folder, recursive);
+        });
+    });
+
+    /**
+     * @brief FACETS with live counts
+     * 
+     * GET /api/gallery/facets?path=<folder>&limit=<n>&camera=&country=&city=&year=&keyword=a,b
+     * Without 'path' the counts cover the whole library. Answered from memory.
+     */
+    CROW_ROUTE(app, "/api/gallery/facets").methods(crow::HTTPMethod::GET)
+    ([](const crow::request& req){
+        if (!FacetIndex::isReady()) {
+            return crow::response(503, R"({"error": "Facet index not loaded"})");
+        }
+
+        std::optional<QString> folder;
+        if (const char* p = req.url_params.get("path")) {
+            QString path = QString::fromUtf8(p);
+            while (path.endsWith('/')) path.chop(1);
+            while (path.startsWith('/')) path.remove(0, 1);
+            folder = path;
+        }
+        int limit = 20;
+        if (req.url_params.get("limit")) limit = std::clamp(std::atoi(req.url_params.get("limit")), 1, 500);
+
+        std::uint64_t total = 0;
+        FacetIndex::Counts counts = FacetIndex::counts(facetFilter(req), folder, limit, total);
+
+        crow::json::wvalue result;
+        result["total"] = total;
+        for (int f = 0; f < FacetIndex::FacetCount; ++f) {
+            std::vector<crow::json::wvalue> values;
+            for (const auto& c : counts[f]) {
+                crow::json::wvalue v;
+                v["value"] = c.value.toStdString();
+                v["count"] = c.count;
+                values.push_back(std::move(v));
             }
+            result["facets"][FacetIndex::name(static_cast<FacetIndex::Facet>(f))] = std::move(values);
         }
+        return crow::response(result);
+    });
 
-        // ---------------------------------------------------------
-        // 2. PICTURES IN CURRENT FOLDER
-        // ---------------------------------------------------------
-        // Only execute if we are not in pure Tree-Mode
-        if (!foldersOnly) { 
-            int offset = (page - 1) * limit;
-            QSqlQuery qImages(db);
-            
-            // UPDATE: We join meta_iptc and fetch keywords via subselect (Postgres string_agg)
-                QString imgSql = R"(
-                    SELECT 
-                        p.id, p.file_name, p.file_path, p.file_datetime,
-                        l.city, l.country,
-                        e.iso, e.aperture, e.exposure_time, e.model,
-                        i.object_name as title, i.caption as description, i.copyright,
-                        (
-                            SELECT string_agg(k.tag, ',') 
-                            FROM keywords k 
-                            JOIN picture_keywords pk ON k.id = pk.keyword_id 
-                            WHERE pk.picture_id = p.id
-                        ) as keyword_string
-                    FROM pictures p
-                    LEFT JOIN meta_location l ON p.id = l.ref_picture
-                    LEFT JOIN meta_exif e ON p.id = e.ref_picture
-                    LEFT JOIN meta_iptc i ON p.id = i.ref_picture
-                    WHERE p.file_path = :path
-                    ORDER BY p.file_datetime DESC
-                    LIMIT :lim OFFSET :off
-                )";
-
-                qImages.prepare(imgSql);
-                qImages.bindValue(":path", qPath);
-                qImages.bindValue(":lim", limit);
-                qImages.bindValue(":off", offset);
-                
-                if (qImages.exec()) {
-                    while(qImages.next()) {
-                        crow::json::wvalue item;
-                        item["id"] = qImages.value("id").toInt();
-                        item["filename"] = qImages.value("file_name").toString().toStdString();
-                        // We use 'name' in frontend as title if present, otherwise filename
-                        QString dbTitle = qImages.value("title").toString();
-                        item["name"] = dbTitle.isEmpty() ? qImages.value("file_name").toString().toStdString() : dbTitle.toStdString();
-                        
-                        item["type"] = "image";
-                        
-                        // Paths
-                        QString relDir = qImages.value("file_path").toString();
-                        QString fName = qImages.value("file_name").toString();
-                        QString fullUrl = "/media/";
-                        if (!relDir.isEmpty()) fullUrl += relDir + "/";
-                        fullUrl += fName;
-                        item["url"] = fullUrl.toStdString();
-                        
-                        // Date
-                        QDateTime dt = qImages.value("file_datetime").toDateTime();
-                        item["date"] = dt.isValid() ? dt.toString(Qt::ISODate).toStdString() : "";
-
-                        // Metadata
-                        item["city"] = qImages.value("city").toString().toStdString();
-                        item["country"] = qImages.value("country").toString().toStdString();
-                        
-                        QString cam = qImages.value("model").toString();
-                        if (!cam.isEmpty()) item["camera"] = cam.toStdString();
-                        
-                        // --- NEW: Send IPTC Data ---
-                        item["title"] = dbTitle.toStdString();
-                        item["description"] = qImages.value("description").toString().toStdString();
-                        item["copyright"] = qImages.value("copyright").toString().toStdString();
-                        
-                        // Keywords come as "Tag1,Tag2,Tag3" string from DB
-                        // We send it as string, the frontend splits it
-                        item["keywords_string"] = qImages.value("keyword_string").toString().toStdString();
-
-                        responseList.push_back(item);
-                    }
-            } else {
-                 qCritical() << "Image Query Failed:" << qImages.lastError().text();
+
+    /**
+     * @brief SEARCH Photos (full-text)
+     * 
+     * GET /api/search?q=<text>&limit=<n>&cursor=<next_cursor>
+     */
+    CROW_ROUTE(app, "/api/search").methods(crow::HTTPMethod::GET)
+    ([](const crow::request& req, crow::response& res){
+        const char* text = req.url_params.get("q");
+        if (!text || std::string(text).empty()) {
+            res.code = 400;
+            res.end(R"({"error": "Parameter 'q' missing"})");
+            return;
+        }
+
+        int limit = 50;
+        if (req.url_params.get("limit")) limit = std::clamp(std::atoi(req.url_params.get("limit")), 1, 200);
+        std::optional<SearchCursor> cursor;
+        if (const char* c = req.url_params.get("cursor"); c && *c) {
+            cursor = parseSearchCursor(QString::fromUtf8(c));
+            if (!cursor) {
+                res.code = 400;
+                res.end(R"({"error": "Parameter 'cursor' must be a next_cursor value"})");
+                return;
             }
         }
+        QString qText = QString::fromUtf8(text);
 
-        crow::json::wvalue result = std::move(responseList);
+        // Signed media URLs (MEDIA_SIGNING=1) are issued to a user
+        auto links = MediaLinks::forRequest(req);
+        if (!links) {
+            res.code = 401;
+            res.end(R"({"error": "Login required"})");
+            return;
+        }
+
+        DbExecutor::respond(res, RequestTrace::start("GET /api/search"), [qText, limit, cursor, links = *links]() {
+            return searchPhotos(qText, limit, cursor, links);
+        });
+    });
+
+    /**
+     * @brief MAP (photos inside a bounding box)
+     * 
+     * GET /api/map?bbox=<west>,<south>,<east>,<north>&zoom=<z>&limit=<n>
+     * Returns clusters up to zoom GeoIndex::MAX_ZOOM, single photos above.
+     */
+    CROW_ROUTE(app, "/api/map").methods(crow::HTTPMethod::GET)
+    ([](const crow::request& req, crow::response& res){
+        GeoIndex::BBox box;
+        if (const char* b = req.url_params.get("bbox")) {
+            QStringList parts = QString::fromUtf8(b).split(',');
+            bool ok = parts.size() == 4;
+            double v[4] = {0, 0, 0, 0};
+            // toDouble() also accepts "nan" and "inf"
+            for (int i = 0; ok && i < 4; ++i) {
+                v[i] = parts[i].trimmed().toDouble(&ok);
+                ok = ok && std::isfinite(v[i]);
+            }
+            if (!ok) {
+                res.code = 400;
+                res.end(R"({"error": "Parameter 'bbox' must be west,south,east,north"})");
+                return;
+            }
+            box = GeoIndex::BBox{v[0], v[1], v[2], v[3]};
+        }
+
+        int zoom = 0;
+        if (req.url_params.get("zoom")) zoom = std::clamp(std::atoi(req.url_params.get("zoom")), 0, 22);
+        int limit = 500;
+        if (req.url_params.get("limit")) limit = std::clamp(std::atoi(req.url_params.get("limit")), 1, 2000);
+
+        // Signed media URLs (MEDIA_SIGNING=1) are issued to a user
+        auto links = MediaLinks::forRequest(req);
+        if (!links) {
+            res.code = 401;
+            res.end(R"({"error": "Login required"})");
+            return;
+        }
+
+        DbExecutor::respond(res, [box, zoom, limit, links = *links]() {
+            return mapPhotos(box, zoom, limit, links);
+        });
+    });
+
+    /**
+     * @brief KEYWORD Autocomplete (for the metadata editor)
+     * 
+     * GET /api/keywords/suggest?prefix=<text>&limit=<n>
+     * Answered from memory, most used tags first.
+     */
+    CROW_ROUTE(app, "/api/keywords/suggest")
+        .methods(crow::HTTPMethod::GET)
+        .CROW_MIDDLEWARES(app, AuthMiddleware)
+    ([](const crow::request& req){
+        QString prefix = req.url_params.get("prefix") ? QString::fromUtf8(req.url_params.get("prefix")).trimmed() : QString();
+        int limit = 10;
+        if (req.url_params.get("limit")) limit = std::clamp(std::atoi(req.url_params.get("limit")), 1, 100);
+
+        std::vector<crow::json::wvalue> list;
+        for (const auto& s : KeywordIndex::suggest(prefix, limit)) {
+            crow::json::wvalue item;
+            item["tag"] = s.tag.toStdString();
+            item["count"] = s.usage;
+            list.push_back(std::move(item));
+        }
+        crow::json::wvalue result = std::move(list);
         return crow::response(result);
-        
-        // IMPORTANT: Connection is NOT closed, remains in Pool.
     });
 
+    /**
+     * @brief BATCH UPDATE Photo Metadata (one transaction)
+     * 
+     * POST /api/gallery/batch/update
+     * Body: {"ids": [1,2] | "path_prefix": "2024/Trip", "title"?, "description"?,
+     *        "add_keywords"?: [...], "remove_keywords"?: [...]}
+     */
+    CROW_ROUTE(app, "/api/gallery/batch/update")
+        .methods(crow::HTTPMethod::POST)
+        .CROW_MIDDLEWARES(app, AuthMiddleware)
+    ([](const crow::request& req, crow::response& res){
+        auto json = crow::json::load(req.body);
+        if (!json) {
+            res.code = 400;
+            res.end(R"({"error": "Invalid JSON"})");
+            return;
+        }
+
+        PhotoSelection selection;
+        std::string error;
+        if (!parseSelection(json, selection, error)) {
+            res.code = 400;
+            res.end("{\"error\": \"" + error + "\"}");
+            return;
+        }
+
+        BatchUpdateData data;
+        if (!parseBatchUpdate(json, data, error)) {
+            res.code = 400;
+            res.end("{\"error\": \"" + error + "\"}");
+            return;
+        }
+
+        DbExecutor::respond(res, [selection, data]() {
+            BatchResult r = DbManager::batchUpdatePhotos(selection, data);
+            if (!r.ok) return crow::response(500, R"({"error": "Batch update failed"})");
+            return crow::response(batchSummary(r));
+        });
+    });
+
+    /**
+     * @brief BATCH DELETE Photos (one statement, files removed in the background)
+     * 
+     * POST /api/gallery/batch/delete
+     * Body: {"ids": [1,2] | "path_prefix": "2024/Trip"}
+     */
+    CROW_ROUTE(app, "/api/gallery/batch/delete")
+        .methods(crow::HTTPMethod::POST)
+        .CROW_MIDDLEWARES(app, AuthMiddleware)
+    ([](const crow::request& req, crow::response& res){
+        auto json = crow::json::load(req.body);
+        if (!json) {
+            res.code = 400;
+            res.end(R"({"error": "Invalid JSON"})");
+            return;
+        }
+
+        PhotoSelection selection;
+        std::string error;
+        if (!parseSelection(json, selection, error)) {
+            res.code = 400;
+            res.end("{\"error\": \"" + error + "\"}");
+            return;
+        }
+
+        DbExecutor::respond(res, [selection]() {
+            BatchResult r = DbManager::deletePhotos(selection);
+            if (!r.ok) return crow::response(500, R"({"error": "Batch delete failed"})");
+            crow::json::wvalue x;
+            x["deleted"] = r.matched;
+            return crow::response(x);
+        });
+    });
 
 /**
  * @brief DELETE Photo
@@ -177,13 +1001,13 @@ void setupGalleryRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
         .CROW_MIDDLEWARES(app, AuthMiddleware)
     ([](const crow::request&, crow::response& res, int id){
         
-        if (DbManager::deletePhoto(id)) {
-            res.code = 200;
-            res.end(R"({"status": "deleted"})");
-        } else {
-            res.code = 404; // Or 500, but mostly ID is not found
-            res.end(R"({"error": "Could not delete photo"})");
-        }
+        DbExecutor::respond(res, [id]() {
+            if (DbManager::deletePhoto(id)) {
+                return crow::response(200, R"({"status": "deleted"})");
+            }
+            // Or 500, but mostly ID is not found
+            return crow::response(404, R"({"error": "Could not delete photo"})");
+        });
     });
 
     /**
@@ -215,13 +1039,12 @@ void setupGalleryRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
             }
         }
 
-        if (DbManager::updatePhotoMetadata(id, data)) {
-            res.code = 200;
-            res.end(R"({"status": "updated"})");
-        } else {
-            res.code = 500;
-            res.end(R"({"error": "Update failed"})");
-        }
+        DbExecutor::respond(res, [id, data]() {
+            if (DbManager::updatePhotoMetadata(id, data)) {
+                return crow::response(200, R"({"status": "updated"})");
+            }
+            return crow::response(500, R"({"error": "Update failed"})");
+        });
     });
 }
 }
\ No newline at end of file
@@ -0,0 +1,367 @@
+/**
+ * @file media_controller.cpp
+ * @brief Implementation of the /media route.
+ */
+#include "controllers/media_controller.hpp"
+#include "media_files.hpp"
+#include "image_processor.hpp"
+#include "media_signer.hpp"
+#include "utils.hpp"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QUrl>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <ctime>
+#include <optional>
+#include <string_view>
+
+namespace {
+
+/**
+ * @brief Reads a positive integer from the environment.
+ */
+std::uint64_t envBytes(const char* name, std::uint64_t fallback) {
+    const char* env = std::getenv(name);
+    long long value = env ? std::atoll(env) : 0;
+    return value > 0 ? static_cast<std::uint64_t>(value) : fallback;
+}
+
+/**
+ * @brief Formats a timestamp as HTTP-date ("Sun, 06 Nov 1994 08:49:37 GMT").
+ */
+std::string httpDate(std::time_t t) {
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    char buf[40];
+    std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buf;
+}
+
+/**
+ * @brief A single byte range "bytes=a-b" / "bytes=a-" / "bytes=-n".
+ */
+struct ByteRange {
+    std::uint64_t first = 0;
+    std::uint64_t last = 0; ///< Inclusive.
+};
+
+/**
+ * @brief Parses a Range header for a file of the given size.
+ *
+ * @param valid Set to false if the header is syntactically wrong or
+ *              unsatisfiable (-> 416).
+ * @return The range, or std::nullopt to serve the whole file (no / multiple ranges).
+ */
+std::optional<ByteRange> parseRange(std::string_view header, std::uint64_t size, bool& valid) {
+    valid = true;
+    if (!header.starts_with("bytes=")) return std::nullopt;
+    header.remove_prefix(6);
+    if (header.find(',') != std::string_view::npos) return std::nullopt; // multipart ranges: full file
+
+    std::size_t dash = header.find('-');
+    if (dash == std::string_view::npos) {
+        valid = false;
+        return std::nullopt;
+    }
+    std::string_view a = header.substr(0, dash);
+    std::string_view b = header.substr(dash + 1);
+
+    auto number = [](std::string_view s, std::uint64_t& out) {
+        auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+        return ec == std::errc() && ptr == s.data() + s.size();
+    };
+
+    ByteRange range;
+    if (a.empty()) {
+        // Suffix range: last n bytes
+        std::uint64_t n = 0;
+        if (!number(b, n) || n == 0 || size == 0) {
+            valid = false;
+            return std::nullopt;
+        }
+        range.first = size - std::min(n, size);
+        range.last = size - 1;
+    } else {
+        if (!number(a, range.first) || range.first >= size) {
+            valid = false;
+            return std::nullopt;
+        }
+        range.last = size - 1;
+        if (!b.empty()) {
+            std::uint64_t last = 0;
+            if (!number(b, last) || last < range.first) {
+                valid = false;
+                return std::nullopt;
+            }
+            range.last = std::min(last, size - 1);
+        }
+    }
+    return range;
+}
+
+/**
+ * @brief Decodes the URL path below /media/ and rejects anything leaving the media root.
+ */
+std::optional<std::string> safeRelativePath(const std::string& raw) {
+    QString path = QUrl::fromPercentEncoding(QByteArray::fromStdString(raw));
+    if (path.isEmpty() || path.startsWith('/') || path.contains(QChar(0)) || path.contains('\\')) return std::nullopt;
+    for (const QString& segment : path.split('/')) {
+        if (segment.isEmpty() || segment == "." || segment == "..") return std::nullopt;
+    }
+    return path.toStdString();
+}
+
+/**
+ * @brief Headers the response of an original may vary on (client hints, Accept).
+ */
+constexpr const char* NEGOTIATION_VARY = "Accept, Sec-CH-Width, Sec-CH-DPR, Width, DPR";
+
+/**
+ * @brief MIME type by file extension (application/octet-stream if unknown).
+ */
+std::string mimeType(const std::string& path) {
+    std::size_t dot = path.rfind('.');
+    if (dot == std::string::npos) return "application/octet-stream";
+    std::string ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    auto mime = crow::mime_types.find(ext);
+    return mime != crow::mime_types.end() ? mime->second : "application/octet-stream";
+}
+
+/**
+ * @brief Positive number of the first present client hint header (0 if none).
+ */
+double headerHint(const crow::request& req, std::initializer_list<const char*> headers) {
+    for (const char* header : headers) {
+        const std::string value = req.get_header_value(header);
+        if (!value.empty()) return std::max(0.0, std::atof(value.c_str()));
+    }
+    return 0.0;
+}
+
+/**
+ * @brief Picks the smallest WebP version that covers the requested width.
+ *
+ * The width comes from ?w= (CSS pixels, times ?dpr= / DPR hint) or the Width
+ * hint (already device pixels). Only clients accepting image/webp get a version;
+ * everyone else keeps the original (JPEG). Versions that were not generated
+ * (original narrower than the target) are skipped; if no version is wide
+ * enough the original is served as well.
+ *
+ * @return Path of the version relative to the media root, or std::nullopt.
+ */
+std::optional<std::string> negotiatedVersion(const crow::request& req, const std::string& root,
+                                             const std::string& relPath) {
+    double width = 0;
+    if (const char* w = req.url_params.get("w")) {
+        const char* dprParam = req.url_params.get("dpr");
+        const double dpr = dprParam ? std::atof(dprParam) : headerHint(req, {"Sec-CH-DPR", "DPR"});
+        width = std::atof(w) * std::clamp(dpr > 0 ? dpr : 1.0, 1.0, 4.0);
+    } else {
+        width = headerHint(req, {"Sec-CH-Width", "Width"});
+    }
+    if (width <= 0) return std::nullopt;
+    if (req.get_header_value("Accept").find("image/webp") == std::string::npos) return std::nullopt;
+
+    const QFileInfo original(QString::fromStdString(relPath));
+    const QString dir = original.path() == "." ? QString() : original.path() + "/";
+    for (int target : ImageProcessor::TARGET_WIDTHS) {
+        if (target < width) continue;
+        std::string version = (dir + "webp/" + ImageProcessor::versionFileName(original.completeBaseName(), target))
+                                  .toStdString();
+        if (MediaFiles::open(root + "/" + version)) return version;
+    }
+    return std::nullopt;
+}
+
+}
+
+namespace routes {
+
+void setupMediaRoutes(CrowApp& app) {
+
+    /**
+     * @brief Originals and WebP versions below Photos/ (MEDIA_ROOT).
+     *
+     * Strong ETag + Last-Modified with 304, single byte ranges (206 / 416),
+     * long-lived caching for the WebP versions. Small files and ranges are read
+     * with pread() from the MediaFiles descriptor cache; whole files above
+     * MEDIA_INLINE_MAX are streamed from disk by Crow.
+     *
+     * Originals are negotiated: with ?w= or Width / DPR client hints and WebP
+     * support, the smallest adequate WebP version is sent instead
+     * (Content-Location names it).
+     *
+     * With MEDIA_SIGNING=1 only URLs signed by the gallery API are served
+     * (?exp=&u=&sig=, see MediaSigner). With MEDIA_ACCEL_PREFIX set, a verified
+     * request is answered with X-Accel-Redirect and NGINX sends the file.
+     */
+    CROW_ROUTE(app, "/media/<path>")
+    ([](const crow::request& req, crow::response& res, std::string rawPath){
+        const std::string& root = MediaFiles::root();
+        static const std::uint64_t inlineMax = envBytes("MEDIA_INLINE_MAX", 1024 * 1024);
+        static const std::uint64_t rangeChunk = envBytes("MEDIA_RANGE_CHUNK", 4 * 1024 * 1024);
+        static const std::string derivativeCache =
+            "public, max-age=" + std::to_string(envBytes("MEDIA_MAX_AGE", 30 * 24 * 3600));
+        static const std::string accelPrefix = [] {
+            const char* env = std::getenv("MEDIA_ACCEL_PREFIX");
+            return std::string(env ? env : "");
+        }();
+
+        auto relPath = safeRelativePath(rawPath);
+        if (!relPath) {
+            res.code = 403;
+            res.end();
+            return;
+        }
+
+        // Signed URL: one HMAC over (path, expiry, user), no JWT
+        std::string cacheControl;
+        if (MediaSigner::enabled()) {
+            const char* exp = req.url_params.get("exp");
+            const char* user = req.url_params.get("u");
+            const char* sig = req.url_params.get("sig");
+            const std::int64_t expires = exp ? std::atoll(exp) : 0;
+            if (!exp || !user || !sig || !MediaSigner::verify(*relPath, user, expires, sig)) {
+                res.code = 403;
+                res.end();
+                return;
+            }
+            // The URL itself expires: private, and not cached beyond the expiry
+            const std::int64_t remaining = expires - static_cast<std::int64_t>(std::time(nullptr));
+            cacheControl = "private, max-age=" + std::to_string(std::max<std::int64_t>(remaining, 0));
+        }
+
+        // WebP versions are regenerated under the same name only on re-upload,
+        // originals may be replaced more often
+        const bool derivative = relPath->starts_with("webp/") || relPath->find("/webp/") != std::string::npos;
+
+        // Originals: smallest adequate WebP version if the client asked for a width
+        std::string servedPath = *relPath;
+        bool negotiated = false;
+        bool negotiable = false;
+        if (!derivative) {
+            negotiable = mimeType(*relPath).starts_with("image/");
+            if (negotiable) {
+                if (auto version = negotiatedVersion(req, root, *relPath)) {
+                    servedPath = std::move(*version);
+                    negotiated = true;
+                }
+            }
+        }
+
+        const std::string encodedPath = QUrl::toPercentEncoding(QString::fromStdString(servedPath), "/").toStdString();
+        if (cacheControl.empty()) cacheControl = derivative ? derivativeCache : "public, max-age=86400";
+
+        // Verified here, bytes from NGINX (sendfile, ranges, validators)
+        if (!accelPrefix.empty()) {
+            res.set_header("X-Accel-Redirect", accelPrefix + encodedPath);
+            res.set_header("Content-Type", mimeType(servedPath));
+            res.set_header("Cache-Control", cacheControl);
+            if (negotiable) res.set_header("Vary", NEGOTIATION_VARY);
+            res.end();
+            return;
+        }
+
+        const std::string fullPath = root + "/" + servedPath;
+        auto file = MediaFiles::open(fullPath);
+        if (!file) {
+            res.code = 404;
+            res.end();
+            return;
+        }
+
+        const std::string etag = file->etag();
+        const std::string lastModified = httpDate(file->mtime.tv_sec);
+
+        const std::string contentType = mimeType(servedPath);
+
+        auto setHeaders = [&](crow::response& r) {
+            r.set_header("ETag", etag);
+            r.set_header("Last-Modified", lastModified);
+            r.set_header("Accept-Ranges", "bytes");
+            r.set_header("Cache-Control", cacheControl);
+            if (negotiable) {
+                r.set_header("Vary", NEGOTIATION_VARY);
+                r.set_header("Accept-CH", "Sec-CH-Width, Sec-CH-DPR");
+            }
+            if (negotiated) r.set_header("Content-Location", "/media/" + encodedPath);
+        };
+
+        // --- Conditional GET ---
+        const std::string ifNoneMatch = req.get_header_value("If-None-Match");
+        bool notModified = false;
+        if (!ifNoneMatch.empty()) {
+            notModified = utils::etagMatches(ifNoneMatch, etag);
+        } else if (const std::string ims = req.get_header_value("If-Modified-Since"); !ims.empty()) {
+            QDateTime since = QDateTime::fromString(QString::fromStdString(ims), Qt::RFC2822Date);
+            notModified = since.isValid() && file->mtime.tv_sec <= since.toSecsSinceEpoch();
+        }
+        if (notModified) {
+            setHeaders(res);
+            res.code = 304;
+            res.end();
+            return;
+        }
+
+        // --- Range request (ignored if If-Range no longer matches) ---
+        const std::string rangeHeader = req.get_header_value("Range");
+        const std::string ifRange = req.get_header_value("If-Range");
+        if (!rangeHeader.empty() && (ifRange.empty() || ifRange == etag || ifRange == lastModified)) {
+            bool valid = true;
+            std::optional<ByteRange> range = parseRange(rangeHeader, file->size, valid);
+            if (!valid) {
+                res.code = 416;
+                res.set_header("Content-Range", "bytes */" + std::to_string(file->size));
+                res.end();
+                return;
+            }
+            if (range) {
+                // Ranges are answered in chunks of at most MEDIA_RANGE_CHUNK; Content-Range
+                // names the bytes actually sent and the client asks for the rest
+                range->last = std::min(range->last, range->first + rangeChunk - 1);
+
+                std::string body;
+                if (!file->read(range->first, range->last - range->first + 1, body)) {
+                    res.code = 500;
+                    res.end();
+                    return;
+                }
+                setHeaders(res);
+                res.code = 206;
+                res.set_header("Content-Type", contentType);
+                res.set_header("Content-Range", "bytes " + std::to_string(range->first) + "-" +
+                                                    std::to_string(range->last) + "/" + std::to_string(file->size));
+                res.end(body);
+                return;
+            }
+        }
+
+        // --- Whole file ---
+        if (file->size > inlineMax) {
+            res.set_static_file_info_unsafe(fullPath); // path already validated
+            setHeaders(res);
+            res.set_header("Content-Type", contentType);
+            res.end();
+            return;
+        }
+
+        std::string body;
+        if (!file->read(0, file->size, body)) {
+            res.code = 500;
+            res.end();
+            return;
+        }
+        setHeaders(res);
+        res.set_header("Content-Type", contentType);
+        res.end(body);
+    });
+}
+
+}
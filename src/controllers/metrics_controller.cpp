@@ -0,0 +1,72 @@
+/**
+ * @file metrics_controller.cpp
+ * @brief Implementation of the /metrics route.
+ */
+#include "controllers/metrics_controller.hpp"
+#include "metrics.hpp"
+#include "db_executor.hpp"
+#include "image_processor.hpp"
+#include "deletion_queue.hpp"
+#include "media_files.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace {
+
+/**
+ * @brief Resident set size of the process in bytes (from /proc/self/statm).
+ */
+double residentBytes() {
+    std::FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    const int n = std::fscanf(f, "%lu %lu", &size, &resident);
+    std::fclose(f);
+    return n == 2 ? static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+}
+
+namespace routes {
+
+void setupMetricsRoutes(CrowApp& app) {
+    Metrics::gauge("db_executor_threads", "Size of the DB thread pool (one PostgreSQL connection each)",
+                   [] { return DbExecutor::threadCount(); });
+    Metrics::gauge("db_executor_busy_threads", "DB threads currently running a job",
+                   [] { return DbExecutor::activeThreads(); });
+    Metrics::gauge("db_executor_pending_jobs", "DB jobs queued or running",
+                   [] { return DbExecutor::pending(); });
+    Metrics::gauge("image_processing_pending", "WebP jobs queued or running",
+                   [] { return ImageProcessor::pendingJobs(); });
+    Metrics::gauge("deletion_queue_pending", "Deleted files whose WebP versions wait for removal",
+                   [] { return DeletionQueue::pending(); });
+    Metrics::gauge("media_open_files", "Cached descriptors of the /media route",
+                   [] { return static_cast<double>(MediaFiles::cachedCount()); });
+    Metrics::gauge("process_resident_memory_bytes", "Resident memory size in bytes", residentBytes);
+
+    /**
+     * @brief Prometheus scrape endpoint (text format 0.0.4).
+     *
+     * Public like /system/stats, unless METRICS_TOKEN is set: then the scraper
+     * has to send "Authorization: Bearer <METRICS_TOKEN>".
+     */
+    CROW_ROUTE(app, "/metrics")
+    ([](const crow::request& req){
+        static const std::string token = [] {
+            const char* env = std::getenv("METRICS_TOKEN");
+            return std::string(env ? env : "");
+        }();
+        if (!token.empty() && req.get_header_value("Authorization") != "Bearer " + token) {
+            return crow::response(401);
+        }
+
+        crow::response res(Metrics::render());
+        res.set_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+        return res;
+    });
+}
+
+}
@@ -6,19 +6,34 @@
 #include "metadata_extractor.hpp"
 #include "image_processor.hpp"
 #include "db_manager.hpp"
+#include "db_executor.hpp"
 #include "utils.hpp"
+#include "metrics.hpp"
+#include "logger.hpp"
+#include "request_trace.hpp"
+#include "media_links.hpp"
 
 #include <QDir>
 #include <QFile>
 #include <QDateTime>
 #include <QString>
 #include <QDebug>
-#include <QThreadPool>
 #include <QRegularExpression>
 
+namespace {
+
+/**
+ * @brief Duration histogram of one upload stage.
+ */
+Metrics::Histogram& stageTime(const char* stage) {
+    return Metrics::histogram("upload_stage_seconds", "Duration of the upload stages", Metrics::labels({{"stage", stage}}));
+}
+
+}
+
 namespace routes {
 
-void setupUploadRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
+void setupUploadRoutes(CrowApp& app) {
 
     CROW_ROUTE(app, "/upload")
         .methods(crow::HTTPMethod::POST)
@@ -34,7 +49,26 @@ void setupUploadRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
              return;
         }
         
+        static auto& parseTime = stageTime("parse");
+        static auto& sanitizeTime = stageTime("sanitize");
+        static auto& writeTime = stageTime("write_temp");
+        static auto& metadataTime = stageTime("metadata");
+        static auto& storeTime = stageTime("store");
+        static auto& dbTime = stageTime("db_insert");
+        static auto& bytesWritten = Metrics::counter("photos_bytes_written_total", "Bytes written below Photos/",
+                                                     Metrics::labels({{"kind", "original"}}));
+
+        // Stage timings: Server-Timing header, /metrics, optional OTLP spans
+        auto trace = RequestTrace::start("POST /upload");
+        // Early exits also get Server-Timing and a span (finish() before end())
+        auto fail = [&res, &trace](int code, const char* body) {
+            trace->finish(res);
+            res.code = code;
+            res.end(body);
+        };
+
         // 1. Parse Multipart
+        auto parseStage = trace->stage("parse", &parseTime);
         crow::multipart::message msg(req);
         const crow::multipart::part* photoPart = nullptr;
         QString userSubDir = "";
@@ -52,12 +86,15 @@ void setupUploadRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
             }
         }
 
+        parseStage.end();
+
         if (!photoPart) {
-            res.code = 400;
-            res.end(R"({"error": "Part 'photo' missing"})");
+            fail(400, R"({"error": "Part 'photo' missing"})");
             return;
         }
 
+        auto sanitizeStage = trace->stage("sanitize", &sanitizeTime);
+
         // ---------------------------------------------------------
         // CLEAN PATH (FIX FOR DOUBLE SLASHES)
         // ---------------------------------------------------------
@@ -72,8 +109,8 @@ void setupUploadRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
 
         // 3. Security Checks (Directory Traversal)
         if (userSubDir.contains("../") || userSubDir.contains("/..") || userSubDir == ".." || userSubDir.contains("\\")) {
-            res.code = 403; 
-            res.end(R"({"error": "Security Violation: Invalid path components."})");
+            sanitizeStage.end();
+            fail(403, R"({"error": "Security Violation: Invalid path components."})");
             return;
         }
 
@@ -116,11 +153,13 @@ void setupUploadRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
         qFilename.remove(controlChars);
 
         if (!utils::isAllowedImage(qFilename.toStdString())) {
-            res.code = 400;
-            res.end(R"({"error": "Invalid file type"})");
+            sanitizeStage.end();
+            fail(400, R"({"error": "Invalid file type"})");
             return;
         }
 
+        sanitizeStage.end();
+
         // Determine User
         auto& ctx = app.get_context<AuthMiddleware>(req);
         QString uploader = QString::fromStdString(ctx.current_user);
@@ -137,21 +176,28 @@ void setupUploadRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
         QDir().mkpath(tempDir);
         QString tempPath = tempDir + "/" + tempFileName;
 
-        QFile file(tempPath);
-        if (!file.open(QIODevice::WriteOnly)) {
-            res.code = 500;
-            res.end(R"({"error": "Server Error: Could not save temp file."})");
-            return;
+        {
+            auto stage = trace->stage("write_temp", &writeTime);
+            QFile file(tempPath);
+            if (!file.open(QIODevice::WriteOnly)) {
+                stage.end();
+                fail(500, R"({"error": "Server Error: Could not save temp file."})");
+                return;
+            }
+            file.write(photoPart->body.data(), photoPart->body.size());
+            file.close();
         }
-        file.write(photoPart->body.data(), photoPart->body.size());
-        file.close();
 
         // ---------------------------------------------------------
         // WORKER LOGIC
         // ---------------------------------------------------------
 
         // A. Read metadata from temp file
-        PhotoData meta = MetadataExtractor::extract(tempPath.toStdString());
+        PhotoData meta;
+        {
+            auto stage = trace->stage("metadata", &metadataTime);
+            meta = MetadataExtractor::extract(tempPath.toStdString());
+        }
 
         // B. Determine destination path
         QString finalRoot = "Photos"; 
@@ -159,8 +205,7 @@ void setupUploadRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
         
         if (!QDir().mkpath(finalRoot)) {
             QFile::remove(tempPath);
-            res.code = 500;
-            res.end(R"({"error": "Server Error: Could not create destination directory."})");
+            fail(500, R"({"error": "Server Error: Could not create destination directory."})");
             return;
         }
 
@@ -168,33 +213,31 @@ void setupUploadRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
         QString finalFullPath = finalRoot + "/" + finalCleanName; // <-- CHANGE
 
         // C. Move (Overwrite Logic...)
+        auto storeStage = trace->stage("store", &storeTime);
         if (QFile::exists(finalFullPath)) {
             if (!QFile::remove(finalFullPath)) {
-                qWarning() << "Could not overwrite existing file:" << finalFullPath;
+                LOG_WARNING << "Could not overwrite existing file:" << finalFullPath;
                 // Optional: Here logic for "image_1.jpg" could be added
             }
         }
         
         if (!QFile::rename(tempPath, finalFullPath)) {
-            qCritical() << "Failed to move file from" << tempPath << "to" << finalFullPath;
+            LOG_CRITICAL << "Failed to move file from" << tempPath << "to" << finalFullPath;
             QFile::remove(tempPath); 
-            res.code = 500;
-            res.end(R"({"error": "Server Error: Failed to move file to storage."})");
+            storeStage.end();
+            fail(500, R"({"error": "Server Error: Failed to move file to storage."})");
             return;
         }
+        storeStage.end();
+        bytesWritten.inc(photoPart->body.size());
 
         // --- Start WebP Generation ---
         // We pass the full path to the new image and the folder
         // finalFullPath: "Photos/2025/Bild.jpg"
         // finalRoot:     "Photos/2025"
         
-        // We use QThreadPool for Fire&Forget. 
-        // IMPORTANT: We must copy QStrings into the lambda (capture by value),
-        // as references become invalid once this request block ends.
-        QThreadPool::globalInstance()->start([finalFullPath, finalRoot](){
-            ImageProcessor::generateWebPVersions(finalFullPath, finalRoot);
-            qDebug() << "Background processing finished for:" << finalFullPath;
-        });
+        // Fire&Forget on the global QThreadPool (queue depth and time in /metrics)
+        ImageProcessor::enqueueWebPVersions(finalFullPath, finalRoot);
 
         // D. Prepare DB Insert Payload
         WorkerPayload payload;
@@ -211,33 +254,37 @@ void setupUploadRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
         }
         payload.meta = meta;
 
-        // E. DB Insert
-        bool dbSuccess = DbManager::insertPhoto(payload);
+        // URL for Frontend (signed for the uploader with MEDIA_SIGNING=1)
+        std::string urlPath = MediaLinks::forUser(uploader.toStdString())
+                                  .url(userSubDir, finalCleanName) // <-- CHANGE: URL uses clean name
+                                  .toStdString();
+
+        // E. DB Insert (on the DB executor, the response is completed there)
+        DbExecutor::respond(res, trace, [payload, finalFullPath, urlPath]() {
+            bool dbSuccess = false;
+            {
+                Metrics::Timer timer(dbTime);
+                dbSuccess = DbManager::insertPhoto(payload);
+            }
 
-        // ---------------------------------------------------------
-        // RESPONSE
-        // ---------------------------------------------------------
-        
-        crow::json::wvalue json;
-        if (dbSuccess) {
-            json["status"] = "success";
-            json["message"] = "File uploaded.";
-        } else {
-            json["status"] = "partial_success";
-            json["message"] = "File saved, DB error.";
-        }
+            // ---------------------------------------------------------
+            // RESPONSE
+            // ---------------------------------------------------------
+            
+            crow::json::wvalue json;
+            if (dbSuccess) {
+                json["status"] = "success";
+                json["message"] = "File uploaded.";
+            } else {
+                json["status"] = "partial_success";
+                json["message"] = "File saved, DB error.";
+            }
 
-        json["path"] = finalFullPath.toStdString();
-        
-        // URL for Frontend
-        std::string urlPath = "/media/";
-        if (!userSubDir.isEmpty()) urlPath += userSubDir.toStdString() + "/";
-        urlPath += finalCleanName.toStdString(); // <-- CHANGE: URL uses clean name
-        json["url"] = urlPath;
-        
-        res.code = 201;
-        res.write(json.dump());
-        res.end();
+            json["path"] = finalFullPath.toStdString();
+            json["url"] = urlPath;
+            
+            return crow::response(201, json.dump());
+        });
     });
 }
 
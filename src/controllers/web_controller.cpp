@@ -4,13 +4,102 @@
  */
 #include "controllers/web_controller.hpp"
 #include "rz_config.hpp" 
+#include "db_executor.hpp"
+#include "replica_router.hpp"
+#include "facet_index.hpp"
+#include "keyword_index.hpp"
+#include "geo_index.hpp"
+#include "reverse_geocoder.hpp"
+#include "deletion_queue.hpp"
+#include "gallery_cache.hpp"
+#include "compression.hpp"
+#include "compression_middleware.hpp"
+#include "static_assets.hpp"
+#include "template_registry.hpp"
+#include "media_files.hpp"
+#include "utils.hpp"
+#include <algorithm>
 #include <filesystem>
 
 namespace fs = std::filesystem;
 
+namespace {
+
+    /**
+     * @brief Serves a file too large for StaticAssets, preferring its .gz / .zst sibling.
+     *
+     * The variant is only used while it is not older than the file itself.
+     */
+    void serveFromDisk(const crow::request& req, crow::response& res, const std::string& path) {
+        const auto encoding = Compression::negotiate(req.get_header_value("Accept-Encoding"));
+        const std::string variant = path + Compression::fileSuffix(encoding);
+        bool fresh = false;
+        std::error_code ec;
+        if (encoding != Compression::Encoding::Identity && fs::is_regular_file(variant, ec)) {
+            const auto variantTime = fs::last_write_time(variant, ec);
+            fresh = !ec && variantTime >= fs::last_write_time(path, ec) && !ec;
+        }
+        if (fresh) {
+            res.set_static_file_info(variant);
+            std::string ext = fs::path(path).extension().string();
+            if (!ext.empty()) ext.erase(0, 1);
+            auto mime = crow::mime_types.find(ext);
+            res.set_header("Content-Type", mime != crow::mime_types.end() ? mime->second : "text/plain");
+            res.set_header("Content-Encoding", Compression::name(encoding));
+        } else {
+            res.set_static_file_info(path);
+        }
+        res.set_header("Vary", "Accept-Encoding");
+        res.end();
+    }
+
+    /**
+     * @brief Serves a frontend file from StaticAssets (disk only if not in memory).
+     * 
+     * Picks the precompressed variant matching Accept-Encoding and answers
+     * If-None-Match with 304. Fingerprinted names and ?v=<hash> URLs are
+     * immutable, everything else (index.html) is revalidated on every use.
+     */
+    void serveStatic(const crow::request& req, crow::response& res, const std::string& relPath) {
+        auto asset = StaticAssets::find(relPath);
+        if (!asset) {
+            serveFromDisk(req, res, "static/" + relPath);
+            return;
+        }
+
+        const char* version = req.url_params.get("v");
+        const bool immutable = asset->fingerprinted || (version && asset->hash == version);
+        res.set_header("Cache-Control", immutable ? "public, max-age=31536000, immutable" : "no-cache");
+        res.set_header("Vary", "Accept-Encoding");
+
+        const auto encoding = Compression::negotiate(req.get_header_value("Accept-Encoding"));
+        const std::string* body = &asset->body;
+        if (encoding == Compression::Encoding::Zstd && !asset->zstd.empty()) body = &asset->zstd;
+        else if (encoding != Compression::Encoding::Identity && !asset->gzip.empty()) body = &asset->gzip;
+
+        // Weak for the encoded variants (same content, different bytes)
+        const bool encoded = body != &asset->body;
+        res.set_header("ETag", encoded ? "W/" + asset->etag : asset->etag);
+
+        if (utils::etagMatches(req.get_header_value("If-None-Match"), asset->etag)) {
+            res.code = 304;
+            res.end();
+            return;
+        }
+
+        res.set_header("Content-Type", asset->contentType);
+        // Ask the browser to send image widths with /media requests (responsive originals)
+        if (asset->contentType.starts_with("text/html")) res.set_header("Accept-CH", "Sec-CH-Width, Sec-CH-DPR");
+        if (encoded) {
+            res.set_header("Content-Encoding", body == &asset->zstd ? "zstd" : "gzip");
+        }
+        res.end(*body);
+    }
+}
+
 namespace routes {
 
-void setupWebRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
+void setupWebRoutes(CrowApp& app) {
 
     // --- SYSTEM INFO ROUTE (JSON) ---
     CROW_ROUTE(app, "/system/json")
@@ -34,38 +123,86 @@ void setupWebRoutes(crow::App<crow::CORSHandler, AuthMiddleware>& app) {
         return x; 
     });
 
+    // --- RUNTIME STATS (JSON) ---
+    CROW_ROUTE(app, "/system/stats")
+    ([]{
+        auto jwtCache = AuthMiddleware::cacheStats();
+        std::uint64_t lookups = jwtCache.hits + jwtCache.misses;
+
+        crow::json::wvalue x;
+        x["jwt_cache"]["hits"] = jwtCache.hits;
+        x["jwt_cache"]["misses"] = jwtCache.misses;
+        x["jwt_cache"]["entries"] = jwtCache.entries;
+        x["jwt_cache"]["hit_rate"] = lookups ? static_cast<double>(jwtCache.hits) / lookups : 0.0;
+        x["rate_limit"]["rejected"] = RateLimitMiddleware::rejectedCount();
+        x["db_executor"]["threads"] = DbExecutor::threadCount();
+        x["db_executor"]["pending"] = DbExecutor::pending();
+        x["facet_index"]["ready"] = FacetIndex::isReady();
+        x["facet_index"]["pictures"] = FacetIndex::size();
+        x["keyword_index"]["tags"] = KeywordIndex::size();
+        x["geo_index"]["pictures"] = GeoIndex::size();
+        x["reverse_geocoder"]["places"] = ReverseGeocoder::size();
+        x["deletion_queue"]["pending"] = DeletionQueue::pending();
+        x["compression"]["responses"] = CompressionMiddleware::compressedCount();
+        x["compression"]["saved_bytes"] = CompressionMiddleware::savedBytes();
+        x["media"]["open_files"] = MediaFiles::cachedCount();
+        x["static_assets"]["files"] = StaticAssets::count();
+        x["static_assets"]["bytes"] = StaticAssets::bytes();
+        x["templates"]["compiled"] = TemplateRegistry::count();
+        auto galleryCache = GalleryCache::stats();
+        x["gallery_cache"]["hits"] = galleryCache.hits;
+        x["gallery_cache"]["misses"] = galleryCache.misses;
+        x["gallery_cache"]["not_modified"] = galleryCache.notModified;
+        x["gallery_cache"]["entries"] = galleryCache.entries;
+        x["gallery_cache"]["bytes"] = galleryCache.bytes;
+
+        // Public route: only counts, no replica hosts / ports
+        const auto replicas = ReplicaRouter::replicas();
+        std::size_t healthy = 0;
+        double maxLag = 0.0;
+        for (const auto& r : replicas) {
+            if (r.healthy) ++healthy;
+            maxLag = std::max(maxLag, r.lagSeconds);
+        }
+        x["replicas"]["configured"] = replicas.size();
+        x["replicas"]["healthy"] = healthy;
+        x["replicas"]["max_lag_seconds"] = maxLag;
+        return x;
+    });
+
     // --- ROOT ROUTE (Homepage) ---
     CROW_ROUTE(app, "/")
-    ([](const crow::request&, crow::response& res){
+    ([](const crow::request& req, crow::response& res){
         // Serves static/index.html
-        res.set_static_file_info("static/index.html");
-        res.end(); 
+        serveStatic(req, res, "index.html");
     });
 
     // --- STATIC FILES (CSS, JS, TXT) ---
     // Example: http://localhost:8080/static/style.css
-    CROW_ROUTE(app, "/static/<string>")
-    ([](const crow::request&, crow::response& res, std::string filename){
+    CROW_ROUTE(app, "/static/<path>")
+    ([](const crow::request& req, crow::response& res, std::string filename){
         // Protection against Directory Traversal (simple)
         if (filename.find("..") != std::string::npos) {
             res.code = 403;
             res.end();
             return;
         }
-        res.set_static_file_info("static/" + filename);
-        res.end(); 
+        serveStatic(req, res, filename);
     });
 
     // --- TEMPLATE TEST (Mustache) ---
     CROW_ROUTE(app, "/template")
     ([](){
-        auto page = crow::mustache::load("template.html");
+        // Compiled once at startup (TemplateRegistry), not read + parsed per request
+        auto page = TemplateRegistry::get("template.html");
+        if (!page) return crow::response(404);
+
         crow::mustache::context ctx;
         ctx["user_name"] = "Guest";
         ctx["message"] = "Welcome to the Refactored Server!";
         ctx["time_is_morning"] = false; 
 
-        return page.render(ctx); 
+        return crow::response(page->render(ctx));
     });
 }
 
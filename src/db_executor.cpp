@@ -0,0 +1,154 @@
+/**
+ * @file db_executor.cpp
+ * @brief Implementation of the asynchronous DB executor.
+ */
+#include "db_executor.hpp"
+#include "crow.h"
+#include "metrics.hpp"
+#include "request_trace.hpp"
+
+#include <QThreadPool>
+#include <QDebug>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+
+namespace {
+
+    std::atomic<int> pendingJobs{0};
+
+    QThreadPool* pool() {
+        static QThreadPool* instance = [] {
+            auto* p = new QThreadPool();
+            int size = qEnvironmentVariableIntValue("DB_POOL_SIZE");
+            p->setMaxThreadCount(size > 0 ? size : 8);
+            // Threads (and their DB connections) live as long as the process
+            p->setExpiryTimeout(-1);
+            qInfo() << "DB executor started with" << p->maxThreadCount() << "threads";
+            return p;
+        }();
+        return instance;
+    }
+
+    /**
+     * Moves a response built by a job into the handler's response. Status and
+     * body are replaced; headers already set on 'res' (e.g. Content-Type by the
+     * AuthMiddleware or the handler, CORS) stay unless 'built' sets them too.
+     */
+    void complete(crow::response& res, crow::response built) {
+        res.code = built.code;
+        res.body = std::move(built.body);
+        for (const auto& header : built.headers) res.headers.erase(header.first);
+        for (auto& header : built.headers) res.headers.emplace(header.first, std::move(header.second));
+    }
+
+    crow::response internalError() {
+        return crow::response(500, R"({"error": "Internal Server Error"})");
+    }
+
+    /**
+     * Reserves a queue slot for a request (DB_QUEUE_MAX, default 1024 jobs queued
+     * or running; 0 = unlimited). Background jobs via submit() are not limited.
+     */
+    bool reserve() {
+        static const int limit = [] {
+            bool ok = false;
+            const int value = qEnvironmentVariableIntValue("DB_QUEUE_MAX", &ok);
+            return ok && value >= 0 ? value : 1024;
+        }();
+        if (pendingJobs.fetch_add(1, std::memory_order_relaxed) < limit || limit == 0) return true;
+        pendingJobs.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * Answers a request without queueing it, the client retries.
+     */
+    void reject(crow::response& res) {
+        static auto& rejected = Metrics::counter("db_executor_rejected_total", "Requests answered with 503 because DB_QUEUE_MAX was reached");
+        rejected.inc();
+        crow::response busy(503, R"({"error": "Server busy, please retry"})");
+        busy.set_header("Retry-After", "1");
+        complete(res, std::move(busy));
+        res.end();
+    }
+
+    /**
+     * Runs a job whose slot in pendingJobs is already counted.
+     */
+    void enqueue(std::function<void()> job) {
+        static auto& waitTime = Metrics::histogram("db_executor_wait_seconds", "Time DB jobs spend queued for a DB thread");
+        static auto& runTime = Metrics::histogram("db_executor_job_seconds", "Run time of DB jobs (queries + serialization)");
+
+        pool()->start([job = std::move(job), queued = std::chrono::steady_clock::now()]() {
+            waitTime.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - queued).count());
+            {
+                Metrics::Timer timer(runTime);
+                try {
+                    job();
+                } catch (const std::exception& e) {
+                    qCritical() << "DB job failed:" << e.what();
+                }
+            }
+            pendingJobs.fetch_sub(1, std::memory_order_relaxed);
+        });
+    }
+}
+
+void DbExecutor::submit(std::function<void()> job) {
+    pendingJobs.fetch_add(1, std::memory_order_relaxed);
+    enqueue(std::move(job));
+}
+
+void DbExecutor::respond(crow::response& res, std::function<crow::response()> work) {
+    if (!reserve()) {
+        reject(res);
+        return;
+    }
+    enqueue([&res, work = std::move(work)]() {
+        try {
+            complete(res, work());
+        } catch (const std::exception& e) {
+            qCritical() << "DB request failed:" << e.what();
+            complete(res, internalError());
+        }
+        res.end();
+    });
+}
+
+void DbExecutor::respond(crow::response& res, std::shared_ptr<RequestTrace> trace,
+                         std::function<crow::response()> work) {
+    if (!reserve()) {
+        trace->finish(res);
+        reject(res);
+        return;
+    }
+    auto queued = std::make_shared<RequestTrace::Stage>(*trace, "queue", nullptr);
+    enqueue([&res, trace = std::move(trace), queued = std::move(queued), work = std::move(work)]() {
+        queued->end();
+        {
+            auto stage = trace->stage("db");
+            try {
+                complete(res, work());
+            } catch (const std::exception& e) {
+                qCritical() << "DB request failed:" << e.what();
+                complete(res, internalError());
+            }
+        }
+        trace->finish(res);
+        res.end();
+    });
+}
+
+int DbExecutor::pending() {
+    return pendingJobs.load(std::memory_order_relaxed);
+}
+
+int DbExecutor::threadCount() {
+    return pool()->maxThreadCount();
+}
+
+int DbExecutor::activeThreads() {
+    return pool()->activeThreadCount();
+}
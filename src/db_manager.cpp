@@ -3,7 +3,16 @@
  * @brief Database Management Implementation.
  */
 #include "db_manager.hpp"
-#include "image_processor.hpp"
+#include "deletion_queue.hpp"
+#include "auth_cache.hpp"
+#include "password_hasher.hpp"
+#include "replica_router.hpp"
+#include "facet_index.hpp"
+#include "keyword_index.hpp"
+#include "geo_index.hpp"
+#include "gallery_cache.hpp"
+#include "metrics.hpp"
+#include "logger.hpp"
 
 #include <QSqlQuery>
 #include <QSqlError>
@@ -12,50 +21,161 @@
 #include <QDateTime>
 #include <QProcessEnvironment>
 #include <QVariant>
+#include <QStringList>
 #include <QSqlDriver> // For Transaction-Checks
-#include "bcrypt/BCrypt.hpp"
+#include <QHash>
+#include <QSet>
 
 const QString DbManager::SQLITE_DB_FILENAME = "app_database.sqlite"; ///< Filename for the SQLite database.
 
 // ------------------------------------------------------------------
 // POSTGRESQL (Data / Gallery) - WITH CONNECTION POOLING
 // ------------------------------------------------------------------
-QSqlDatabase DbManager::getPostgresConnection() {
-    // Name based on Thread-ID -> Each Thread has its own, persistent connection
-    QString connName = QString("pg_conn_%1").arg((quint64)QThread::currentThreadId());
+namespace {
+
+    // Persistent per-thread connection to the given host (primary or replica)
+    QSqlDatabase pooledConnection(const QString& connName, const QString& host, int port) {
+        if (QSqlDatabase::contains(connName)) {
+            QSqlDatabase db = QSqlDatabase::database(connName);
+            
+            if (db.isOpen()) {
+                return db;
+            } else {
+                // Try to reopen (in case of Timeout etc.)
+                if (!db.open()) {
+                    LOG_CRITICAL << "Failed to reopen existing Postgres connection:" << connName << db.lastError().text();
+                }
+                return db;
+            }
+        }
 
-    if (QSqlDatabase::contains(connName)) {
-        QSqlDatabase db = QSqlDatabase::database(connName);
+        // Create new connection (only 1x per Thread)
+        QSqlDatabase db = QSqlDatabase::addDatabase("QPSQL", connName);
         
-        if (db.isOpen()) {
-            return db;
+        db.setHostName(host);
+        db.setPort(port);
+        db.setDatabaseName(qEnvironmentVariable("PG_DB", "Photos"));
+        db.setUserName(qEnvironmentVariable("PG_USER", "postgres"));
+        db.setPassword(qEnvironmentVariable("PG_PASS"));
+
+        static auto& opened = Metrics::counter("db_connections_opened_total", "PostgreSQL connections opened (one per thread and host)");
+        static auto& failed = Metrics::counter("db_connection_errors_total", "Failed PostgreSQL connection attempts");
+        if (!db.open()) {
+            failed.inc();
+            LOG_CRITICAL << "Postgres Connection Error (" << connName << "):" << db.lastError().text();
         } else {
-            // Try to reopen (in case of Timeout etc.)
-            if (!db.open()) {
-                qCritical() << "Failed to reopen existing Postgres connection:" << connName << db.lastError().text();
-            }
-            return db;
+            opened.inc();
+            LOG_DEBUG << "New Postgres Connection established for thread:" << connName;
         }
+
+        return db;
     }
 
-    // Create new connection (only 1x per Thread)
-    QSqlDatabase db = QSqlDatabase::addDatabase("QPSQL", connName);
-    
-    db.setHostName(qEnvironmentVariable("PG_HOST", "localhost"));
-    db.setPort(qEnvironmentVariable("PG_PORT", "5432").toInt());
-    db.setDatabaseName(qEnvironmentVariable("PG_DB", "Photos"));
-    db.setUserName(qEnvironmentVariable("PG_USER", "postgres"));
-    db.setPassword(qEnvironmentVariable("PG_PASS"));
-
-    if (!db.open()) {
-        qCritical() << "Postgres Connection Error (" << connName << "):" << db.lastError().text();
-    } else {
-        qDebug() << "New Postgres Connection established for thread:" << connName;
+    // PostgreSQL array literals for CAST(:x AS bigint[]) / CAST(:x AS text[])
+    template <typename Ids>
+    QString pgIdArray(const Ids& ids) {
+        QStringList parts;
+        for (const auto& id : ids) parts << QString::number(id);
+        return "{" + parts.join(',') + "}";
     }
 
+    QString pgTextArray(const QStringList& values) {
+        QStringList parts;
+        for (QString v : values) {
+            v.replace('\\', "\\\\").replace('"', "\\\"");
+            parts << QString("\"%1\"").arg(v);
+        }
+        return "{" + parts.join(',') + "}";
+    }
+
+    QStringList toTagList(const std::vector<std::string>& keywords) {
+        QStringList tags;
+        for (const auto& k : keywords) {
+            QString tag = QString::fromStdString(k).trimmed();
+            if (!tag.isEmpty() && !tags.contains(tag)) tags << tag;
+        }
+        return tags;
+    }
+
+    // Duration of one kind of write operation (see /metrics)
+    Metrics::Histogram& queryTime(const char* operation) {
+        return Metrics::histogram("db_query_seconds", "Duration of DbManager write operations",
+                                  Metrics::labels({{"operation", operation}}));
+    }
+
+    // Folders affected by a batch (once per folder)
+    QSet<QString> foldersOf(const std::vector<std::pair<int, QString>>& photos) {
+        QSet<QString> folders;
+        for (const auto& photo : photos) folders.insert(photo.second);
+        return folders;
+    }
+
+    // Commits if every statement succeeded, otherwise rolls back. The in-memory
+    // indexes are only updated when this returns true, so they never run ahead
+    // of the database.
+    bool finishTransaction(QSqlDatabase& db, bool ok, const char* operation) {
+        if (ok && db.commit()) return true;
+        if (ok) LOG_CRITICAL << operation << "commit failed:" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+}
+
+QSqlDatabase DbManager::getPostgresConnection() {
+    // Name based on Thread-ID -> Each Thread has its own, persistent connection
+    QString connName = QString("pg_conn_%1").arg((quint64)QThread::currentThreadId());
+    return pooledConnection(connName,
+                            qEnvironmentVariable("PG_HOST", "localhost"),
+                            qEnvironmentVariable("PG_PORT", "5432").toInt());
+}
+
+QSqlDatabase DbManager::getReadConnection(const QString& path) {
+    // Read-your-writes: recently modified folders are read from the primary
+    int index = ReplicaRouter::recentlyWritten(path) ? -1 : ReplicaRouter::pick();
+    if (index < 0) return getPostgresConnection();
+
+    const auto replicas = ReplicaRouter::replicas();
+    const auto& replica = replicas[index];
+    QString connName = QString("pg_ro%1_%2").arg(index).arg((quint64)QThread::currentThreadId());
+    QSqlDatabase db = pooledConnection(connName, replica.host, replica.port);
+
+    if (!db.isOpen()) {
+        // Take it out of rotation until the next health check says otherwise
+        ReplicaRouter::reportHealth(index, false, replica.lagSeconds);
+        return getPostgresConnection();
+    }
     return db;
 }
 
+void DbManager::checkReplicaHealth() {
+    const auto replicas = ReplicaRouter::replicas();
+    for (int i = 0; i < static_cast<int>(replicas.size()); ++i) {
+        QString connName = QString("pg_health_%1").arg(i);
+        bool reachable = false;
+        double lag = 0.0;
+        {
+            QSqlDatabase db = pooledConnection(connName, replicas[i].host, replicas[i].port);
+            if (db.isOpen()) {
+                QSqlQuery q(db);
+                // No lag if everything received has been replayed (idle primary)
+                if (q.exec("SELECT CASE WHEN pg_last_wal_receive_lsn() = pg_last_wal_replay_lsn() THEN 0 "
+                           "ELSE COALESCE(EXTRACT(EPOCH FROM now() - pg_last_xact_replay_timestamp()), 0) END")
+                    && q.next()) {
+                    reachable = true;
+                    lag = q.value(0).toDouble();
+                } else {
+                    LOG_WARNING << "Replica health check failed:" << replicas[i].host << q.lastError().text();
+                    db.close(); // reopen on the next check
+                }
+            }
+        }
+        if (reachable != replicas[i].healthy) {
+            LOG_INFO << "Replica" << replicas[i].host << (reachable ? "reachable" : "unreachable") << "lag:" << lag << "s";
+        }
+        ReplicaRouter::reportHealth(i, reachable, lag);
+    }
+}
+
 // ------------------------------------------------------------------
 // SQLITE (Auth / Users)
 // ------------------------------------------------------------------
@@ -70,7 +190,7 @@ QSqlDatabase DbManager::getAuthDbConnection(const QString& connectionName) {
     }
 
     if (!db.isOpen() && !db.open()) {
-        qCritical() << "Auth DB Open Error:" << db.lastError().text();
+        LOG_CRITICAL << "Auth DB Open Error:" << db.lastError().text();
     }
     return db;
 }
@@ -95,17 +215,17 @@ void DbManager::initAuthDatabase() {
     bool ok2 = query.exec("CREATE TABLE IF NOT EXISTS refresh_tokens (token TEXT PRIMARY KEY, username TEXT, expires_at INTEGER)");
 
     if (!ok || !ok2) {
-        qCritical() << "Auth DB Setup Error:" << query.lastError().text();
+        LOG_CRITICAL << "Auth DB Setup Error:" << query.lastError().text();
     }
         query.exec("SELECT count(*) FROM users WHERE username = 'admin'");
         if (query.next() && query.value(0).toInt() == 0) {
-            std::string hash = BCrypt::generateHash("secret");
+            std::string hash = PasswordHasher::hash("secret");
             QSqlQuery insert(db);
             insert.prepare("INSERT INTO users (username, password_hash) VALUES (:u, :p)");
             insert.bindValue(":u", "admin");
             insert.bindValue(":p", QString::fromStdString(hash));
             insert.exec();
-            qDebug() << "Initial Admin user created (User: admin, Pass: secret)";
+            LOG_DEBUG << "Initial Admin user created (User: admin, Pass: secret)";
         }
     }
     QSqlDatabase::removeDatabase("setup_conn");
@@ -113,22 +233,23 @@ void DbManager::initAuthDatabase() {
 
 bool DbManager::verifyUser(const std::string& username, const std::string& password) {
     QString connName = QString("auth_verify_%1").arg((quint64)QThread::currentThreadId());
-    bool isValid = false;
+    std::string storedHash;
     {
         QSqlDatabase db = getAuthDbConnection(connName);
         if (db.isOpen()) {
             QSqlQuery query(db);
             // Login nur erlauben, wenn is_active = 1
-query.prepare("SELECT password_hash FROM users WHERE username = :u AND is_active = 1");
+            query.prepare("SELECT password_hash FROM users WHERE username = :u AND is_active = 1");
             query.bindValue(":u", QString::fromStdString(username));
             if (query.exec() && query.next()) {
-                std::string storedHash = query.value(0).toString().toStdString();
-                isValid = BCrypt::validatePassword(password, storedHash);
+                storedHash = query.value(0).toString().toStdString();
             }
         }
     }
     QSqlDatabase::removeDatabase(connName);
-    return isValid;
+
+    // bcrypt runs on its own pool, without holding the DB connection
+    return !storedHash.empty() && PasswordHasher::verify(password, storedHash);
 }
 
 void DbManager::storeRefreshToken(const std::string& username, const std::string& token) {
@@ -146,13 +267,26 @@ void DbManager::storeRefreshToken(const std::string& username, const std::string
             q.bindValue(":t", QString::fromStdString(token));
             q.bindValue(":u", QString::fromStdString(username));
             q.bindValue(":e", expiry);
-            q.exec();
+            if (q.exec()) {
+                // Write-through: the user only ever holds one refresh token
+                AuthCache::revokeRefreshTokensOf(username);
+                AuthCache::putRefreshToken(token, username, expiry);
+            }
         }
     }
     QSqlDatabase::removeDatabase(connName);
 }
 
 std::string DbManager::validateRefreshToken(const std::string& token) {
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+
+    // 1. Cache (expired entries are removed by the sweeper, not here)
+    if (auto cached = AuthCache::getRefreshToken(token)) {
+        return now < cached->expiresAt ? cached->username : std::string();
+    }
+
+    // 2. SQLite (generation first: a logout during the SELECT must win)
+    const AuthCache::Generation generation = AuthCache::refreshTokenGeneration(token);
     QString connName = QString("auth_val_%1").arg((quint64)QThread::currentThreadId());
     std::string username = "";
     {
@@ -163,13 +297,9 @@ std::string DbManager::validateRefreshToken(const std::string& token) {
             q.bindValue(":t", QString::fromStdString(token));
             if (q.exec() && q.next()) {
                 qint64 exp = q.value("expires_at").toLongLong();
-                if (QDateTime::currentSecsSinceEpoch() < exp) {
+                if (now < exp) {
                     username = q.value("username").toString().toStdString();
-                } else {
-                    QSqlQuery del(db);
-                    del.prepare("DELETE FROM refresh_tokens WHERE token = :t");
-                    del.bindValue(":t", QString::fromStdString(token));
-                    del.exec();
+                    AuthCache::putRefreshToken(token, username, exp, generation);
                 }
             }
         }
@@ -190,6 +320,190 @@ void DbManager::revokeRefreshToken(const std::string& token) {
         }
     }
     QSqlDatabase::removeDatabase(connName);
+    AuthCache::revokeRefreshToken(token);
+}
+
+int DbManager::purgeExpiredRefreshTokens() {
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    QString connName = QString("auth_sweep_%1").arg((quint64)QThread::currentThreadId());
+    int removed = 0;
+    {
+        QSqlDatabase db = getAuthDbConnection(connName);
+        if (db.isOpen()) {
+            QSqlQuery q(db);
+            q.prepare("DELETE FROM refresh_tokens WHERE expires_at <= :now");
+            q.bindValue(":now", now);
+            if (q.exec()) {
+                removed = q.numRowsAffected();
+            } else {
+                LOG_WARNING << "Refresh token sweep failed:" << q.lastError().text();
+            }
+        }
+    }
+    QSqlDatabase::removeDatabase(connName);
+    AuthCache::purgeExpiredRefreshTokens(now);
+    return removed;
+}
+
+// ------------------------------------------------------------------
+// GALLERY SCHEMA EXTENSIONS (PostgreSQL)
+// ------------------------------------------------------------------
+
+void DbManager::initGalleryDatabase() {
+    QSqlDatabase db = getPostgresConnection();
+    if (!db.isOpen()) {
+        LOG_WARNING << "Gallery DB not reachable, schema extensions not checked";
+        return;
+    }
+
+    const QStringList statements = {
+        // Full-text search: title/keywords (A), caption (B), location (C), filename (D)
+        "ALTER TABLE pictures ADD COLUMN IF NOT EXISTS search_vector tsvector",
+        R"(
+            CREATE OR REPLACE FUNCTION picture_search_vector(pid bigint) RETURNS tsvector
+            LANGUAGE sql STABLE AS $$
+                SELECT
+                    setweight(to_tsvector('simple', coalesce((SELECT object_name FROM meta_iptc WHERE ref_picture = pid LIMIT 1), '')), 'A') ||
+                    setweight(to_tsvector('simple', coalesce((SELECT string_agg(k.tag, ' ') FROM picture_keywords pk
+                                                              JOIN keywords k ON k.id = pk.keyword_id
+                                                              WHERE pk.picture_id = pid), '')), 'A') ||
+                    setweight(to_tsvector('simple', coalesce((SELECT caption FROM meta_iptc WHERE ref_picture = pid LIMIT 1), '')), 'B') ||
+                    setweight(to_tsvector('simple', coalesce((SELECT concat_ws(' ', city, province, country) FROM meta_location
+                                                              WHERE ref_picture = pid LIMIT 1), '')), 'C') ||
+                    setweight(to_tsvector('simple', coalesce((SELECT file_name FROM pictures WHERE id = pid), '')), 'D')
+            $$
+        )",
+        "CREATE INDEX IF NOT EXISTS idx_pictures_search ON pictures USING GIN (search_vector)",
+        // Backfill (only rows that have never been indexed)
+        "UPDATE pictures SET search_vector = picture_search_vector(id) WHERE search_vector IS NULL",
+        // Timeline: photos per folder and day, maintained by insertPhoto/deletePhoto
+        R"(
+            CREATE TABLE IF NOT EXISTS photo_timeline (
+                file_path TEXT NOT NULL,
+                day DATE NOT NULL,
+                count INTEGER NOT NULL DEFAULT 0,
+                PRIMARY KEY (file_path, day)
+            )
+        )",
+        // Backfill (only once, while the table is still empty)
+        R"(
+            INSERT INTO photo_timeline (file_path, day, count)
+            SELECT file_path, file_datetime::date, count(*) FROM pictures
+            WHERE file_datetime IS NOT NULL AND NOT EXISTS (SELECT 1 FROM photo_timeline)
+            GROUP BY 1, 2
+        )",
+        // Seek to date inside a folder (gallery 'before' parameter)
+        "CREATE INDEX IF NOT EXISTS idx_pictures_path_datetime ON pictures (file_path, file_datetime DESC)",
+        // Map: spatial index for bounding box queries (0/0 = no GPS position)
+        "CREATE INDEX IF NOT EXISTS idx_meta_exif_gps ON meta_exif "
+        "USING GIST (point(gps_longitude::float8, gps_latitude::float8)) "
+        "WHERE gps_latitude <> 0 OR gps_longitude <> 0"
+    };
+
+    for (const QString& sql : statements) {
+        QSqlQuery q(db);
+        if (!q.exec(sql)) {
+            LOG_CRITICAL << "Gallery DB Setup Error:" << q.lastError().text();
+        }
+    }
+}
+
+void DbManager::refreshSearchVector(QSqlDatabase& db, qint64 pictureId) {
+    QSqlQuery q(db);
+    q.prepare("UPDATE pictures SET search_vector = picture_search_vector(id) WHERE id = :id");
+    q.bindValue(":id", pictureId);
+    if (!q.exec()) {
+        LOG_WARNING << "Update search vector failed:" << q.lastError().text();
+    }
+}
+
+void DbManager::loadKeywordIndex() {
+    QSqlDatabase db = getPostgresConnection();
+    if (!db.isOpen()) {
+        LOG_WARNING << "Gallery DB not reachable, keyword index not loaded";
+        return;
+    }
+
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+    if (!q.exec("SELECT k.tag, count(pk.picture_id) FROM keywords k "
+                "LEFT JOIN picture_keywords pk ON pk.keyword_id = k.id GROUP BY k.tag")) {
+        LOG_CRITICAL << "Keyword index query failed:" << q.lastError().text();
+        return;
+    }
+
+    std::vector<std::pair<QString, std::uint32_t>> tags;
+    while (q.next()) {
+        tags.emplace_back(q.value(0).toString(), q.value(1).toUInt());
+    }
+    KeywordIndex::rebuild(tags);
+    LOG_INFO << "Keyword index loaded:" << KeywordIndex::size() << "tags";
+}
+
+void DbManager::loadGeoIndex() {
+    QSqlDatabase db = getPostgresConnection();
+    if (!db.isOpen()) {
+        LOG_WARNING << "Gallery DB not reachable, geo index not loaded";
+        return;
+    }
+
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+    if (!q.exec("SELECT ref_picture, gps_latitude, gps_longitude FROM meta_exif "
+                "WHERE gps_latitude <> 0 OR gps_longitude <> 0")) {
+        LOG_CRITICAL << "Geo index query failed:" << q.lastError().text();
+        return;
+    }
+
+    std::vector<std::pair<std::uint32_t, std::pair<double, double>>> photos;
+    while (q.next()) {
+        photos.push_back({q.value(0).toUInt(), {q.value(1).toDouble(), q.value(2).toDouble()}});
+    }
+    GeoIndex::rebuild(photos);
+    LOG_INFO << "Geo index loaded:" << GeoIndex::size() << "geotagged pictures";
+}
+
+void DbManager::loadFacetIndex() {
+    QSqlDatabase db = getPostgresConnection();
+    if (!db.isOpen()) {
+        LOG_WARNING << "Gallery DB not reachable, facet index not loaded";
+        return;
+    }
+
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+    bool ok = q.exec(R"(
+        SELECT p.id, p.file_path, p.file_datetime, e.model, l.country, l.city,
+               (SELECT string_agg(k.tag, chr(31)) FROM picture_keywords pk
+                JOIN keywords k ON k.id = pk.keyword_id
+                WHERE pk.picture_id = p.id) AS tags
+        FROM pictures p
+        LEFT JOIN meta_exif e ON p.id = e.ref_picture
+        LEFT JOIN meta_location l ON p.id = l.ref_picture
+    )");
+    if (!ok) {
+        LOG_CRITICAL << "Facet index query failed:" << q.lastError().text();
+        return;
+    }
+
+    std::vector<std::pair<std::uint32_t, FacetIndex::PhotoFacets>> photos;
+    while (q.next()) {
+        FacetIndex::PhotoFacets f;
+        f.folder = q.value(1).toString();
+        QDateTime dt = q.value(2).toDateTime();
+        if (dt.isValid()) {
+            f.sortKey = dt.toMSecsSinceEpoch();
+            f.year = dt.date().year();
+        }
+        f.camera = q.value(3).toString();
+        f.country = q.value(4).toString();
+        f.city = q.value(5).toString();
+        f.keywords = q.value(6).toString().split(QChar(31), Qt::SkipEmptyParts);
+        photos.emplace_back(q.value(0).toUInt(), std::move(f));
+    }
+
+    FacetIndex::rebuild(photos);
+    LOG_INFO << "Facet index loaded:" << FacetIndex::size() << "pictures";
 }
 
 // ------------------------------------------------------------------
@@ -204,6 +518,7 @@ int DbManager::getOrCreateKeywordId(QSqlDatabase& db, const QString& tag) {
 
     q.prepare("INSERT INTO keywords (tag) VALUES (:t) ON CONFLICT (tag) DO NOTHING RETURNING id");
     q.bindValue(":t", tag);
+    // New tags reach the autocomplete through KeywordIndex::adjustUsage after the commit
     if (q.exec() && q.next()) return q.value(0).toInt();
 
     q.prepare("SELECT id FROM keywords WHERE tag = :t");
@@ -213,7 +528,41 @@ int DbManager::getOrCreateKeywordId(QSqlDatabase& db, const QString& tag) {
     return -1;
 }
 
+bool DbManager::removeFromTimeline(QSqlDatabase& db, const QString& idArray) {
+    // Zero rows are kept (reused by the next upload of that day), readers skip them
+    QSqlQuery q(db);
+    q.prepare(R"(
+        UPDATE photo_timeline t SET count = GREATEST(t.count - d.n, 0)
+        FROM (SELECT file_path, file_datetime::date AS day, count(*) AS n FROM pictures
+              WHERE id = ANY(CAST(:ids AS bigint[])) AND file_datetime IS NOT NULL
+              GROUP BY 1, 2) d
+        WHERE t.file_path = d.file_path AND t.day = d.day
+    )");
+    q.bindValue(":ids", idArray);
+    if (!q.exec()) {
+        LOG_CRITICAL << "Update timeline failed:" << q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QStringList DbManager::keywordsOf(QSqlDatabase& db, qint64 pictureId) {
+    QStringList tags;
+    QSqlQuery q(db);
+    q.prepare("SELECT k.tag FROM picture_keywords pk JOIN keywords k ON k.id = pk.keyword_id WHERE pk.picture_id = :id");
+    q.bindValue(":id", pictureId);
+    if (q.exec()) {
+        while (q.next()) tags << q.value(0).toString();
+    } else {
+        LOG_WARNING << "Select Keywords failed:" << q.lastError().text();
+    }
+    return tags;
+}
+
 bool DbManager::insertPhoto(const WorkerPayload& p) {
+    static auto& duration = queryTime("insert_photo");
+    Metrics::Timer timer(duration);
+
     // NEW: Use pooled connection (no UUID anymore)
     QSqlDatabase db = getPostgresConnection();
     
@@ -224,6 +573,7 @@ bool DbManager::insertPhoto(const WorkerPayload& p) {
 
     bool ok = true;
     qint64 picId = -1;
+    QStringList linkedTags; // for the keyword usage counts
 
     // 1. Picture
     QSqlQuery q(db);
@@ -242,7 +592,7 @@ bool DbManager::insertPhoto(const WorkerPayload& p) {
         picId = q.value(0).toLongLong();
     } else {
         ok = false;
-        qCritical() << "Insert Picture failed:" << q.lastError().text();
+        LOG_CRITICAL << "Insert Picture failed:" << q.lastError().text();
     }
 
     if (ok) {
@@ -255,7 +605,7 @@ bool DbManager::insertPhoto(const WorkerPayload& p) {
         qLoc.bindValue(":p", p.meta.province);
         qLoc.bindValue(":ci", p.meta.city);
         if(!qLoc.exec()) {
-             qWarning() << "Insert Location failed:" << qLoc.lastError().text();
+             LOG_WARNING << "Insert Location failed:" << qLoc.lastError().text();
              // Not critical
         }
 
@@ -273,7 +623,7 @@ bool DbManager::insertPhoto(const WorkerPayload& p) {
         qExif.bindValue(":lon", p.meta.gpsLon);
         qExif.bindValue(":dto", p.meta.takenAt);
         if(!qExif.exec()) {
-            qWarning() << "Insert Exif failed:" << qExif.lastError().text();
+            LOG_WARNING << "Insert Exif failed:" << qExif.lastError().text();
             // Not critical
         }
 
@@ -287,7 +637,7 @@ bool DbManager::insertPhoto(const WorkerPayload& p) {
         qIptc.bindValue(":copy", p.meta.copyright);
         
         if(!qIptc.exec()) {
-             qWarning() << "Insert IPTC failed:" << qIptc.lastError().text();
+             LOG_WARNING << "Insert IPTC failed:" << qIptc.lastError().text();
         }
 
         // 5. Keywords
@@ -299,16 +649,46 @@ bool DbManager::insertPhoto(const WorkerPayload& p) {
                 qLink.prepare("INSERT INTO picture_keywords (picture_id, keyword_id) VALUES (:pid, :kid) ON CONFLICT DO NOTHING");
                 qLink.bindValue(":pid", picId);
                 qLink.bindValue(":kid", kId);
-                qLink.exec();
+                if (qLink.exec() && qLink.numRowsAffected() > 0) linkedTags << k.trimmed();
+            }
+        }
+
+        // 6. Full-text search vector (title, caption, keywords, location)
+        refreshSearchVector(db, picId);
+
+        // 7. Timeline aggregate
+        if (p.fileDate.isValid()) {
+            QSqlQuery qDay(db);
+            qDay.prepare("INSERT INTO photo_timeline (file_path, day, count) VALUES (:fp, :day, 1) "
+                         "ON CONFLICT (file_path, day) DO UPDATE SET count = photo_timeline.count + 1");
+            qDay.bindValue(":fp", QString::fromStdString(p.relPath));
+            qDay.bindValue(":day", p.fileDate.date());
+            if (!qDay.exec()) {
+                LOG_CRITICAL << "Update timeline failed:" << qDay.lastError().text();
+                ok = false;
             }
         }
     }
 
+    ok = finishTransaction(db, ok, "Insert");
     if (ok) {
-        db.commit();
-        qDebug() << "DB Insert success for ID:" << picId;
-    } else {
-        db.rollback();
+        ReplicaRouter::markWrite(QString::fromStdString(p.relPath));
+
+        FacetIndex::PhotoFacets facets;
+        facets.folder = QString::fromStdString(p.relPath);
+        if (p.fileDate.isValid()) {
+            facets.sortKey = p.fileDate.toMSecsSinceEpoch();
+            facets.year = p.fileDate.date().year();
+        }
+        facets.camera = p.meta.model;
+        facets.country = p.meta.country;
+        facets.city = p.meta.city;
+        facets.keywords = p.meta.keywords;
+        FacetIndex::put(static_cast<std::uint32_t>(picId), facets);
+        for (const QString& tag : linkedTags) KeywordIndex::adjustUsage(tag, +1);
+        GeoIndex::add(static_cast<std::uint32_t>(picId), p.meta.gpsLat, p.meta.gpsLon);
+        GalleryCache::invalidate(facets.folder);
+        LOG_DEBUG << "DB Insert success for ID:" << picId;
     }
 
     // IMPORTANT: DO NOT close connection, it remains open for the Thread
@@ -316,9 +696,22 @@ bool DbManager::insertPhoto(const WorkerPayload& p) {
 }
 
 bool DbManager::updatePhotoMetadata(int id, const PhotoUpdateData& data) {
+    static auto& duration = queryTime("update_photo");
+    Metrics::Timer timer(duration);
+
     QSqlDatabase db = getPostgresConnection();
     if (!db.isOpen()) return false;
 
+    // Folder of the photo (also checks that it exists)
+    QSqlQuery qPath(db);
+    qPath.prepare("SELECT file_path FROM pictures WHERE id = :id");
+    qPath.bindValue(":id", id);
+    if (!qPath.exec() || !qPath.next()) {
+        LOG_WARNING << "Photo ID not found for update:" << id;
+        return false;
+    }
+    const QString folder = qPath.value(0).toString();
+
     db.transaction();
     bool ok = true;
 
@@ -333,7 +726,7 @@ bool DbManager::updatePhotoMetadata(int id, const PhotoUpdateData& data) {
     qUp.bindValue(":id", id);
 
     if (!qUp.exec()) {
-        qCritical() << "Update IPTC SQL failed:" << qUp.lastError().text();
+        LOG_CRITICAL << "Update IPTC SQL failed:" << qUp.lastError().text();
         ok = false;
     } else {
         // 2. If no row was updated (Image has no IPTC data yet) -> INSERT
@@ -347,20 +740,24 @@ bool DbManager::updatePhotoMetadata(int id, const PhotoUpdateData& data) {
             qIns.bindValue(":desc", qDesc);
             
             if (!qIns.exec()) {
-                qCritical() << "Insert IPTC SQL failed:" << qIns.lastError().text();
+                LOG_CRITICAL << "Insert IPTC SQL failed:" << qIns.lastError().text();
                 ok = false;
             }
         }
     }
 
     // 3. Update Keywords (Only if Step 1/2 was ok)
+    QStringList oldTags;
+    QStringList newTags;
     if (ok) {
+        oldTags = keywordsOf(db, id);
+
         // A. Delete old links
         QSqlQuery qDelKeys(db);
         qDelKeys.prepare("DELETE FROM picture_keywords WHERE picture_id = :id");
         qDelKeys.bindValue(":id", id);
         if (!qDelKeys.exec()) {
-             qCritical() << "Delete Keywords failed:" << qDelKeys.lastError().text();
+             LOG_CRITICAL << "Delete Keywords failed:" << qDelKeys.lastError().text();
              ok = false;
         }
 
@@ -376,69 +773,292 @@ bool DbManager::updatePhotoMetadata(int id, const PhotoUpdateData& data) {
                     qLink.bindValue(":pid", id);
                     qLink.bindValue(":kid", kId);
                     if (!qLink.exec()) {
-                        qWarning() << "Link Keyword failed for" << k.c_str();
+                        LOG_WARNING << "Link Keyword failed for" << k.c_str();
+                    } else if (qLink.numRowsAffected() > 0) {
+                        newTags << QString::fromStdString(k);
                     }
                 }
             }
         }
     }
 
+    // 4. Full-text search vector
     if (ok) {
-        db.commit();
-        return true;
-    } else {
-        db.rollback();
-        return false;
+        refreshSearchVector(db, id);
     }
+
+    if (!finishTransaction(db, ok, "Update")) return false;
+
+    ReplicaRouter::markWrite(folder);
+    FacetIndex::setKeywords(static_cast<std::uint32_t>(id), newTags);
+    for (const QString& tag : oldTags) KeywordIndex::adjustUsage(tag, -1);
+    for (const QString& tag : newTags) KeywordIndex::adjustUsage(tag, +1);
+    GalleryCache::invalidate(folder);
+    return true;
 }
 
 bool DbManager::deletePhoto(int id) {
+    static auto& duration = queryTime("delete_photo");
+    Metrics::Timer timer(duration);
+
     QSqlDatabase db = getPostgresConnection();
     if (!db.isOpen()) return false;
 
     // 1. Determine path (before we delete)
     QSqlQuery q(db);
-    q.prepare("SELECT full_path FROM pictures WHERE id = :id");
+    q.prepare("SELECT full_path, file_path FROM pictures WHERE id = :id");
     q.bindValue(":id", id);
     
     QString fullPath;
+    QString folder;
     if (q.exec() && q.next()) {
         fullPath = q.value(0).toString();
+        folder = q.value(1).toString();
     } else {
-        qWarning() << "Photo ID not found for deletion:" << id;
+        LOG_WARNING << "Photo ID not found for deletion:" << id;
         return false;
     }
 
-    // 2. Delete DB Entry
+    // Keyword links disappear with the picture (usage counts of the autocomplete)
+    const QStringList tags = keywordsOf(db, id);
+
+    // 2. Delete DB Entry (+ timeline aggregate, one transaction)
     // Note: We rely on ON DELETE CASCADE in the DB for metadata.
     // If not set up, meta_* tables must be deleted first.
+    db.transaction();
     QSqlQuery del(db);
     del.prepare("DELETE FROM pictures WHERE id = :id");
     del.bindValue(":id", id);
+
+    bool ok = removeFromTimeline(db, QString("{%1}").arg(id)) && del.exec();
+    ok = finishTransaction(db, ok, "Delete");
     
-    if (del.exec()) {
-        qDebug() << "DB Delete :" << fullPath;  
-        // 3. Physically delete files (only if DB was successful)
-        if (!fullPath.isEmpty()) {
-            QFile file(fullPath);
-            if (file.exists()) {
-                if (!file.remove()) {
-                    qWarning() << "Could not delete file:" << fullPath;
-                } else {
-                    qDebug() << "Deleted original file:" << fullPath;
-                }
-            }
-            
-            // Cleanup WebP versions (which we prepared yesterday)
-            ImageProcessor::deleteAllVersions(fullPath);
-        }
+    if (ok) {
+        ReplicaRouter::markWrite(folder);
+        FacetIndex::remove(static_cast<std::uint32_t>(id));
+        for (const QString& tag : tags) KeywordIndex::adjustUsage(tag, -1);
+        GeoIndex::remove(static_cast<std::uint32_t>(id));
+        GalleryCache::invalidate(folder);
+        LOG_DEBUG << "DB Delete :" << fullPath;  
+        // 3. Original -> trash now, the WebP versions are removed by the deletion queue
+        if (!fullPath.isEmpty()) DeletionQueue::remove({fullPath});
         return true;
     } else {
-        qCritical() << "Delete failed:" << del.lastError().text();
+        LOG_CRITICAL << "Delete failed:" << del.lastError().text();
         return false;
     }
 }
 
+// ------------------------------------------------------------------
+// BATCH OPERATIONS
+// ------------------------------------------------------------------
+
+QString DbManager::subfolderPattern(const QString& folder) {
+    QString escaped = folder;
+    escaped.replace('\\', "\\\\").replace('%', "\\%").replace('_', "\\_");
+    return escaped + "/%";
+}
+
+std::vector<std::pair<int, QString>> DbManager::selectPhotos(QSqlDatabase& db, const PhotoSelection& selection, bool& ok) {
+    std::vector<std::pair<int, QString>> photos;
+    QSqlQuery q(db);
+    if (!selection.pathPrefix.empty()) {
+        q.prepare("SELECT id, file_path FROM pictures "
+                  "WHERE file_path = :base OR file_path LIKE :pattern ESCAPE '\\' FOR UPDATE");
+        q.bindValue(":base", QString::fromStdString(selection.pathPrefix));
+        q.bindValue(":pattern", subfolderPattern(QString::fromStdString(selection.pathPrefix)));
+    } else {
+        q.prepare("SELECT id, file_path FROM pictures WHERE id = ANY(CAST(:ids AS bigint[])) FOR UPDATE");
+        q.bindValue(":ids", pgIdArray(selection.ids));
+    }
+    if (!q.exec()) {
+        LOG_CRITICAL << "Batch selection failed:" << q.lastError().text();
+        ok = false;
+        return photos;
+    }
+    while (q.next()) photos.emplace_back(q.value(0).toInt(), q.value(1).toString());
+    return photos;
+}
+
+BatchResult DbManager::batchUpdatePhotos(const PhotoSelection& selection, const BatchUpdateData& data) {
+    static auto& duration = queryTime("batch_update");
+    Metrics::Timer timer(duration);
+
+    BatchResult result;
+    QSqlDatabase db = getPostgresConnection();
+    if (!db.isOpen()) return result;
+
+    db.transaction();
+    bool ok = true;
+
+    const auto photos = selectPhotos(db, selection, ok);
+    result.matched = static_cast<int>(photos.size());
+    std::vector<int> ids;
+    for (const auto& photo : photos) ids.push_back(photo.first);
+    const QString idArray = pgIdArray(ids);
+
+    const QStringList addTags = toTagList(data.addKeywords);
+    const QStringList removeTags = toTagList(data.removeKeywords);
+    std::vector<std::pair<std::uint32_t, QString>> added;
+    std::vector<std::pair<std::uint32_t, QString>> removed;
+
+    // 1. Title / Description (UPDATE existing rows, INSERT for photos without IPTC row)
+    if (ok && !ids.empty() && (data.title || data.description)) {
+        QStringList sets;
+        if (data.title) sets << "object_name = :title";
+        if (data.description) sets << "caption = :desc";
+
+        QSqlQuery qUp(db);
+        qUp.prepare("UPDATE meta_iptc SET " + sets.join(", ") + " WHERE ref_picture = ANY(CAST(:ids AS bigint[]))");
+        qUp.bindValue(":ids", idArray);
+        if (data.title) qUp.bindValue(":title", QString::fromStdString(*data.title));
+        if (data.description) qUp.bindValue(":desc", QString::fromStdString(*data.description));
+
+        QSqlQuery qIns(db);
+        qIns.prepare("INSERT INTO meta_iptc (ref_picture, object_name, caption, copyright) "
+                     "SELECT pid, :title, :desc, '' FROM unnest(CAST(:ids AS bigint[])) AS pid "
+                     "WHERE NOT EXISTS (SELECT 1 FROM meta_iptc WHERE ref_picture = pid)");
+        qIns.bindValue(":ids", idArray);
+        qIns.bindValue(":title", QString::fromStdString(data.title.value_or("")));
+        qIns.bindValue(":desc", QString::fromStdString(data.description.value_or("")));
+
+        if (!qUp.exec() || !qIns.exec()) {
+            LOG_CRITICAL << "Batch IPTC update failed:" << qUp.lastError().text() << qIns.lastError().text();
+            ok = false;
+        }
+    }
+
+    // 2. Remove keyword links
+    if (ok && !ids.empty() && !removeTags.isEmpty()) {
+        QSqlQuery qDel(db);
+        qDel.prepare("DELETE FROM picture_keywords pk USING keywords k "
+                     "WHERE pk.keyword_id = k.id AND k.tag = ANY(CAST(:tags AS text[])) "
+                     "AND pk.picture_id = ANY(CAST(:ids AS bigint[])) "
+                     "RETURNING pk.picture_id, k.tag");
+        qDel.bindValue(":tags", pgTextArray(removeTags));
+        qDel.bindValue(":ids", idArray);
+        if (qDel.exec()) {
+            while (qDel.next()) removed.emplace_back(qDel.value(0).toUInt(), qDel.value(1).toString());
+        } else {
+            LOG_CRITICAL << "Batch keyword removal failed:" << qDel.lastError().text();
+            ok = false;
+        }
+    }
+
+    // 3. Add keyword links (create missing tags first)
+    if (ok && !ids.empty() && !addTags.isEmpty()) {
+        QSqlQuery qTags(db);
+        qTags.prepare("INSERT INTO keywords (tag) SELECT unnest(CAST(:tags AS text[])) ON CONFLICT (tag) DO NOTHING");
+        qTags.bindValue(":tags", pgTextArray(addTags));
+
+        QSqlQuery qLink(db);
+        qLink.prepare("INSERT INTO picture_keywords (picture_id, keyword_id) "
+                      "SELECT pid, k.id FROM unnest(CAST(:ids AS bigint[])) AS pid "
+                      "CROSS JOIN keywords k WHERE k.tag = ANY(CAST(:tags AS text[])) "
+                      "ON CONFLICT DO NOTHING RETURNING picture_id, keyword_id");
+        qLink.bindValue(":ids", idArray);
+        qLink.bindValue(":tags", pgTextArray(addTags));
+
+        QSqlQuery qNames(db);
+        qNames.prepare("SELECT id, tag FROM keywords WHERE tag = ANY(CAST(:tags AS text[]))");
+        qNames.bindValue(":tags", pgTextArray(addTags));
+
+        if (qTags.exec() && qNames.exec() && qLink.exec()) {
+            QHash<int, QString> tagById;
+            while (qNames.next()) tagById.insert(qNames.value(0).toInt(), qNames.value(1).toString());
+            while (qLink.next()) added.emplace_back(qLink.value(0).toUInt(), tagById.value(qLink.value(1).toInt()));
+        } else {
+            LOG_CRITICAL << "Batch keyword insert failed:" << qTags.lastError().text() << qLink.lastError().text();
+            ok = false;
+        }
+    }
+
+    // 4. Full-text search vectors
+    if (ok && !ids.empty()) {
+        QSqlQuery qVec(db);
+        qVec.prepare("UPDATE pictures SET search_vector = picture_search_vector(id) WHERE id = ANY(CAST(:ids AS bigint[]))");
+        qVec.bindValue(":ids", idArray);
+        if (!qVec.exec()) {
+            LOG_CRITICAL << "Batch search vector update failed:" << qVec.lastError().text();
+            ok = false;
+        }
+    }
+
+    if (!finishTransaction(db, ok, "Batch")) return result;
+
+    const QSet<QString> folders = foldersOf(photos);
+    for (const QString& folder : folders) ReplicaRouter::markWrite(folder);
+    FacetIndex::applyKeywordChanges(added, removed);
+    for (const auto& link : added) KeywordIndex::adjustUsage(link.second, +1);
+    for (const auto& link : removed) KeywordIndex::adjustUsage(link.second, -1);
+    for (const QString& folder : folders) GalleryCache::invalidate(folder);
+
+    result.ok = true;
+    result.keywordsAdded = static_cast<int>(added.size());
+    result.keywordsRemoved = static_cast<int>(removed.size());
+    return result;
+}
+
+BatchResult DbManager::deletePhotos(const PhotoSelection& selection) {
+    static auto& duration = queryTime("batch_delete");
+    Metrics::Timer timer(duration);
+
+    BatchResult result;
+    QSqlDatabase db = getPostgresConnection();
+    if (!db.isOpen()) return result;
+
+    db.transaction();
+    bool ok = true;
+
+    const auto photos = selectPhotos(db, selection, ok);
+    std::vector<int> ids;
+    for (const auto& photo : photos) ids.push_back(photo.first);
+    const QString idArray = pgIdArray(ids);
+
+    // Keyword links disappear with the pictures (usage counts of the autocomplete)
+    QStringList tags;
+    QStringList fullPaths;
+    if (ok && !ids.empty()) {
+        QSqlQuery qTags(db);
+        qTags.prepare("SELECT k.tag FROM picture_keywords pk JOIN keywords k ON k.id = pk.keyword_id "
+                      "WHERE pk.picture_id = ANY(CAST(:ids AS bigint[]))");
+        qTags.bindValue(":ids", idArray);
+        if (qTags.exec()) {
+            while (qTags.next()) tags << qTags.value(0).toString();
+        }
+
+        // One statement for all pictures (metadata via ON DELETE CASCADE)
+        QSqlQuery del(db);
+        del.prepare("DELETE FROM pictures WHERE id = ANY(CAST(:ids AS bigint[])) RETURNING full_path");
+        del.bindValue(":ids", idArray);
+
+        ok = removeFromTimeline(db, idArray) && del.exec();
+        if (ok) {
+            while (del.next()) fullPaths << del.value(0).toString();
+        } else {
+            LOG_CRITICAL << "Batch delete failed:" << del.lastError().text();
+        }
+    }
+
+    if (!finishTransaction(db, ok, "Batch")) return result;
+
+    const QSet<QString> folders = foldersOf(photos);
+    for (const QString& folder : folders) ReplicaRouter::markWrite(folder);
+    for (const auto& photo : photos) {
+        FacetIndex::remove(static_cast<std::uint32_t>(photo.first));
+        GeoIndex::remove(static_cast<std::uint32_t>(photo.first));
+    }
+    for (const QString& tag : tags) KeywordIndex::adjustUsage(tag, -1);
+    for (const QString& folder : folders) GalleryCache::invalidate(folder);
+
+    DeletionQueue::remove(fullPaths);
+    LOG_DEBUG << "DB Batch Delete:" << fullPaths.size() << "photos";
+
+    result.ok = true;
+    result.matched = static_cast<int>(fullPaths.size());
+    return result;
+}
+
 // ...
 
 // ------------------------------------------------------------------
@@ -471,6 +1091,10 @@ std::vector<UserData> DbManager::getAllUsers() {
 }
 
 UserData DbManager::getUserByUsername(const std::string& username) {
+    if (auto cached = AuthCache::getUser(username)) return *cached;
+
+    // Before the SELECT: a deactivation in between must not be overwritten by this row
+    const AuthCache::Generation generation = AuthCache::userGeneration(username);
     UserData u = {0, "", "", false, "", false};
     QString connName = QString("get_user_%1").arg((quint64)QThread::currentThreadId());
     {
@@ -491,10 +1115,14 @@ UserData DbManager::getUserByUsername(const std::string& username) {
         }
     }
     QSqlDatabase::removeDatabase(connName);
+    AuthCache::putUser(u, generation);
     return u;
 }
 
 bool DbManager::createUser(const std::string& username, const std::string& password) {
+    // Hash first (bcrypt pool), so no connection is open while we wait
+    std::string hash = PasswordHasher::hash(password);
+
     QString connName = QString("admin_create_%1").arg((quint64)QThread::currentThreadId());
     bool success = false;
     
@@ -507,14 +1135,13 @@ bool DbManager::createUser(const std::string& username, const std::string& passw
             check.prepare("SELECT id FROM users WHERE username = :u");
             check.bindValue(":u", QString::fromStdString(username));
             if (check.exec() && check.next()) {
-                qWarning() << "Create user aborted: Username already exists ->" << QString::fromStdString(username);
+                LOG_WARNING << "Create user aborted: Username already exists ->" << QString::fromStdString(username);
                 // Wir schließen die DB Verbindung hier sauber
                 // QSqlDatabase::removeDatabase passiert am Ende der Funktion
                 return false; 
             }
 
             // 2. Insert
-            std::string hash = BCrypt::generateHash(password);
             QSqlQuery q(db);
             // Wichtig: Wir verlassen uns auf den DEFAULT Wert von is_active (1)
             q.prepare("INSERT INTO users (username, password_hash, is_active) VALUES (:u, :p, 1)");
@@ -523,9 +1150,10 @@ bool DbManager::createUser(const std::string& username, const std::string& passw
             
             if (q.exec()) {
                 success = true;
-                qDebug() << "User created successfully:" << QString::fromStdString(username);
+                AuthCache::invalidateUser(username);
+                LOG_DEBUG << "User created successfully:" << QString::fromStdString(username);
             } else {
-                qCritical() << "Create user SQL failed:" << q.lastError().text();
+                LOG_CRITICAL << "Create user SQL failed:" << q.lastError().text();
             }
         }
     }
@@ -545,7 +1173,10 @@ bool DbManager::deleteUser(int id) {
             QSqlQuery q(db);
             q.prepare("DELETE FROM users WHERE id = :id");
             q.bindValue(":id", id);
-            if(q.exec()) success = true;
+            if(q.exec()) {
+                success = true;
+                AuthCache::invalidateUserId(id);
+            }
         }
     }
     QSqlDatabase::removeDatabase(connName);
@@ -565,7 +1196,10 @@ bool DbManager::updateUserStatus(int id, bool active) {
             q.prepare("UPDATE users SET is_active = :status WHERE id = :id");
             q.bindValue(":status", active ? 1 : 0);
             q.bindValue(":id", id);
-            if (q.exec()) success = true;
+            if (q.exec()) {
+                success = true;
+                AuthCache::invalidateUserId(id);
+            }
         }
     }
     QSqlDatabase::removeDatabase(connName);
@@ -573,20 +1207,24 @@ bool DbManager::updateUserStatus(int id, bool active) {
 }
 
 bool DbManager::adminResetPassword(int id, const std::string& newTempPassword) {
+    std::string hash = PasswordHasher::hash(newTempPassword);
+
     QString connName = QString("admin_reset_%1").arg((quint64)QThread::currentThreadId());
     bool success = false;
     {
         QSqlDatabase db = getAuthDbConnection(connName);
         if(db.isOpen()) {
-            std::string hash = BCrypt::generateHash(newTempPassword);
             QSqlQuery q(db);
             // Setzt Passwort UND force_password_change = 1
             q.prepare("UPDATE users SET password_hash = :p, force_password_change = 1, password_changed_at = CURRENT_TIMESTAMP WHERE id = :id");
             q.bindValue(":p", QString::fromStdString(hash));
             q.bindValue(":id", id);
             
-            if(q.exec()) success = true;
-            else qCritical() << "Reset Pass failed:" << q.lastError().text();
+            if(q.exec()) {
+                success = true;
+                AuthCache::invalidateUserId(id);
+            }
+            else LOG_CRITICAL << "Reset Pass failed:" << q.lastError().text();
         }
     }
     QSqlDatabase::removeDatabase(connName);
@@ -595,29 +1233,40 @@ bool DbManager::adminResetPassword(int id, const std::string& newTempPassword) {
 
 int DbManager::changeOwnPassword(const std::string& username, const std::string& oldPass, const std::string& newPass) {
     QString connName = QString("user_change_%1").arg((quint64)QThread::currentThreadId());
-    int result = 1; // 1 = Error
+
+    // 1. Aktuellen Hash laden
+    std::string storedHash;
     {
         QSqlDatabase db = getAuthDbConnection(connName);
         if(db.isOpen()) {
-            // 1. Altes Passwort prüfen
             QSqlQuery check(db);
             check.prepare("SELECT password_hash FROM users WHERE username = :u");
             check.bindValue(":u", QString::fromStdString(username));
-            
             if(check.exec() && check.next()) {
-                std::string storedHash = check.value(0).toString().toStdString();
-                if(!BCrypt::validatePassword(oldPass, storedHash)) {
-                    result = 2; // Wrong old password
-                } else {
-                    // 2. Update
-                    std::string newHash = BCrypt::generateHash(newPass);
-                    QSqlQuery up(db);
-                    // force_password_change = 0 (Zwang aufheben)
-                    up.prepare("UPDATE users SET password_hash = :p, force_password_change = 0, password_changed_at = CURRENT_TIMESTAMP WHERE username = :u");
-                    up.bindValue(":p", QString::fromStdString(newHash));
-                    up.bindValue(":u", QString::fromStdString(username));
-                    if(up.exec()) result = 0; // Success
-                }
+                storedHash = check.value(0).toString().toStdString();
+            }
+        }
+    }
+    QSqlDatabase::removeDatabase(connName);
+    if (storedHash.empty()) return 1; // 1 = Error
+
+    // 2. Altes Passwort prüfen und neuen Hash erzeugen (bcrypt pool, keine offene Verbindung)
+    if(!PasswordHasher::verify(oldPass, storedHash)) return 2; // Wrong old password
+    std::string newHash = PasswordHasher::hash(newPass);
+
+    // 3. Update
+    int result = 1;
+    {
+        QSqlDatabase db = getAuthDbConnection(connName);
+        if(db.isOpen()) {
+            QSqlQuery up(db);
+            // force_password_change = 0 (Zwang aufheben)
+            up.prepare("UPDATE users SET password_hash = :p, force_password_change = 0, password_changed_at = CURRENT_TIMESTAMP WHERE username = :u");
+            up.bindValue(":p", QString::fromStdString(newHash));
+            up.bindValue(":u", QString::fromStdString(username));
+            if(up.exec()) {
+                result = 0; // Success
+                AuthCache::invalidateUser(username);
             }
         }
     }
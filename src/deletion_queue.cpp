@@ -0,0 +1,216 @@
+/**
+ * @file deletion_queue.cpp
+ * @brief Implementation of the background file deletion worker and trash.
+ */
+#include "deletion_queue.hpp"
+#include "image_processor.hpp"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+namespace {
+
+    const QString BATCH_FORMAT = "yyyyMMdd-HHmmss-zzz"; ///< Name of a trash batch directory.
+
+    // A deleted photo whose WebP versions still have to be removed
+    struct Pending {
+        QString fullPath;
+        QDateTime removedAt; ///< When the original was moved away.
+    };
+
+    std::mutex queueMutex;
+    std::condition_variable_any queueCv;
+    std::deque<Pending> queue;
+
+    std::mutex trashMutex; ///< Serializes moves into / out of / purges of the trash.
+
+    QString trashDir() {
+        return qEnvironmentVariable("TRASH_DIR", "Trash");
+    }
+
+    int graceHours() {
+        bool ok = false;
+        int hours = qEnvironmentVariable("TRASH_GRACE_HOURS").toInt(&ok);
+        return ok && hours >= 0 ? hours : 72;
+    }
+
+    std::size_t batchSize() {
+        int size = qEnvironmentVariableIntValue("DELETE_BATCH_SIZE");
+        return size > 0 ? static_cast<std::size_t>(size) : 200;
+    }
+
+    // Rejects IDs that could escape the trash directory
+    bool isSafeRelative(const QString& path) {
+        if (path.isEmpty() || QDir::isAbsolutePath(path)) return false;
+        const QStringList parts = path.split('/');
+        return std::none_of(parts.begin(), parts.end(), [](const QString& p) { return p == ".." || p.isEmpty(); });
+    }
+
+    // Original -> trash (or removed without trash); called with trashMutex held
+    void moveToTrash(const QString& fullPath, const QString& batchDir, int grace) {
+        if (!QFile::exists(fullPath)) return;
+
+        if (grace == 0 || !isSafeRelative(QDir::cleanPath(fullPath))) {
+            // No trash (or a path we cannot mirror below the trash): remove right away
+            if (!QFile::remove(fullPath)) qWarning() << "Could not delete file:" << fullPath;
+            return;
+        }
+
+        const QString target = batchDir + "/" + QDir::cleanPath(fullPath);
+        QDir().mkpath(QFileInfo(target).absolutePath());
+        if (!QFile::rename(fullPath, target)) {
+            qWarning() << "Could not move file to trash:" << fullPath;
+        }
+    }
+
+    void processBatch(const std::vector<Pending>& batch) {
+        // Per file: versions written after its own deletion are kept
+        QHash<QString, QDateTime> cutoffs;
+        for (const Pending& p : batch) {
+            // Uploaded (or restored) again under the same name: the versions are the new ones
+            if (QFile::exists(p.fullPath)) continue;
+            QDateTime& cutoff = cutoffs[p.fullPath];
+            if (!cutoff.isValid() || p.removedAt > cutoff) cutoff = p.removedAt; // deleted twice: the later one
+        }
+        if (cutoffs.isEmpty()) return;
+
+        // Derivatives can be regenerated, they do not go to the trash. Versions of a
+        // generation job still running at the deletion are removed by that job.
+        ImageProcessor::deleteAllVersions(cutoffs);
+        qDebug() << "Deletion queue removed the WebP versions of" << cutoffs.size() << "files";
+    }
+
+    void purgeExpired() {
+        const QDateTime limit = QDateTime::currentDateTime().addSecs(-3600LL * graceHours());
+        std::lock_guard lock(trashMutex);
+
+        QDir root(trashDir());
+        for (const QString& batch : root.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            QDateTime deletedAt = QDateTime::fromString(batch, BATCH_FORMAT);
+            if (deletedAt.isValid() && deletedAt < limit) {
+                QDir(root.filePath(batch)).removeRecursively();
+                qDebug() << "Purged trash batch" << batch;
+            }
+        }
+    }
+
+    void worker(std::stop_token stop) {
+        using namespace std::chrono;
+        auto nextPurge = steady_clock::now();
+
+        while (true) {
+            std::vector<Pending> batch;
+            {
+                std::unique_lock lock(queueMutex);
+                queueCv.wait_for(lock, stop, minutes(1), [] { return !queue.empty(); });
+                const std::size_t n = std::min(queue.size(), batchSize());
+                for (std::size_t i = 0; i < n; ++i) {
+                    batch.push_back(std::move(queue.front()));
+                    queue.pop_front();
+                }
+                // Shutdown only once everything that was queued is processed
+                if (batch.empty() && stop.stop_requested()) return;
+            }
+
+            if (!batch.empty()) processBatch(batch);
+
+            if (steady_clock::now() >= nextPurge) {
+                purgeExpired();
+                nextPurge = steady_clock::now() + minutes(10);
+            }
+        }
+    }
+}
+
+void DeletionQueue::start() {
+    static std::jthread thread(worker);
+    qInfo() << "Deletion queue started (trash:" << trashDir() << ", grace:" << graceHours() << "h)";
+}
+
+void DeletionQueue::remove(const QStringList& fullPaths) {
+    const int grace = graceHours();
+    {
+        // Same-filesystem renames: cheap enough for the request thread, and the
+        // original is gone before the DB change is reported (a re-upload under the
+        // same name cannot be caught by a later move)
+        std::lock_guard lock(trashMutex);
+        const QString batchDir = trashDir() + "/" + QDateTime::currentDateTime().toString(BATCH_FORMAT);
+        for (const QString& path : fullPaths) {
+            if (!path.isEmpty()) moveToTrash(path, batchDir, grace);
+        }
+    }
+
+    const QDateTime removedAt = QDateTime::currentDateTime();
+    {
+        std::lock_guard lock(queueMutex);
+        for (const QString& path : fullPaths) {
+            if (!path.isEmpty()) queue.push_back({path, removedAt});
+        }
+    }
+    queueCv.notify_one();
+}
+
+int DeletionQueue::pending() {
+    std::lock_guard lock(queueMutex);
+    return static_cast<int>(queue.size());
+}
+
+std::vector<DeletionQueue::TrashEntry> DeletionQueue::trash() {
+    std::vector<TrashEntry> entries;
+    const int grace = graceHours();
+    std::lock_guard lock(trashMutex);
+
+    QDir root(trashDir());
+    for (const QString& batch : root.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QDateTime deletedAt = QDateTime::fromString(batch, BATCH_FORMAT);
+        if (!deletedAt.isValid()) continue;
+
+        QDir batchDir(root.filePath(batch));
+        QDirIterator it(batchDir.path(), QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            QFileInfo info(it.next());
+            TrashEntry e;
+            e.originalPath = batchDir.relativeFilePath(info.filePath());
+            e.id = batch + "/" + e.originalPath;
+            e.deletedAt = deletedAt;
+            e.expiresAt = deletedAt.addSecs(3600LL * grace);
+            e.size = info.size();
+            entries.push_back(std::move(e));
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const TrashEntry& a, const TrashEntry& b) {
+        return a.deletedAt > b.deletedAt;
+    });
+    return entries;
+}
+
+std::optional<QString> DeletionQueue::restore(const QString& id) {
+    if (!isSafeRelative(id)) return std::nullopt;
+    const qsizetype slash = id.indexOf('/');
+    if (slash <= 0) return std::nullopt;
+    const QString originalPath = id.mid(slash + 1);
+
+    std::lock_guard lock(trashMutex);
+    const QString source = trashDir() + "/" + id;
+    if (!QFile::exists(source) || QFile::exists(originalPath)) return std::nullopt;
+
+    QDir().mkpath(QFileInfo(originalPath).absolutePath());
+    if (!QFile::rename(source, originalPath)) {
+        qWarning() << "Could not restore file from trash:" << source;
+        return std::nullopt;
+    }
+    return originalPath;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file directory_watcher.cpp
+ * @brief Implementation of the debounced directory watcher.
+ */
+#include "directory_watcher.hpp"
+
+#include <QDirIterator>
+#include <QFileSystemWatcher>
+#include <QStringList>
+#include <QTimer>
+
+void DirectoryWatcher::watch(const QString& dir, int debounceMs, std::function<void()> reload) {
+    // Never deleted: watching ends with the application (main thread, Qt event loop)
+    auto* watcher = new QFileSystemWatcher();
+    auto* debounce = new QTimer();
+    debounce->setSingleShot(true);
+    debounce->setInterval(debounceMs);
+
+    auto addPaths = [dir, watcher]() {
+        QStringList paths{dir};
+        QDirIterator it(dir, QDir::AllEntries | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext()) paths << it.next();
+        watcher->addPaths(paths); // already watched paths are skipped
+    };
+    addPaths();
+
+    auto changed = [debounce](const QString&) { debounce->start(); };
+    QObject::connect(watcher, &QFileSystemWatcher::directoryChanged, debounce, changed);
+    QObject::connect(watcher, &QFileSystemWatcher::fileChanged, debounce, changed);
+    QObject::connect(debounce, &QTimer::timeout, [reload = std::move(reload), addPaths]() {
+        reload();
+        addPaths();
+    });
+}
@@ -0,0 +1,241 @@
+/**
+ * @file facet_index.cpp
+ * @brief Implementation of the in-memory bitmap facet index.
+ */
+#include "facet_index.hpp"
+#include "roaring_bitmap.hpp"
+
+#include <QHash>
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+
+namespace {
+
+    struct Entry {
+        QString folder;
+        qint64 sortKey = 0;
+        std::array<QStringList, FacetIndex::FacetCount> values;
+    };
+
+    std::shared_mutex indexMutex;
+    std::array<QHash<QString, RoaringBitmap>, FacetIndex::FacetCount> facetBitmaps;
+    QHash<QString, RoaringBitmap> folderBitmaps;
+    QHash<std::uint32_t, Entry> entries;
+    RoaringBitmap allPictures;
+    bool loaded = false;
+
+    std::array<QStringList, FacetIndex::FacetCount> valuesOf(const FacetIndex::PhotoFacets& f) {
+        std::array<QStringList, FacetIndex::FacetCount> v;
+        if (!f.camera.isEmpty()) v[FacetIndex::Camera] << f.camera;
+        if (!f.country.isEmpty()) v[FacetIndex::Country] << f.country;
+        if (!f.city.isEmpty()) v[FacetIndex::City] << f.city;
+        if (f.year > 0) v[FacetIndex::Year] << QString::number(f.year);
+        for (const QString& k : f.keywords) {
+            QString tag = k.trimmed();
+            if (!tag.isEmpty() && !v[FacetIndex::Keyword].contains(tag)) v[FacetIndex::Keyword] << tag;
+        }
+        return v;
+    }
+
+    // Removes 'id' from the bitmap of 'key' and drops the bitmap once it is empty
+    void unset(QHash<QString, RoaringBitmap>& bitmaps, const QString& key, std::uint32_t id) {
+        auto it = bitmaps.find(key);
+        if (it == bitmaps.end()) return;
+        it->remove(id);
+        if (it->empty()) bitmaps.erase(it);
+    }
+
+    void removeLocked(std::uint32_t id) {
+        auto it = entries.find(id);
+        if (it == entries.end()) return;
+        for (int f = 0; f < FacetIndex::FacetCount; ++f) {
+            for (const QString& value : it->values[f]) unset(facetBitmaps[f], value, id);
+        }
+        unset(folderBitmaps, it->folder, id);
+        allPictures.remove(id);
+        entries.erase(it);
+    }
+
+    void addLocked(std::uint32_t id, Entry entry) {
+        for (int f = 0; f < FacetIndex::FacetCount; ++f) {
+            for (const QString& value : entry.values[f]) facetBitmaps[f][value].add(id);
+        }
+        folderBitmaps[entry.folder].add(id);
+        allPictures.add(id);
+        entries.insert(id, std::move(entry));
+    }
+
+    /**
+     * Intersects all constraints of the filter (caller holds the lock).
+     * 'skip' excludes one facet's own filter (used for its counts).
+     */
+    RoaringBitmap matchLocked(const FacetIndex::Filter& filter, const std::optional<QString>& folder, int skip = -1) {
+        static const RoaringBitmap none;
+        std::vector<const RoaringBitmap*> sets;
+
+        auto require = [&sets](const QHash<QString, RoaringBitmap>& bitmaps, const QString& key) {
+            auto it = bitmaps.constFind(key);
+            sets.push_back(it == bitmaps.constEnd() ? &none : &it.value());
+        };
+
+        if (folder) require(folderBitmaps, *folder);
+        for (int f = 0; f < FacetIndex::Keyword; ++f) {
+            if (f != skip && !filter.values[f].isEmpty()) require(facetBitmaps[f], filter.values[f]);
+        }
+        if (skip != FacetIndex::Keyword) {
+            for (const QString& k : filter.keywords) require(facetBitmaps[FacetIndex::Keyword], k);
+        }
+
+        if (sets.empty()) return allPictures;
+
+        // Start with the smallest set, every further intersection can only shrink it
+        std::sort(sets.begin(), sets.end(), [](const RoaringBitmap* a, const RoaringBitmap* b) {
+            return a->cardinality() < b->cardinality();
+        });
+        RoaringBitmap result = *sets.front();
+        for (std::size_t i = 1; i < sets.size() && !result.empty(); ++i) result &= *sets[i];
+        return result;
+    }
+}
+
+bool FacetIndex::Filter::isEmpty() const {
+    return keywords.isEmpty() && std::all_of(values.begin(), values.end(), [](const QString& v) { return v.isEmpty(); });
+}
+
+const char* FacetIndex::name(Facet facet) {
+    switch (facet) {
+        case Camera: return "camera";
+        case Country: return "country";
+        case City: return "city";
+        case Year: return "year";
+        case Keyword: return "keyword";
+        default: return "";
+    }
+}
+
+// ------------------------------------------------------------------
+// UPDATES
+// ------------------------------------------------------------------
+
+void FacetIndex::rebuild(const std::vector<std::pair<std::uint32_t, PhotoFacets>>& photos) {
+    std::unique_lock lock(indexMutex);
+    for (auto& bitmaps : facetBitmaps) bitmaps.clear();
+    folderBitmaps.clear();
+    entries.clear();
+    allPictures = RoaringBitmap();
+
+    entries.reserve(static_cast<qsizetype>(photos.size()));
+    for (const auto& [id, facets] : photos) {
+        removeLocked(id); // the loader query may return a picture more than once
+        addLocked(id, Entry{facets.folder, facets.sortKey, valuesOf(facets)});
+    }
+    loaded = true;
+}
+
+void FacetIndex::put(std::uint32_t id, const PhotoFacets& facets) {
+    Entry entry{facets.folder, facets.sortKey, valuesOf(facets)};
+    std::unique_lock lock(indexMutex);
+    removeLocked(id);
+    addLocked(id, std::move(entry));
+}
+
+void FacetIndex::setKeywords(std::uint32_t id, const QStringList& keywords) {
+    PhotoFacets tmp;
+    tmp.keywords = keywords;
+    QStringList tags = valuesOf(tmp)[Keyword];
+
+    std::unique_lock lock(indexMutex);
+    auto it = entries.find(id);
+    if (it == entries.end()) return;
+    for (const QString& old : it->values[Keyword]) unset(facetBitmaps[Keyword], old, id);
+    for (const QString& tag : tags) facetBitmaps[Keyword][tag].add(id);
+    it->values[Keyword] = std::move(tags);
+}
+
+void FacetIndex::applyKeywordChanges(const std::vector<std::pair<std::uint32_t, QString>>& added,
+                                     const std::vector<std::pair<std::uint32_t, QString>>& removed) {
+    std::unique_lock lock(indexMutex);
+    for (const auto& [id, tag] : removed) {
+        auto it = entries.find(id);
+        if (it == entries.end() || !it->values[Keyword].removeOne(tag)) continue;
+        unset(facetBitmaps[Keyword], tag, id);
+    }
+    for (const auto& [id, tag] : added) {
+        auto it = entries.find(id);
+        if (it == entries.end() || it->values[Keyword].contains(tag)) continue;
+        it->values[Keyword] << tag;
+        facetBitmaps[Keyword][tag].add(id);
+    }
+}
+
+void FacetIndex::remove(std::uint32_t id) {
+    std::unique_lock lock(indexMutex);
+    removeLocked(id);
+}
+
+// ------------------------------------------------------------------
+// QUERIES
+// ------------------------------------------------------------------
+
+bool FacetIndex::isReady() {
+    std::shared_lock lock(indexMutex);
+    return loaded;
+}
+
+std::size_t FacetIndex::size() {
+    std::shared_lock lock(indexMutex);
+    return static_cast<std::size_t>(entries.size());
+}
+
+FacetIndex::Page FacetIndex::page(const Filter& filter, const std::optional<QString>& folder, int offset, int limit,
+                                  std::optional<qint64> before) {
+    std::vector<std::pair<qint64, std::uint32_t>> keyed;
+    {
+        std::shared_lock lock(indexMutex);
+        for (std::uint32_t id : matchLocked(filter, folder).toVector()) {
+            qint64 key = entries.constFind(id)->sortKey;
+            if (!before || key < *before) keyed.emplace_back(key, id);
+        }
+    }
+
+    Page result;
+    result.total = keyed.size();
+    std::size_t begin = std::min<std::size_t>(std::max(offset, 0), keyed.size());
+    std::size_t end = std::min<std::size_t>(begin + std::max(limit, 0), keyed.size());
+
+    // Newest first (like ORDER BY file_datetime DESC), only the requested prefix is sorted
+    std::partial_sort(keyed.begin(), keyed.begin() + end, keyed.end(), std::greater<>());
+    for (std::size_t i = begin; i < end; ++i) result.ids.push_back(keyed[i].second);
+    return result;
+}
+
+FacetIndex::Counts FacetIndex::counts(const Filter& filter, const std::optional<QString>& folder, int limit, std::uint64_t& total) {
+    Counts result;
+    std::shared_lock lock(indexMutex);
+
+    RoaringBitmap full = matchLocked(filter, folder);
+    total = full.cardinality();
+
+    for (int f = 0; f < FacetCount; ++f) {
+        // Own filter of a single-valued facet is ignored, keywords drill down
+        bool ownFilter = f < Keyword && !filter.values[f].isEmpty();
+        RoaringBitmap base = ownFilter ? matchLocked(filter, folder, f) : RoaringBitmap();
+        const RoaringBitmap& scope = ownFilter ? base : full;
+
+        auto& list = result[f];
+        for (auto it = facetBitmaps[f].constBegin(); it != facetBitmaps[f].constEnd(); ++it) {
+            std::uint64_t n = scope.andCardinality(it.value());
+            if (n > 0) list.push_back(Count{it.key(), n});
+        }
+
+        std::size_t keep = std::min<std::size_t>(std::max(limit, 0), list.size());
+        std::partial_sort(list.begin(), list.begin() + keep, list.end(), [](const Count& a, const Count& b) {
+            return a.count != b.count ? a.count > b.count : a.value < b.value;
+        });
+        list.resize(keep);
+    }
+    return result;
+}
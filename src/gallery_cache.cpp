@@ -0,0 +1,128 @@
+/**
+ * @file gallery_cache.cpp
+ * @brief Implementation of the gallery response cache.
+ */
+#include "gallery_cache.hpp"
+#include "utils.hpp"
+
+#include <QDateTime>
+#include <QHash>
+
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+    struct Node {
+        std::string key;
+        std::uint64_t version = 0;
+        GalleryCache::Entry entry;
+        std::size_t bytes = 0;
+    };
+
+    std::mutex mutex;
+    std::list<Node> lru; ///< Most recently used first.
+    std::unordered_map<std::string, std::list<Node>::iterator> entries;
+    std::size_t totalBytes = 0;
+
+    QHash<QString, std::uint64_t> versions; ///< Folder -> version (missing = 0).
+    std::uint64_t sequence = 0;
+
+    GalleryCache::Stats counters;
+
+    // Distinguishes ETags of different server runs (versions restart at 0)
+    const std::string EPOCH = std::to_string(QDateTime::currentMSecsSinceEpoch());
+
+    std::size_t capacityBytes() {
+        static const std::size_t capacity = [] {
+            bool ok = false;
+            int mb = qEnvironmentVariable("GALLERY_CACHE_MB").toInt(&ok);
+            return static_cast<std::size_t>(ok && mb >= 0 ? mb : 64) * 1024 * 1024;
+        }();
+        return capacity;
+    }
+
+    void erase(std::list<Node>::iterator it) {
+        totalBytes -= it->bytes;
+        entries.erase(it->key);
+        lru.erase(it);
+    }
+}
+
+std::uint64_t GalleryCache::version(const QString& folder) {
+    std::lock_guard lock(mutex);
+    return versions.value(folder, 0);
+}
+
+std::string GalleryCache::etag(const std::string& key, std::uint64_t version) {
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016zx", std::hash<std::string>{}(key));
+    return "\"" + EPOCH + "-" + std::to_string(version) + "-" + hash + "\"";
+}
+
+bool GalleryCache::notModified(const std::string& ifNoneMatch, const std::string& etag) {
+    if (!utils::etagMatches(ifNoneMatch, etag)) return false;
+
+    std::lock_guard lock(mutex);
+    ++counters.notModified;
+    return true;
+}
+
+std::optional<GalleryCache::Entry> GalleryCache::get(const std::string& key, std::uint64_t version) {
+    std::lock_guard lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        ++counters.misses;
+        return std::nullopt;
+    }
+    if (it->second->version != version) {
+        // Folder changed since the entry was built
+        erase(it->second);
+        ++counters.misses;
+        return std::nullopt;
+    }
+    lru.splice(lru.begin(), lru, it->second);
+    ++counters.hits;
+    return it->second->entry;
+}
+
+void GalleryCache::put(const std::string& key, std::uint64_t version, Entry entry) {
+    const std::size_t bytes = key.size() + entry.body.size() + entry.totalCount.size() + sizeof(Node);
+    if (bytes > capacityBytes() / 4) return; // would evict too much, not worth it
+
+    // If a write happened while the response was built, the old version makes get() drop it
+    std::lock_guard lock(mutex);
+    if (auto it = entries.find(key); it != entries.end()) erase(it->second);
+
+    lru.push_front(Node{key, version, std::move(entry), bytes});
+    entries.emplace(key, lru.begin());
+    totalBytes += bytes;
+
+    while (totalBytes > capacityBytes() && !lru.empty()) erase(std::prev(lru.end()));
+}
+
+void GalleryCache::invalidate(const QString& folder) {
+    std::lock_guard lock(mutex);
+    ++sequence;
+
+    // Folder itself + all parents ("a/b/c" -> "a/b/c", "a/b", "a", "")
+    QString f = folder;
+    for (;;) {
+        versions.insert(f, sequence);
+        if (f.isEmpty()) break;
+        qsizetype slash = f.lastIndexOf('/');
+        f = slash < 0 ? QString() : f.left(slash);
+    }
+}
+
+GalleryCache::Stats GalleryCache::stats() {
+    std::lock_guard lock(mutex);
+    Stats s = counters;
+    s.entries = entries.size();
+    s.bytes = totalBytes;
+    return s;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file geo_index.cpp
+ * @brief Implementation of the map clustering grid.
+ */
+#include "geo_index.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+    struct Cell {
+        std::uint32_t count = 0;
+        double sumLat = 0.0;
+        double sumLon = 0.0;
+        std::uint32_t representative = 0;
+    };
+
+    using CellMap = std::unordered_map<std::uint64_t, Cell>;
+
+    std::shared_mutex indexMutex;
+    std::array<CellMap, GeoIndex::MAX_ZOOM + 1> levels;
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> finestIds; ///< Photo IDs per MAX_ZOOM cell.
+    std::unordered_map<std::uint32_t, std::pair<double, double>> positions; ///< ID -> (lat, lon).
+
+    constexpr std::uint32_t gridSize(int zoom) { return 1u << (zoom + 2); }
+
+    // Clamped in double: casting an out-of-range (or NaN) value to uint32 is undefined
+    std::uint32_t cell(double pos, int zoom) {
+        const double last = gridSize(zoom) - 1;
+        if (!(pos > 0.0)) return 0;
+        return static_cast<std::uint32_t>(std::min(pos, last));
+    }
+
+    std::uint32_t column(double lon, int zoom) {
+        return cell((lon + 180.0) / 360.0 * gridSize(zoom), zoom);
+    }
+
+    std::uint32_t row(double lat, int zoom) {
+        return cell((lat + 90.0) / 180.0 * gridSize(zoom), zoom);
+    }
+
+    constexpr std::uint64_t cellKey(std::uint32_t x, std::uint32_t y) {
+        return (static_cast<std::uint64_t>(y) << 32) | x;
+    }
+
+    void addLocked(std::uint32_t id, double lat, double lon) {
+        for (int z = 0; z <= GeoIndex::MAX_ZOOM; ++z) {
+            std::uint64_t key = cellKey(column(lon, z), row(lat, z));
+            Cell& cell = levels[z][key];
+            ++cell.count;
+            cell.sumLat += lat;
+            cell.sumLon += lon;
+            if (cell.representative == 0) cell.representative = id;
+            if (z == GeoIndex::MAX_ZOOM) finestIds[key].push_back(id);
+        }
+        positions[id] = {lat, lon};
+    }
+
+    void removeLocked(std::uint32_t id) {
+        auto pos = positions.find(id);
+        if (pos == positions.end()) return;
+        const auto [lat, lon] = pos->second;
+
+        // Finest level first: a coarse cell takes its new representative from a child
+        for (int z = GeoIndex::MAX_ZOOM; z >= 0; --z) {
+            const std::uint32_t x = column(lon, z);
+            const std::uint32_t y = row(lat, z);
+            auto it = levels[z].find(cellKey(x, y));
+            if (it == levels[z].end()) continue;
+
+            Cell& cell = it->second;
+            if (z == GeoIndex::MAX_ZOOM) {
+                auto& ids = finestIds[it->first];
+                std::erase(ids, id);
+                if (ids.empty()) finestIds.erase(it->first);
+                else if (cell.representative == id) cell.representative = ids.front();
+            } else if (cell.representative == id) {
+                cell.representative = 0;
+                for (std::uint32_t cy = 2 * y; cy <= 2 * y + 1 && !cell.representative; ++cy) {
+                    for (std::uint32_t cx = 2 * x; cx <= 2 * x + 1 && !cell.representative; ++cx) {
+                        auto child = levels[z + 1].find(cellKey(cx, cy));
+                        if (child != levels[z + 1].end()) cell.representative = child->second.representative;
+                    }
+                }
+            }
+
+            if (--cell.count == 0) {
+                levels[z].erase(it);
+            } else {
+                cell.sumLat -= lat;
+                cell.sumLon -= lon;
+            }
+        }
+        positions.erase(pos);
+    }
+
+    void collect(const CellMap& cells, int zoom, double west, double south, double east, double north,
+                 std::vector<GeoIndex::Cluster>& out) {
+        const std::uint32_t x0 = column(west, zoom), x1 = column(east, zoom);
+        const std::uint32_t y0 = row(south, zoom), y1 = row(north, zoom);
+
+        auto emit = [&out](const Cell& c) {
+            out.push_back(GeoIndex::Cluster{c.sumLat / c.count, c.sumLon / c.count, c.count, c.representative});
+        };
+
+        // Probe the cells of the box, or scan the occupied cells if that is cheaper
+        const std::uint64_t boxCells = static_cast<std::uint64_t>(x1 - x0 + 1) * (y1 - y0 + 1);
+        if (boxCells <= cells.size()) {
+            for (std::uint32_t y = y0; y <= y1; ++y) {
+                for (std::uint32_t x = x0; x <= x1; ++x) {
+                    auto it = cells.find(cellKey(x, y));
+                    if (it != cells.end()) emit(it->second);
+                }
+            }
+        } else {
+            for (const auto& [key, cell] : cells) {
+                const auto x = static_cast<std::uint32_t>(key);
+                const auto y = static_cast<std::uint32_t>(key >> 32);
+                if (x >= x0 && x <= x1 && y >= y0 && y <= y1) emit(cell);
+            }
+        }
+    }
+}
+
+bool GeoIndex::isValid(double lat, double lon) {
+    if (lat == 0.0 && lon == 0.0) return false;
+    return std::isfinite(lat) && std::isfinite(lon) && std::abs(lat) <= 90.0 && std::abs(lon) <= 180.0;
+}
+
+void GeoIndex::rebuild(const std::vector<std::pair<std::uint32_t, std::pair<double, double>>>& photos) {
+    std::unique_lock lock(indexMutex);
+    for (auto& level : levels) level.clear();
+    finestIds.clear();
+    positions.clear();
+    positions.reserve(photos.size());
+
+    for (const auto& [id, pos] : photos) {
+        if (!isValid(pos.first, pos.second)) continue;
+        removeLocked(id);
+        addLocked(id, pos.first, pos.second);
+    }
+}
+
+void GeoIndex::add(std::uint32_t id, double lat, double lon) {
+    if (!isValid(lat, lon)) return;
+    std::unique_lock lock(indexMutex);
+    removeLocked(id);
+    addLocked(id, lat, lon);
+}
+
+void GeoIndex::remove(std::uint32_t id) {
+    std::unique_lock lock(indexMutex);
+    removeLocked(id);
+}
+
+std::vector<GeoIndex::Cluster> GeoIndex::clusters(const BBox& box, int zoom) {
+    zoom = std::clamp(zoom, 0, MAX_ZOOM);
+    const double south = std::clamp(std::min(box.south, box.north), -90.0, 90.0);
+    const double north = std::clamp(std::max(box.south, box.north), -90.0, 90.0);
+    const double west = std::clamp(box.west, -180.0, 180.0);
+    const double east = std::clamp(box.east, -180.0, 180.0);
+
+    std::vector<Cluster> result;
+    std::shared_lock lock(indexMutex);
+    if (west <= east) {
+        collect(levels[zoom], zoom, west, south, east, north, result);
+    } else {
+        // Box crosses the antimeridian
+        collect(levels[zoom], zoom, west, south, 180.0, north, result);
+        collect(levels[zoom], zoom, -180.0, south, east, north, result);
+    }
+    return result;
+}
+
+std::size_t GeoIndex::size() {
+    std::shared_lock lock(indexMutex);
+    return positions.size();
+}
@@ -1,12 +1,23 @@
 #include "image_processor.hpp"
+#include "metrics.hpp"
+#include "gallery_cache.hpp"
 #include <QImage>
 #include <QDir>
 #include <QFileInfo>
 #include <QDebug>
+#include <QHash>
+#include <QSet>
+#include <QThreadPool>
+
+#include <atomic>
 
 // Desired widths for the generated WebP images
 const std::vector<int> ImageProcessor::TARGET_WIDTHS = {480, 680, 800, 1024, 1280};
 
+namespace {
+    std::atomic<int> pendingWebPJobs{0};
+}
+
 void ImageProcessor::generateWebPVersions(const QString& sourcePath, const QString& parentDir) {
     QImage img(sourcePath);
     if (img.isNull()) {
@@ -35,16 +46,50 @@ void ImageProcessor::generateWebPVersions(const QString& sourcePath, const QStri
         QImage scaled = img.scaledToWidth(width, Qt::SmoothTransformation);
 
         // Target path: parentDir/webp/Filename_800.webp
-        QString webpFilename = QString("%1_%2.webp").arg(baseName).arg(width);
-        QString targetPath = dir.filePath("webp/" + webpFilename);
+        QString targetPath = dir.filePath("webp/" + versionFileName(baseName, width));
 
         // Save (Format "WEBP", Quality 85 is a good standard)
         if (!scaled.save(targetPath, "WEBP", 85)) {
             qWarning() << "Failed to save WebP:" << targetPath;
+            continue;
         }
+        static auto& webpBytes = Metrics::counter("photos_bytes_written_total", "Bytes written below Photos/",
+                                                  Metrics::labels({{"kind", "webp"}}));
+        webpBytes.inc(static_cast<std::uint64_t>(QFileInfo(targetPath).size()));
     }
 }
 
+void ImageProcessor::enqueueWebPVersions(const QString& sourcePath, const QString& parentDir) {
+    static auto& duration = Metrics::histogram("image_processing_seconds", "Time to generate the WebP versions of a picture",
+                                               {}, {0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60});
+    pendingWebPJobs.fetch_add(1, std::memory_order_relaxed);
+    // Copies of the QStrings: the caller's request scope ends before the job runs
+    QThreadPool::globalInstance()->start([sourcePath, parentDir]() {
+        {
+            Metrics::Timer timer(duration);
+            generateWebPVersions(sourcePath, parentDir);
+        }
+        // Deleted while we were generating: the deletion queue keeps versions newer
+        // than the deletion (they could belong to a new upload), so remove ours here
+        if (!QFileInfo::exists(sourcePath)) {
+            deleteAllVersions(sourcePath);
+            qDebug() << "Source deleted during processing, removed its WebP versions:" << sourcePath;
+        }
+        // Cached listings were built without these versions in their srcset
+        // ("Photos/2025" -> folder "2025")
+        QString folder = parentDir;
+        if (folder == "Photos") folder.clear();
+        else if (folder.startsWith("Photos/")) folder = folder.mid(7);
+        GalleryCache::invalidate(folder);
+        pendingWebPJobs.fetch_sub(1, std::memory_order_relaxed);
+        qDebug() << "Background processing finished for:" << sourcePath;
+    });
+}
+
+int ImageProcessor::pendingJobs() {
+    return pendingWebPJobs.load(std::memory_order_relaxed);
+}
+
 // Deletes the webp versions
 void ImageProcessor::deleteAllVersions(const QString& sourcePath) {
     QFileInfo fileInfo(sourcePath);
@@ -53,10 +98,47 @@ void ImageProcessor::deleteAllVersions(const QString& sourcePath) {
 
     if (dir.cd("webp")) { // Switch to webp subdirectory
         for (int width : TARGET_WIDTHS) {
-            QString webpName = QString("%1_%2.webp").arg(baseName).arg(width);
+            QString webpName = versionFileName(baseName, width);
             if (dir.exists(webpName)) {
                 dir.remove(webpName);
             }
         }
     }
-}
\ No newline at end of file
+}
+// Batch variant: one listing of each webp folder instead of one stat per width and file
+void ImageProcessor::deleteAllVersions(const QHash<QString, QDateTime>& cutoffs) {
+    // folder -> base name -> cutoff of that file
+    QHash<QString, QHash<QString, QDateTime>> cutoffsByDir;
+    for (auto it = cutoffs.cbegin(); it != cutoffs.cend(); ++it) {
+        QFileInfo fileInfo(it.key());
+        cutoffsByDir[fileInfo.path()].insert(fileInfo.completeBaseName(), it.value());
+    }
+
+    for (auto it = cutoffsByDir.cbegin(); it != cutoffsByDir.cend(); ++it) {
+        QDir dir(it.key());
+        if (!dir.cd("webp")) continue;
+
+        for (const QString& webpName : dir.entryList({"*.webp"}, QDir::Files)) {
+            // "<baseName>_<width>.webp"
+            const qsizetype underscore = webpName.lastIndexOf('_');
+            if (underscore <= 0) continue;
+            auto cutoff = it.value().constFind(webpName.left(underscore));
+            if (cutoff == it.value().cend()) continue;
+            if (cutoff->isValid() && QFileInfo(dir.filePath(webpName)).lastModified() > *cutoff) continue;
+            if (!dir.remove(webpName)) qWarning() << "Could not delete WebP version:" << dir.filePath(webpName);
+        }
+    }
+}
+
+QString ImageProcessor::versionFileName(const QString& baseName, int width) {
+    return QString("%1_%2.webp").arg(baseName).arg(width);
+}
+
+std::vector<int> ImageProcessor::versionWidths(int originalWidth) {
+    // Same rule as generateWebPVersions(): only widths below the original
+    std::vector<int> widths;
+    for (int width : TARGET_WIDTHS) {
+        if (originalWidth > width) widths.push_back(width);
+    }
+    return widths;
+}
@@ -0,0 +1,212 @@
+/**
+ * @file json_writer.cpp
+ * @brief Implementation of the streaming JSON writer.
+ */
+#include "json_writer.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+    constexpr char HEX[] = "0123456789abcdef";
+
+    // Escapes the characters JSON requires (quote, backslash, control characters)
+    inline bool needsEscape(char16_t c) {
+        return c < 0x20 || c == u'"' || c == u'\\';
+    }
+
+    void appendControl(std::string& out, char16_t c) {
+        switch (c) {
+            case u'"':  out += "\\\""; break;
+            case u'\\': out += "\\\\"; break;
+            case u'\n': out += "\\n"; break;
+            case u'\r': out += "\\r"; break;
+            case u'\t': out += "\\t"; break;
+            case u'\b': out += "\\b"; break;
+            case u'\f': out += "\\f"; break;
+            default: {
+                const char esc[] = {'\\', 'u', '0', '0', HEX[(c >> 4) & 0xF], HEX[c & 0xF]};
+                out.append(esc, sizeof(esc));
+            }
+        }
+    }
+
+    void appendUtf8(std::string& out, char32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+}
+
+JsonWriter::JsonWriter(std::size_t reserveBytes) {
+    out.reserve(reserveBytes);
+    hasItems.reserve(8);
+}
+
+void JsonWriter::separator() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (hasItems.empty()) return; // top level
+    if (hasItems.back()) out += ',';
+    hasItems.back() = true;
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    separator();
+    out += '{';
+    hasItems.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    out += '}';
+    hasItems.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separator();
+    out += '[';
+    hasItems.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    out += ']';
+    hasItems.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    separator();
+    out += '"';
+    appendEscaped(name);
+    out += "\":";
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(QStringView s) {
+    separator();
+    out += '"';
+    appendEscaped(s);
+    out += '"';
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view s) {
+    separator();
+    out += '"';
+    appendEscaped(s);
+    out += '"';
+    return *this;
+}
+
+JsonWriter& JsonWriter::integer(std::int64_t v) {
+    separator();
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, res.ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::unsignedInteger(std::uint64_t v) {
+    separator();
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, res.ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double v) {
+    if (!std::isfinite(v)) return null();
+    separator();
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v); // shortest round trip
+    out.append(buf, res.ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool v) {
+    separator();
+    out += v ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separator();
+    out += "null";
+    return *this;
+}
+
+JsonWriter& JsonWriter::raw(std::string_view json) {
+    separator();
+    out += json;
+    return *this;
+}
+
+std::string JsonWriter::take() {
+    std::string result = std::move(out);
+    out.clear();
+    hasItems.clear();
+    afterKey = false;
+    return result;
+}
+
+void JsonWriter::appendEscaped(QStringView s) {
+    const char16_t* p = s.utf16();
+    const char16_t* end = p + s.size();
+
+    while (p < end) {
+        // ASCII run without escapes: byte-wise copy
+        const char16_t* run = p;
+        while (p < end && *p < 0x80 && !needsEscape(*p)) ++p;
+        if (p > run) {
+            const std::size_t n = static_cast<std::size_t>(p - run);
+            const std::size_t pos = out.size();
+            out.resize(pos + n);
+            for (std::size_t i = 0; i < n; ++i) out[pos + i] = static_cast<char>(run[i]);
+        }
+        if (p == end) break;
+
+        const char16_t c = *p++;
+        if (c < 0x80) {
+            appendControl(out, c);
+        } else if (c >= 0xD800 && c <= 0xDBFF && p < end && *p >= 0xDC00 && *p <= 0xDFFF) {
+            const char32_t cp = 0x10000 + ((static_cast<char32_t>(c) - 0xD800) << 10) + (*p++ - 0xDC00);
+            appendUtf8(out, cp);
+        } else if (c >= 0xD800 && c <= 0xDFFF) {
+            appendUtf8(out, 0xFFFD); // lone surrogate
+        } else {
+            appendUtf8(out, c);
+        }
+    }
+}
+
+void JsonWriter::appendEscaped(std::string_view s) {
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        const auto c = static_cast<unsigned char>(s[i]);
+        if (!needsEscape(c)) continue;
+        out.append(s.data() + start, i - start);
+        appendControl(out, c);
+        start = i + 1;
+    }
+    out.append(s.data() + start, s.size() - start);
+}
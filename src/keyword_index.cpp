@@ -0,0 +1,84 @@
+/**
+ * @file keyword_index.cpp
+ * @brief Implementation of the keyword autocomplete index.
+ */
+#include "keyword_index.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+
+namespace {
+
+    struct Entry {
+        QString key; ///< Case-folded tag (sort key).
+        QString tag; ///< Original spelling.
+        std::uint32_t usage = 0;
+    };
+
+    std::shared_mutex indexMutex;
+    std::vector<Entry> entries; ///< Sorted by (key, tag).
+
+    bool entryLess(const Entry& a, const Entry& b) {
+        return a.key != b.key ? a.key < b.key : a.tag < b.tag;
+    }
+
+    // Position of 'tag' (or where it would be inserted); caller holds the lock
+    std::vector<Entry>::iterator locate(const QString& tag) {
+        Entry probe{tag.toCaseFolded(), tag, 0};
+        return std::lower_bound(entries.begin(), entries.end(), probe, entryLess);
+    }
+
+    Entry& findOrInsert(const QString& tag) {
+        auto it = locate(tag);
+        if (it == entries.end() || it->tag != tag) {
+            it = entries.insert(it, Entry{tag.toCaseFolded(), tag, 0});
+        }
+        return *it;
+    }
+}
+
+void KeywordIndex::rebuild(const std::vector<std::pair<QString, std::uint32_t>>& tags) {
+    std::vector<Entry> fresh;
+    fresh.reserve(tags.size());
+    for (const auto& [tag, usage] : tags) fresh.push_back(Entry{tag.toCaseFolded(), tag, usage});
+    std::sort(fresh.begin(), fresh.end(), entryLess);
+
+    std::unique_lock lock(indexMutex);
+    entries = std::move(fresh);
+}
+
+void KeywordIndex::adjustUsage(const QString& tag, int delta) {
+    if (tag.isEmpty() || delta == 0) return;
+    std::unique_lock lock(indexMutex);
+    Entry& entry = findOrInsert(tag);
+    if (delta > 0) entry.usage += static_cast<std::uint32_t>(delta);
+    else entry.usage -= std::min(entry.usage, static_cast<std::uint32_t>(-delta));
+}
+
+std::vector<KeywordIndex::Suggestion> KeywordIndex::suggest(const QString& prefix, int limit) {
+    if (limit <= 0) return {};
+    const QString key = prefix.toCaseFolded();
+
+    std::vector<Suggestion> result;
+    {
+        std::shared_lock lock(indexMutex);
+        auto first = std::lower_bound(entries.begin(), entries.end(), key,
+                                      [](const Entry& e, const QString& k) { return e.key < k; });
+        for (auto it = first; it != entries.end() && it->key.startsWith(key); ++it) {
+            result.push_back(Suggestion{it->tag, it->usage});
+        }
+    }
+
+    std::size_t keep = std::min<std::size_t>(limit, result.size());
+    std::partial_sort(result.begin(), result.begin() + keep, result.end(), [](const Suggestion& a, const Suggestion& b) {
+        return a.usage != b.usage ? a.usage > b.usage : a.tag < b.tag;
+    });
+    result.resize(keep);
+    return result;
+}
+
+std::size_t KeywordIndex::size() {
+    std::shared_lock lock(indexMutex);
+    return entries.size();
+}
@@ -0,0 +1,256 @@
+/**
+ * @file logger.cpp
+ * @brief Implementation of the per-thread log rings and the JSON writer thread.
+ */
+#include "logger.hpp"
+#include "json_writer.hpp"
+#include "metrics.hpp"
+
+#include <QByteArray>
+#include <QString>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+std::atomic<int> Logger::minLevel{Logger::Info};
+
+namespace {
+
+    struct Record {
+        QtMsgType type = QtDebugMsg;
+        std::int64_t micros = 0; ///< Unix time.
+        const char* file = nullptr; ///< __FILE__ / Q_FUNC_INFO literals of the call site.
+        const char* function = nullptr;
+        int line = 0;
+        std::string category;
+        std::string message;
+    };
+
+    // Single producer (the owning thread), single consumer (the writer thread).
+    // head/tail count up forever, the slot is index & mask.
+    struct Ring {
+        explicit Ring(std::size_t capacity, std::uint32_t thread)
+            : slots(capacity), mask(capacity - 1), thread(thread) {}
+
+        std::vector<Record> slots;
+        const std::size_t mask;
+        const std::uint32_t thread; ///< Sequential thread number in the records.
+        alignas(64) std::atomic<std::size_t> head{0}; ///< Written by the producer.
+        alignas(64) std::atomic<std::size_t> tail{0}; ///< Written by the consumer.
+        std::atomic<bool> closed{false}; ///< Owning thread has exited.
+    };
+
+    std::mutex ringsMutex; ///< Only taken when a thread logs for the first time and by the writer.
+    std::vector<std::shared_ptr<Ring>> rings;
+
+    std::mutex writerMutex;
+    std::condition_variable writerWake;
+    std::thread writer;
+    std::atomic<bool> running{false};
+    std::mutex syncMutex; ///< Synchronous writes (fatal, after stop()).
+    Metrics::Counter* droppedCounter = nullptr;
+
+    std::size_t ringCapacity() {
+        static const std::size_t capacity = [] {
+            int requested = qEnvironmentVariableIntValue("LOG_RING_SIZE");
+            std::size_t n = 64;
+            while (n < static_cast<std::size_t>(requested > 0 ? requested : 1024)) n <<= 1;
+            return n;
+        }();
+        return capacity;
+    }
+
+    // Unregisters nothing: the writer drops closed rings once they are empty
+    struct LocalRing {
+        std::shared_ptr<Ring> ring;
+        ~LocalRing() {
+            if (ring) ring->closed.store(true, std::memory_order_release);
+        }
+    };
+
+    Ring& localRing() {
+        thread_local LocalRing local;
+        if (!local.ring) {
+            static std::atomic<std::uint32_t> nextThread{1};
+            local.ring = std::make_shared<Ring>(ringCapacity(), nextThread.fetch_add(1, std::memory_order_relaxed));
+            std::lock_guard lock(ringsMutex);
+            rings.push_back(local.ring);
+        }
+        return *local.ring;
+    }
+
+    Logger::Level levelOf(QtMsgType type) {
+        switch (type) {
+            case QtDebugMsg: return Logger::Debug;
+            case QtInfoMsg: return Logger::Info;
+            case QtWarningMsg: return Logger::Warning;
+            default: return Logger::Critical;
+        }
+    }
+
+    const char* levelName(QtMsgType type) {
+        switch (type) {
+            case QtDebugMsg: return "debug";
+            case QtInfoMsg: return "info";
+            case QtWarningMsg: return "warning";
+            case QtCriticalMsg: return "critical";
+            default: return "fatal";
+        }
+    }
+
+    // 2026-01-31T12:34:56.123456Z
+    void appendTimestamp(JsonWriter& w, std::int64_t micros) {
+        std::time_t seconds = static_cast<std::time_t>(micros / 1000000);
+        std::tm tm{};
+        gmtime_r(&seconds, &tm);
+        char buf[40];
+        std::size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+        std::snprintf(buf + n, sizeof(buf) - n, ".%06dZ", static_cast<int>(micros % 1000000));
+        w.value(std::string_view(buf));
+    }
+
+    void appendRecord(JsonWriter& w, const Record& r, std::uint32_t thread) {
+        w.beginObject();
+        w.key("ts");
+        appendTimestamp(w, r.micros);
+        w.key("level").value(levelName(r.type));
+        w.key("thread").value(thread);
+        w.key("category").value(r.category);
+        w.key("msg").value(r.message);
+        // Call site only with QT_MESSAGELOGCONTEXT (set by CMake)
+        if (r.file) {
+            w.key("file").value(r.file);
+            w.key("line").value(r.line);
+        }
+        if (r.function) w.key("function").value(r.function);
+        w.endObject();
+        w.raw("\n");
+    }
+
+    void fill(Record& r, QtMsgType type, const QMessageLogContext& context, const QString& message) {
+        r.type = type;
+        r.micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now().time_since_epoch()).count();
+        r.file = context.file;
+        r.function = context.function;
+        r.line = context.line;
+        r.category.assign(context.category ? context.category : "default");
+        const QByteArray utf8 = message.toUtf8();
+        r.message.assign(utf8.constData(), static_cast<std::size_t>(utf8.size()));
+    }
+
+    void writeOut(const std::string& lines) {
+        if (lines.empty()) return;
+        std::fwrite(lines.data(), 1, lines.size(), stderr);
+        std::fflush(stderr);
+    }
+
+    // Writer thread: moves everything that is queued into one buffer, one write per round
+    bool drain(JsonWriter& w) {
+        std::vector<std::shared_ptr<Ring>> current;
+        {
+            std::lock_guard lock(ringsMutex);
+            current = rings;
+        }
+
+        bool any = false;
+        for (const auto& ring : current) {
+            std::size_t tail = ring->tail.load(std::memory_order_relaxed);
+            const std::size_t head = ring->head.load(std::memory_order_acquire);
+            if (tail == head) continue;
+            any = true;
+            for (; tail != head; ++tail) appendRecord(w, ring->slots[tail & ring->mask], ring->thread);
+            ring->tail.store(tail, std::memory_order_release);
+        }
+        writeOut(w.take());
+
+        // Rings of finished threads are removed once empty
+        std::lock_guard lock(ringsMutex);
+        std::erase_if(rings, [](const std::shared_ptr<Ring>& ring) {
+            return ring->closed.load(std::memory_order_acquire) &&
+                   ring->tail.load(std::memory_order_relaxed) == ring->head.load(std::memory_order_acquire);
+        });
+        return any;
+    }
+
+    void writeSync(QtMsgType type, const QMessageLogContext& context, const QString& message) {
+        Record r;
+        fill(r, type, context, message);
+        JsonWriter w(512);
+        appendRecord(w, r, 0);
+        std::lock_guard lock(syncMutex);
+        writeOut(w.str());
+    }
+
+    void handler(QtMsgType type, const QMessageLogContext& context, const QString& message) {
+        if (type != QtFatalMsg && !Logger::enabled(levelOf(type))) return;
+
+        if (type == QtFatalMsg || !running.load(std::memory_order_acquire)) {
+            // qFatal aborts right after the handler: flush what is queued first
+            if (type == QtFatalMsg) Logger::stop();
+            writeSync(type, context, message);
+            return;
+        }
+
+        Ring& ring = localRing();
+        const std::size_t head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.tail.load(std::memory_order_acquire) > ring.mask) {
+            if (droppedCounter) droppedCounter->inc();
+            return;
+        }
+        fill(ring.slots[head & ring.mask], type, context, message);
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+}
+
+void Logger::start() {
+    if (running.exchange(true)) return;
+
+    const QString level = qEnvironmentVariable("LOG_LEVEL", "info").toLower();
+    if (level == "debug") minLevel = Debug;
+    else if (level == "warning") minLevel = Warning;
+    else if (level == "critical") minLevel = Critical;
+    else minLevel = Info;
+
+    droppedCounter = &Metrics::counter("log_messages_dropped_total",
+                                       "Log records dropped because the thread's ring buffer was full");
+
+    // No wakeups from the producers (that would need the mutex): the writer polls
+    writer = std::thread([] {
+        JsonWriter w(64 * 1024);
+        while (running.load(std::memory_order_acquire)) {
+            if (drain(w)) continue;
+            std::unique_lock lock(writerMutex);
+            writerWake.wait_for(lock, std::chrono::milliseconds(20));
+        }
+    });
+
+    qInstallMessageHandler(handler);
+    std::atexit(Logger::stop);
+}
+
+void Logger::stop() {
+    {
+        std::lock_guard lock(writerMutex);
+        if (!running.exchange(false)) return;
+    }
+    writerWake.notify_all();
+    if (writer.joinable() && writer.get_id() != std::this_thread::get_id()) writer.join();
+
+    // Whatever was queued until now; later records are written synchronously
+    JsonWriter w(64 * 1024);
+    drain(w);
+}
+
+std::uint64_t Logger::dropped() {
+    return droppedCounter ? droppedCounter->value() : 0;
+}
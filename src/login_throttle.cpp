@@ -0,0 +1,41 @@
+/**
+ * @file login_throttle.cpp
+ * @brief Implementation of the login token buckets.
+ */
+#include "login_throttle.hpp"
+#include "rate_limiter.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+    RateLimiter::Limit limitFromEnv(const char* burstVar, const char* rateVar, double burst, double perMinute) {
+        if (const char* env = std::getenv(burstVar)) burst = std::max(1.0, std::atof(env));
+        if (const char* env = std::getenv(rateVar)) perMinute = std::max(0.1, std::atof(env));
+        return RateLimiter::Limit{burst, perMinute / 60.0};
+    }
+
+    const RateLimiter::Limit& ipLimit() {
+        static const RateLimiter::Limit limit = limitFromEnv("LOGIN_IP_BURST", "LOGIN_IP_PER_MINUTE", 10, 10);
+        return limit;
+    }
+
+    const RateLimiter::Limit& userLimit() {
+        static const RateLimiter::Limit limit = limitFromEnv("LOGIN_USER_BURST", "LOGIN_USER_PER_MINUTE", 5, 5);
+        return limit;
+    }
+
+    RateLimiter& buckets() {
+        static RateLimiter instance(16384);
+        return instance;
+    }
+}
+
+bool LoginThrottle::allow(const std::string& ip, const std::string& username, int& retryAfterSeconds) {
+    retryAfterSeconds = buckets().consume("login-ip:" + ip, 1, ipLimit());
+    if (retryAfterSeconds == 0) {
+        retryAfterSeconds = buckets().consume("login-user:" + username, 1, userLimit());
+    }
+    return retryAfterSeconds == 0;
+}
@@ -10,19 +10,27 @@
 #include <format>
 #include <QFileInfo>
 #include <QDir> 
+#include <QTimer>
+#include <chrono>
 
-#include "crow.h"
-#include "crow/middlewares/cors.h"
+#include "crow_app.hpp"
 
 #include "dotenv.h"
 
 #include "db_manager.hpp"
-#include "auth_middleware.hpp"
+#include "replica_router.hpp"
+#include "reverse_geocoder.hpp"
+#include "deletion_queue.hpp"
+#include "static_assets.hpp"
+#include "template_registry.hpp"
+#include "logger.hpp"
 #include "controllers/auth_controller.hpp"
 #include "controllers/upload_controller.hpp"
 #include "controllers/gallery_controller.hpp"
 #include "controllers/web_controller.hpp" 
 #include "controllers/admin_controller.hpp"
+#include "controllers/media_controller.hpp"
+#include "controllers/metrics_controller.hpp"
 
 // Port optionally loaded from ENV
 int getPort() {
@@ -31,8 +39,8 @@ int getPort() {
 }
 
 void runCrowServer() {
-    // Define App with Middleware
-    crow::App<crow::CORSHandler, AuthMiddleware> app;
+    // Define App with Middleware (see crow_app.hpp)
+    CrowApp app;
 
     // CORS Setup
     auto& cors = app.get_middleware<crow::CORSHandler>();
@@ -47,6 +55,8 @@ void runCrowServer() {
     routes::setupGalleryRoutes(app);
     routes::setupWebRoutes(app);
     routes::setupAdminRoutes(app);
+    routes::setupMediaRoutes(app);
+    routes::setupMetricsRoutes(app);
 
     qInfo() << "Server starting on port" << getPort();
     app.port(getPort()).multithreaded().run();
@@ -92,10 +102,48 @@ int main(int argc, char *argv[]) {
     }
     // --------------------
 
+    // From here on: JSON log lines via a background thread (LOG_LEVEL, LOG_RING_SIZE)
+    Logger::start();
+
+    // Frontend files (+ gzip / zstd variants) in memory, served by / and /static
+    StaticAssets::load("static");
+    StaticAssets::watch("static");
+    TemplateRegistry::load("templates");
+    TemplateRegistry::watch("templates");
+
+    // Offline gazetteer for uploads without location metadata (GEONAMES_FILE)
+    ReverseGeocoder::load();
+
     // 1. Initialize Database (Create Tables)
     DbManager::initAuthDatabase();
+    DbManager::initGalleryDatabase();
+    DbManager::loadFacetIndex();
+    DbManager::loadKeywordIndex();
+    DbManager::loadGeoIndex();
+
+    // Files of deleted photos are moved to the trash in the background (TRASH_DIR)
+    DeletionQueue::start();
+
+    // 2. Refresh Token Sweeper (runs in the Qt event loop of the main thread)
+    QTimer tokenSweeper;
+    QObject::connect(&tokenSweeper, &QTimer::timeout, []() {
+        int removed = DbManager::purgeExpiredRefreshTokens();
+        if (removed > 0) qDebug() << "Token sweeper removed" << removed << "expired refresh tokens";
+    });
+    int sweepMinutes = qEnvironmentVariableIntValue("TOKEN_SWEEP_MINUTES");
+    tokenSweeper.start(std::chrono::minutes(sweepMinutes > 0 ? sweepMinutes : 10));
+    DbManager::purgeExpiredRefreshTokens();
+
+    // 3. Read Replica Health Checks (only if PG_REPLICA_HOSTS is set)
+    QTimer replicaMonitor;
+    if (!ReplicaRouter::replicas().empty()) {
+        QObject::connect(&replicaMonitor, &QTimer::timeout, []() { DbManager::checkReplicaHealth(); });
+        int checkSeconds = qEnvironmentVariableIntValue("PG_REPLICA_CHECK_SECONDS");
+        replicaMonitor.start(std::chrono::seconds(checkSeconds > 0 ? checkSeconds : 5));
+        DbManager::checkReplicaHealth();
+    }
 
-    // 2. Start Server in its own Thread
+    // 4. Start Server in its own Thread
     std::jthread serverThread(runCrowServer);
 
     return app.exec();
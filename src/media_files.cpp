@@ -0,0 +1,126 @@
+/**
+ * @file media_files.cpp
+ * @brief Implementation of the file descriptor cache for media files.
+ */
+#include "media_files.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <list>
+#include <mutex>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+    struct Slot {
+        std::string path;
+        std::shared_ptr<const MediaFiles::File> file;
+    };
+
+    std::mutex mutex;
+    std::list<Slot> lru; ///< Most recently used first.
+    std::unordered_map<std::string, std::list<Slot>::iterator> slots;
+
+    std::size_t capacity() {
+        static const std::size_t cap = [] {
+            const char* env = std::getenv("MEDIA_FD_CACHE");
+            int value = env ? std::atoi(env) : 0;
+            return static_cast<std::size_t>(value > 0 ? value : 256);
+        }();
+        return cap;
+    }
+
+    bool sameFile(const MediaFiles::File& f, const struct stat& st) {
+        return f.inode == static_cast<std::uint64_t>(st.st_ino) && f.size == static_cast<std::uint64_t>(st.st_size) &&
+               f.mtime.tv_sec == st.st_mtim.tv_sec && f.mtime.tv_nsec == st.st_mtim.tv_nsec;
+    }
+}
+
+MediaFiles::File::~File() {
+    if (fd >= 0) ::close(fd);
+}
+
+std::string MediaFiles::File::etag() const {
+    char buf[80];
+    std::snprintf(buf, sizeof(buf), "\"%llx-%llx-%llx%09lx\"", static_cast<unsigned long long>(inode),
+                  static_cast<unsigned long long>(size), static_cast<unsigned long long>(mtime.tv_sec),
+                  static_cast<unsigned long>(mtime.tv_nsec));
+    return buf;
+}
+
+bool MediaFiles::File::read(std::uint64_t offset, std::uint64_t length, std::string& out) const {
+    out.resize(length);
+    std::uint64_t done = 0;
+    while (done < length) {
+        ssize_t n = ::pread(fd, out.data() + done, length - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            out.resize(done);
+            return false;
+        }
+        done += static_cast<std::uint64_t>(n);
+    }
+    return true;
+}
+
+std::shared_ptr<const MediaFiles::File> MediaFiles::open(const std::string& path) {
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return nullptr;
+
+    {
+        std::lock_guard lock(mutex);
+        auto it = slots.find(path);
+        if (it != slots.end()) {
+            if (sameFile(*it->second->file, st)) {
+                lru.splice(lru.begin(), lru, it->second);
+                return it->second->file;
+            }
+            // Replaced or modified: drop the stale descriptor
+            lru.erase(it->second);
+            slots.erase(it);
+        }
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+
+    auto file = std::make_shared<File>();
+    file->fd = fd;
+    // fstat of the descriptor we actually read from (the path may have changed meanwhile)
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return nullptr;
+    file->size = static_cast<std::uint64_t>(st.st_size);
+    file->inode = static_cast<std::uint64_t>(st.st_ino);
+    file->mtime = st.st_mtim;
+
+    std::lock_guard lock(mutex);
+    if (auto it = slots.find(path); it != slots.end()) {
+        // Another request opened it concurrently: keep the newer one
+        lru.erase(it->second);
+        slots.erase(it);
+    }
+    lru.push_front(Slot{path, file});
+    slots.emplace(path, lru.begin());
+    while (lru.size() > capacity()) {
+        slots.erase(lru.back().path);
+        lru.pop_back();
+    }
+    return file;
+}
+
+const std::string& MediaFiles::root() {
+    static const std::string dir = [] {
+        const char* env = std::getenv("MEDIA_ROOT");
+        return std::string(env && *env ? env : "Photos");
+    }();
+    return dir;
+}
+
+std::size_t MediaFiles::cachedCount() {
+    std::lock_guard lock(mutex);
+    return lru.size();
+}
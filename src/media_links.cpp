@@ -0,0 +1,29 @@
+/**
+ * @file media_links.cpp
+ * @brief Implementation of the (signed) media URL builder.
+ */
+#include "media_links.hpp"
+#include "media_signer.hpp"
+#include "auth_middleware.hpp"
+
+QString MediaLinks::url(const QString& relDir, const QString& fileName) const {
+    QString url = "/media/";
+    if (!relDir.isEmpty()) url += relDir + "/";
+    url += fileName;
+    if (expires == 0) return url;
+
+    const QString relPath = relDir.isEmpty() ? fileName : relDir + "/" + fileName;
+    return url + '?' + QString::fromStdString(MediaSigner::query(relPath.toStdString(), user, expires));
+}
+
+MediaLinks MediaLinks::forUser(std::string user) {
+    if (!MediaSigner::enabled()) return MediaLinks{};
+    return MediaLinks{std::move(user), MediaSigner::expiry()};
+}
+
+std::optional<MediaLinks> MediaLinks::forRequest(const crow::request& req) {
+    if (!MediaSigner::enabled()) return MediaLinks{};
+    auto user = AuthMiddleware::userOf(req);
+    if (!user) return std::nullopt;
+    return forUser(std::move(*user));
+}
@@ -0,0 +1,125 @@
+/**
+ * @file media_signer.cpp
+ * @brief Implementation of the signed /media URLs.
+ */
+#include "media_signer.hpp"
+#include "utils.hpp" // For getJwtSecret
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+
+    constexpr std::size_t MAC_BYTES = 16; ///< Truncated HMAC-SHA256 (128 bit).
+
+    const std::string& signingKey() {
+        static const std::string key = [] {
+            const char* env = std::getenv("MEDIA_SIGNING_KEY");
+            if (env && *env) return std::string(env);
+
+            // Separate key from the JWT secret, a media signature is never a valid JWT MAC
+            const std::string& secret = utils::getJwtSecret();
+            static constexpr std::string_view label = "media-url-signing";
+            unsigned char md[EVP_MAX_MD_SIZE];
+            unsigned int len = 0;
+            HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()),
+                 reinterpret_cast<const unsigned char*>(label.data()), label.size(), md, &len);
+            return std::string(reinterpret_cast<const char*>(md), len);
+        }();
+        return key;
+    }
+
+    std::int64_t ttl() {
+        static const std::int64_t seconds = [] {
+            const char* env = std::getenv("MEDIA_URL_TTL");
+            long long value = env ? std::atoll(env) : 0;
+            return value > 0 ? static_cast<std::int64_t>(value) : std::int64_t{3600};
+        }();
+        return seconds;
+    }
+
+    std::int64_t now() {
+        return std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    std::string base64Url(const unsigned char* data, std::size_t size) {
+        static constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+        std::string out;
+        out.reserve((size * 4 + 2) / 3);
+        std::size_t i = 0;
+        for (; i + 2 < size; i += 3) {
+            const std::uint32_t n = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+            out += alphabet[(n >> 18) & 63];
+            out += alphabet[(n >> 12) & 63];
+            out += alphabet[(n >> 6) & 63];
+            out += alphabet[n & 63];
+        }
+        if (i < size) {
+            const std::uint32_t n = (data[i] << 16) | (i + 1 < size ? data[i + 1] << 8 : 0);
+            out += alphabet[(n >> 18) & 63];
+            out += alphabet[(n >> 12) & 63];
+            if (i + 1 < size) out += alphabet[(n >> 6) & 63];
+        }
+        return out; // no padding
+    }
+
+    // MAC over "path\nexpires\nuser" (a path cannot contain '\n' after validation)
+    std::string mac(std::string_view relPath, std::string_view user, std::int64_t expires) {
+        std::string message;
+        message.reserve(relPath.size() + user.size() + 24);
+        message.append(relPath).append(1, '\n').append(std::to_string(expires)).append(1, '\n').append(user);
+
+        const std::string& key = signingKey();
+        unsigned char md[EVP_MAX_MD_SIZE];
+        unsigned int len = 0;
+        HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+             reinterpret_cast<const unsigned char*>(message.data()), message.size(), md, &len);
+        return base64Url(md, MAC_BYTES);
+    }
+
+    std::string percentEncode(std::string_view value) {
+        static constexpr char hex[] = "0123456789ABCDEF";
+        std::string out;
+        for (unsigned char c : value) {
+            if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+                out += static_cast<char>(c);
+            } else {
+                out += '%';
+                out += hex[c >> 4];
+                out += hex[c & 15];
+            }
+        }
+        return out;
+    }
+}
+
+bool MediaSigner::enabled() {
+    static const bool on = [] {
+        const char* env = std::getenv("MEDIA_SIGNING");
+        return env && std::string(env) == "1";
+    }();
+    return on;
+}
+
+std::int64_t MediaSigner::expiry() {
+    const std::int64_t window = ttl();
+    return (now() / window + 2) * window;
+}
+
+std::string MediaSigner::query(std::string_view relPath, std::string_view user, std::int64_t expires) {
+    return "exp=" + std::to_string(expires) + "&u=" + percentEncode(user) + "&sig=" + mac(relPath, user, expires);
+}
+
+bool MediaSigner::verify(std::string_view relPath, std::string_view user, std::int64_t expires,
+                         std::string_view signature) {
+    if (expires < now()) return false;
+    const std::string expected = mac(relPath, user, expires);
+    return signature.size() == expected.size() &&
+           CRYPTO_memcmp(signature.data(), expected.data(), expected.size()) == 0;
+}
@@ -3,6 +3,7 @@
  * @brief Implementation of metadata extraction using Exiv2.
  */
 #include "metadata_extractor.hpp"
+#include "reverse_geocoder.hpp"
 #include <exiv2/exiv2.hpp>
 #include <QDebug>
 #include <iostream>
@@ -156,6 +157,16 @@ PhotoData MetadataExtractor::extract(const std::string& filepath) {
              if (data.copyright.isEmpty())   data.copyright = getXmp("Xmp.dc.rights");
         }
 
+        // --- 4. Reverse Geocoding (only if neither IPTC nor XMP name a location) ---
+        if (data.city.isEmpty() && data.province.isEmpty() && data.country.isEmpty() && data.countryCode.isEmpty()) {
+            if (auto place = ReverseGeocoder::lookup(data.gpsLat, data.gpsLon)) {
+                data.city = place->city;
+                data.province = place->province;
+                data.country = place->country;
+                data.countryCode = place->countryCode;
+            }
+        }
+
     } catch (Exiv2::Error& e) {
         qWarning() << "Exiv2 Error processing" << QString::fromStdString(filepath) << ":" << e.what();
     } catch (...) {
@@ -0,0 +1,199 @@
+/**
+ * @file metrics.cpp
+ * @brief Implementation of the sharded counters / histograms and the exposition format.
+ */
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+    // Each thread picks a slot once; threads beyond SHARDS share slots (still atomic)
+    std::size_t shardIndex() {
+        static std::atomic<std::size_t> next{0};
+        thread_local const std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % Metrics::SHARDS;
+        return index;
+    }
+
+    enum class Type { Counter, Histogram, Gauge };
+
+    struct Family {
+        std::string help;
+        Type type;
+        std::map<std::string, std::unique_ptr<Metrics::Counter>> counters;
+        std::map<std::string, std::unique_ptr<Metrics::Histogram>> histograms;
+        std::map<std::string, std::function<double()>> gauges;
+    };
+
+    std::mutex mutex;
+    std::map<std::string, Family> families; ///< Sorted by name -> stable output.
+
+    Family& family(const std::string& name, const std::string& help, Type type) {
+        auto [it, inserted] = families.try_emplace(name);
+        if (inserted) {
+            it->second.help = help;
+            it->second.type = type;
+        } else if (it->second.type != type) {
+            throw std::logic_error("Metric registered with two types: " + name);
+        }
+        return it->second;
+    }
+
+    void appendNumber(std::string& out, double value) {
+        if (std::isinf(value)) {
+            out += value > 0 ? "+Inf" : "-Inf";
+            return;
+        }
+        char buf[32];
+        int n = std::snprintf(buf, sizeof(buf), "%.9g", value);
+        out.append(buf, static_cast<std::size_t>(n));
+    }
+
+    // name{labels} value
+    void appendSample(std::string& out, const std::string& name, const std::string& labels, double value) {
+        out += name;
+        if (!labels.empty()) out.append(1, '{').append(labels).append(1, '}');
+        out += ' ';
+        appendNumber(out, value);
+        out += '\n';
+    }
+
+    std::string withLabel(const std::string& labels, const std::string& extra) {
+        return labels.empty() ? extra : labels + "," + extra;
+    }
+}
+
+// --- Counter ---
+
+void Metrics::Counter::inc(std::uint64_t n) {
+    slots_[shardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+}
+
+std::uint64_t Metrics::Counter::value() const {
+    std::uint64_t sum = 0;
+    for (const auto& slot : slots_) sum += slot.value.load(std::memory_order_relaxed);
+    return sum;
+}
+
+// --- Histogram ---
+
+Metrics::Histogram::Histogram(std::vector<double> bounds) : bounds_(std::move(bounds)) {
+    if (bounds_.size() > MAX_BUCKETS) bounds_.resize(MAX_BUCKETS);
+    std::sort(bounds_.begin(), bounds_.end());
+}
+
+void Metrics::Histogram::observe(double seconds) {
+    // Few buckets: a linear scan beats a binary search
+    std::size_t bucket = 0;
+    while (bucket < bounds_.size() && seconds > bounds_[bucket]) ++bucket;
+
+    Slot& slot = slots_[shardIndex()];
+    slot.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    slot.sumNanos.fetch_add(static_cast<std::uint64_t>(std::max(seconds, 0.0) * 1e9), std::memory_order_relaxed);
+}
+
+Metrics::Histogram::Snapshot Metrics::Histogram::snapshot() const {
+    Snapshot s;
+    s.bounds = bounds_;
+    s.cumulative.assign(bounds_.size() + 1, 0);
+
+    std::uint64_t sumNanos = 0;
+    for (const auto& slot : slots_) {
+        for (std::size_t i = 0; i < bounds_.size(); ++i) s.cumulative[i] += slot.buckets[i].load(std::memory_order_relaxed);
+        s.cumulative.back() += slot.buckets[bounds_.size()].load(std::memory_order_relaxed);
+        sumNanos += slot.sumNanos.load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 1; i < s.cumulative.size(); ++i) s.cumulative[i] += s.cumulative[i - 1];
+    s.sum = static_cast<double>(sumNanos) / 1e9;
+    return s;
+}
+
+// --- Registry ---
+
+const std::vector<double>& Metrics::latencyBuckets() {
+    static const std::vector<double> buckets = {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05,
+                                                0.1,    0.25,  0.5,    1.0,   2.5,  5.0,   10.0};
+    return buckets;
+}
+
+Metrics::Counter& Metrics::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard lock(mutex);
+    auto& slot = family(name, help, Type::Counter).counters[labels];
+    if (!slot) slot = std::make_unique<Counter>();
+    return *slot;
+}
+
+Metrics::Histogram& Metrics::histogram(const std::string& name, const std::string& help, const std::string& labels,
+                                       const std::vector<double>& bounds) {
+    std::lock_guard lock(mutex);
+    auto& slot = family(name, help, Type::Histogram).histograms[labels];
+    if (!slot) slot = std::make_unique<Histogram>(bounds);
+    return *slot;
+}
+
+void Metrics::gauge(const std::string& name, const std::string& help, std::function<double()> read,
+                    const std::string& labels) {
+    std::lock_guard lock(mutex);
+    family(name, help, Type::Gauge).gauges[labels] = std::move(read);
+}
+
+std::string Metrics::labels(std::initializer_list<std::pair<std::string_view, std::string_view>> pairs) {
+    std::string out;
+    for (const auto& [key, value] : pairs) {
+        if (!out.empty()) out += ',';
+        out.append(key).append("=\"");
+        for (char c : value) {
+            if (c == '\\') out += "\\\\";
+            else if (c == '"') out += "\\\"";
+            else if (c == '\n') out += "\\n";
+            else out += c;
+        }
+        out += '"';
+    }
+    return out;
+}
+
+std::string Metrics::render() {
+    std::string out;
+    out.reserve(16 * 1024);
+
+    std::lock_guard lock(mutex);
+    for (const auto& [name, f] : families) {
+        out.append("# HELP ").append(name).append(1, ' ').append(f.help).append(1, '\n');
+        switch (f.type) {
+            case Type::Counter:
+                out.append("# TYPE ").append(name).append(" counter\n");
+                for (const auto& [labels, c] : f.counters) appendSample(out, name, labels, static_cast<double>(c->value()));
+                break;
+
+            case Type::Gauge:
+                out.append("# TYPE ").append(name).append(" gauge\n");
+                for (const auto& [labels, read] : f.gauges) appendSample(out, name, labels, read());
+                break;
+
+            case Type::Histogram:
+                out.append("# TYPE ").append(name).append(" histogram\n");
+                for (const auto& [labels, h] : f.histograms) {
+                    const Histogram::Snapshot s = h->snapshot();
+                    for (std::size_t i = 0; i < s.bounds.size(); ++i) {
+                        std::string le = "le=\"";
+                        appendNumber(le, s.bounds[i]);
+                        le += '"';
+                        appendSample(out, name + "_bucket", withLabel(labels, le), static_cast<double>(s.cumulative[i]));
+                    }
+                    appendSample(out, name + "_bucket", withLabel(labels, "le=\"+Inf\""),
+                                 static_cast<double>(s.cumulative.back()));
+                    appendSample(out, name + "_sum", labels, s.sum);
+                    appendSample(out, name + "_count", labels, static_cast<double>(s.cumulative.back()));
+                }
+                break;
+        }
+    }
+    return out;
+}
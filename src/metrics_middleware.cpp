@@ -0,0 +1,153 @@
+/**
+ * @file metrics_middleware.cpp
+ * @brief Implementation of the Metrics Middleware.
+ */
+#include "metrics_middleware.hpp"
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    struct RouteMetrics {
+        Metrics::Histogram* duration = nullptr;
+        std::unordered_map<int, Metrics::Counter*> byCode;
+    };
+
+    // Registry lookups take a mutex: every thread keeps its own map of the
+    // metrics it already used, so the steady state is lock-free
+    RouteMetrics& routeMetrics(const std::string& route, const std::string& method) {
+        thread_local std::unordered_map<std::string, RouteMetrics> cache;
+        std::string key = route;
+        key.append(1, ' ').append(method);
+
+        auto [it, inserted] = cache.try_emplace(std::move(key));
+        if (inserted) {
+            it->second.duration = &Metrics::histogram("http_request_duration_seconds",
+                                                      "Time from request parsed to response completed",
+                                                      Metrics::labels({{"route", route}, {"method", method}}));
+        }
+        return it->second;
+    }
+
+    Metrics::Counter& requestCounter(RouteMetrics& m, const std::string& route, const std::string& method, int code) {
+        auto [it, inserted] = m.byCode.try_emplace(code, nullptr);
+        if (inserted) {
+            const std::string status = std::to_string(code);
+            it->second = &Metrics::counter("http_requests_total", "Requests by route, method and status",
+                                           Metrics::labels({{"route", route}, {"method", method}, {"code", status}}));
+        }
+        return *it->second;
+    }
+
+    bool isNumber(std::string_view segment) {
+        if (segment.starts_with('-')) segment.remove_prefix(1);
+        return !segment.empty() &&
+               std::all_of(segment.begin(), segment.end(), [](unsigned char c) { return std::isdigit(c); });
+    }
+
+    // Templates of all CROW_ROUTE registrations (Crow does not tell middlewares
+    // which rule matched). Keep in sync with the controllers: a path that matches
+    // none of them is counted as "unmatched", whatever its status (e.g. a 429 of
+    // the rate limiter before routing), so random URLs create no new series.
+    constexpr std::string_view ROUTE_TEMPLATES[] = {
+        "/",
+        "/login",
+        "/logout",
+        "/refresh",
+        "/upload",
+        "/template",
+        "/metrics",
+        "/system/json",
+        "/system/stats",
+        "/static/<path>",
+        "/media/<path>",
+        "/api/auth/me",
+        "/api/user/change-password",
+        "/api/gallery",
+        "/api/gallery/facets",
+        "/api/gallery/batch/update",
+        "/api/gallery/batch/delete",
+        "/api/gallery/<int>",
+        "/api/timeline",
+        "/api/search",
+        "/api/map",
+        "/api/keywords/suggest",
+        "/api/admin/users",
+        "/api/admin/users/<int>",
+        "/api/admin/users/<int>/status",
+        "/api/admin/users/<int>/reset-password",
+        "/api/admin/trash",
+        "/api/admin/trash/restore",
+    };
+
+    std::vector<std::string_view> segments(std::string_view path) {
+        std::vector<std::string_view> out;
+        std::size_t pos = 0;
+        while (pos < path.size()) {
+            if (path[pos] != '/') return {}; // not a path
+            std::size_t slash = path.find('/', pos + 1);
+            std::size_t end = slash == std::string_view::npos ? path.size() : slash;
+            out.push_back(path.substr(pos + 1, end - pos - 1));
+            pos = end;
+        }
+        return out;
+    }
+
+    // "<int>" -> ":id", "<path>" -> ":path", "<string>" -> ":name"
+    bool matches(std::string_view routeTemplate, const std::vector<std::string_view>& path, std::string& label) {
+        const std::vector<std::string_view> parts = segments(routeTemplate);
+        if (routeTemplate == "/") {
+            label = "/";
+            return path.empty() || (path.size() == 1 && path[0].empty());
+        }
+
+        label.clear();
+        for (std::size_t i = 0; i < parts.size(); ++i) {
+            const std::string_view part = parts[i];
+            label += '/';
+            if (part == "<path>") {
+                // Rest of the URL, at least one character
+                if (i >= path.size() || (i + 1 == path.size() && path[i].empty())) return false;
+                label += ":path";
+                return true;
+            }
+            if (i >= path.size()) return false;
+            if (part == "<int>" || part == "<uint>") {
+                if (!isNumber(path[i])) return false;
+                label += ":id";
+            } else if (part == "<string>") {
+                if (path[i].empty()) return false;
+                label += ":name";
+            } else if (part != path[i]) {
+                return false;
+            } else {
+                label += part;
+            }
+        }
+        return parts.size() == path.size();
+    }
+}
+
+std::string MetricsMiddleware::routeLabel(std::string_view path) {
+    const std::vector<std::string_view> parts = segments(path);
+    std::string label;
+    for (std::string_view routeTemplate : ROUTE_TEMPLATES) {
+        if (matches(routeTemplate, parts, label)) return label;
+    }
+    return "unmatched";
+}
+
+void MetricsMiddleware::after_handle(crow::request& req, crow::response& res, context& ctx) {
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - ctx.start).count();
+    const std::string route = routeLabel(req.url);
+    const std::string method = crow::method_name(req.method);
+
+    RouteMetrics& m = routeMetrics(route, method);
+    m.duration->observe(seconds);
+    requestCounter(m, route, method, res.code).inc();
+}
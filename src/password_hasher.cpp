@@ -0,0 +1,70 @@
+/**
+ * @file password_hasher.cpp
+ * @brief Implementation of the bcrypt thread pool.
+ */
+#include "password_hasher.hpp"
+#include "bcrypt/BCrypt.hpp"
+
+#include <QThreadPool>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+#include <QDebug>
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+    std::atomic<int> inFlight{0};
+
+    int queueLimit() {
+        // Default: at most half of the Crow workers may wait for bcrypt
+        static const int limit = [] {
+            int env = qEnvironmentVariableIntValue("BCRYPT_QUEUE_LIMIT");
+            return env > 0 ? env : std::max(1, QThread::idealThreadCount() / 2);
+        }();
+        return limit;
+    }
+
+    QThreadPool* pool() {
+        static QThreadPool* instance = [] {
+            auto* p = new QThreadPool();
+            int env = qEnvironmentVariableIntValue("BCRYPT_THREADS");
+            p->setMaxThreadCount(env > 0 ? env : std::max(1, queueLimit() / 2));
+            qInfo() << "bcrypt pool:" << p->maxThreadCount() << "threads, queue limit" << queueLimit();
+            return p;
+        }();
+        return instance;
+    }
+
+    // Reserves a slot in the queue (released on scope exit)
+    struct Slot {
+        Slot() {
+            if (inFlight.fetch_add(1, std::memory_order_acq_rel) >= queueLimit()) {
+                inFlight.fetch_sub(1, std::memory_order_acq_rel);
+                throw PasswordHasher::Overloaded("bcrypt queue limit reached");
+            }
+        }
+        ~Slot() { inFlight.fetch_sub(1, std::memory_order_acq_rel); }
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+    };
+}
+
+std::string PasswordHasher::hash(const std::string& password) {
+    Slot slot;
+    return QtConcurrent::run(pool(), [&password]() {
+        return BCrypt::generateHash(password);
+    }).result();
+}
+
+bool PasswordHasher::verify(const std::string& password, const std::string& hash) {
+    Slot slot;
+    return QtConcurrent::run(pool(), [&password, &hash]() {
+        return BCrypt::validatePassword(password, hash);
+    }).result();
+}
+
+int PasswordHasher::queueDepth() {
+    return inFlight.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file rate_limit_middleware.cpp
+ * @brief Implementation of the Rate Limiting Middleware.
+ */
+#include "rate_limit_middleware.hpp"
+#include "rate_limiter.hpp"
+#include "utils.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+
+    struct Config {
+        bool enabled = true;
+        RateLimiter::Limit ip{120, 20};
+        RateLimiter::Limit user{240, 40};
+        std::size_t slots = 65536;
+    };
+
+    double envDouble(const char* name, double fallback) {
+        const char* env = std::getenv(name);
+        double value = env ? std::atof(env) : 0.0;
+        return value > 0 ? value : fallback;
+    }
+
+    const Config& config() {
+        static const Config cfg = [] {
+            Config c;
+            if (const char* env = std::getenv("RATE_LIMIT_ENABLED")) c.enabled = std::string_view(env) != "0";
+            c.ip = {envDouble("RATE_LIMIT_IP_BURST", c.ip.burst), envDouble("RATE_LIMIT_IP_PER_SECOND", c.ip.perSecond)};
+            c.user = {envDouble("RATE_LIMIT_USER_BURST", c.user.burst), envDouble("RATE_LIMIT_USER_PER_SECOND", c.user.perSecond)};
+            c.slots = static_cast<std::size_t>(envDouble("RATE_LIMIT_SLOTS", static_cast<double>(c.slots)));
+            return c;
+        }();
+        return cfg;
+    }
+
+    RateLimiter& limiter() {
+        static RateLimiter instance(config().slots);
+        return instance;
+    }
+
+    std::atomic<std::uint64_t> rejected{0};
+
+    // Token cost per route. 0 = not limited (static assets etc.)
+    double routeCost(crow::HTTPMethod method, std::string_view path) {
+        if (path.starts_with("/upload")) return 10;
+        if (path.starts_with("/api/admin")) return 3;
+        if (path.starts_with("/api/gallery") && method != crow::HTTPMethod::GET) return 2;
+        if (path.starts_with("/api/")) return 1;
+        if (path == "/login" || path == "/refresh" || path == "/logout") return 1;
+        return 0;
+    }
+
+    void reject(crow::response& res, int retryAfter) {
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        res.code = 429;
+        res.set_header("Content-Type", "application/json");
+        res.set_header("Retry-After", std::to_string(retryAfter));
+        res.end(R"({"error": "Too many requests"})");
+    }
+}
+
+std::uint64_t RateLimitMiddleware::rejectedCount() {
+    return rejected.load(std::memory_order_relaxed);
+}
+
+void RateLimitMiddleware::before_handle(crow::request& req, crow::response& res, context& /*ctx*/) {
+    if (!config().enabled || req.method == crow::HTTPMethod::OPTIONS) return;
+
+    double cost = routeCost(req.method, req.url);
+    if (cost <= 0) return;
+
+    int retryAfter = limiter().consume("ip:" + utils::clientIp(req), cost, config().ip);
+    if (retryAfter > 0) reject(res, retryAfter);
+}
+
+bool RateLimitMiddleware::chargeUser(const crow::request& req, crow::response& res, const std::string& user) {
+    if (!config().enabled || user.empty()) return true;
+
+    double cost = routeCost(req.method, req.url);
+    if (cost <= 0) return true;
+
+    int retryAfter = limiter().consume("user:" + user, cost, config().user);
+    if (retryAfter == 0) return true;
+    reject(res, retryAfter);
+    return false;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file rate_limiter.cpp
+ * @brief Implementation of the lock-free token bucket table.
+ */
+#include "rate_limiter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <string>
+
+namespace {
+
+    // State layout: upper 32 bits = time of last update (centiseconds), lower 32 bits = milli-tokens
+    constexpr std::uint64_t pack(std::uint32_t time, std::uint32_t milliTokens) {
+        return (static_cast<std::uint64_t>(time) << 32) | milliTokens;
+    }
+    constexpr std::uint32_t timeOf(std::uint64_t state) { return static_cast<std::uint32_t>(state >> 32); }
+    constexpr std::uint32_t tokensOf(std::uint64_t state) { return static_cast<std::uint32_t>(state); }
+
+    // Centiseconds since process start (wraps after ~497 days; differences stay valid)
+    std::uint32_t nowTicks() {
+        static const auto start = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() / 10);
+    }
+
+    std::uint32_t toMilli(double tokens) {
+        return static_cast<std::uint32_t>(std::clamp(tokens * 1000.0, 0.0, 4.0e9));
+    }
+}
+
+RateLimiter::RateLimiter(std::size_t slotCount)
+    : setCount(std::max<std::size_t>(1, (slotCount + WAYS - 1) / WAYS)),
+      slots(std::make_unique<Slot[]>(setCount * WAYS)) {}
+
+int RateLimiter::consume(std::string_view key, double cost, const Limit& limit) {
+    std::uint64_t hash = std::hash<std::string_view>{}(key);
+    std::uint64_t tag = hash | 1; // 0 marks an empty slot
+    Slot* set = &slots[(hash >> 8) % setCount * WAYS];
+
+    const std::uint32_t now = nowTicks();
+    const std::uint32_t milliCost = std::min(toMilli(cost), toMilli(limit.burst));
+
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        // 1. Existing bucket
+        for (std::size_t w = 0; w < WAYS; ++w) {
+            if (set[w].key.load(std::memory_order_acquire) == tag) {
+                return consumeSlot(set[w], now, milliCost, limit);
+            }
+        }
+
+        // 2. Take an empty way, otherwise the one idle the longest
+        Slot* victim = &set[0];
+        std::uint32_t longestIdle = 0;
+        for (std::size_t w = 0; w < WAYS; ++w) {
+            if (set[w].key.load(std::memory_order_relaxed) == 0) {
+                victim = &set[w];
+                break;
+            }
+            std::uint32_t idle = now - timeOf(set[w].state.load(std::memory_order_relaxed));
+            if (idle >= longestIdle) {
+                longestIdle = idle;
+                victim = &set[w];
+            }
+        }
+
+        std::uint64_t expected = victim->key.load(std::memory_order_relaxed);
+        if (expected == tag) continue; // someone else just inserted our key
+        if (victim->key.compare_exchange_strong(expected, tag, std::memory_order_acq_rel)) {
+            victim->state.store(pack(now, toMilli(limit.burst)), std::memory_order_release);
+            return consumeSlot(*victim, now, milliCost, limit);
+        }
+        // Lost the race for this way -> look again
+    }
+    return 0; // Heavy contention on one set: fail open
+}
+
+int RateLimiter::consumeSlot(Slot& slot, std::uint32_t now, std::uint32_t cost, const Limit& limit) {
+    const double milliPerTick = limit.perSecond * 1000.0 / 100.0;
+    const std::uint32_t capacity = toMilli(limit.burst);
+
+    std::uint64_t old = slot.state.load(std::memory_order_acquire);
+    for (;;) {
+        std::uint32_t elapsed = now - timeOf(old);
+        if (elapsed > 0x80000000u) elapsed = 0; // 'now' taken before a concurrent update
+        double refilled = std::min<double>(capacity, tokensOf(old) + elapsed * milliPerTick);
+
+        if (refilled < cost) {
+            double missing = (cost - refilled) / (limit.perSecond * 1000.0);
+            return std::max(1, static_cast<int>(std::ceil(missing)));
+        }
+
+        std::uint64_t next = pack(elapsed ? now : timeOf(old), static_cast<std::uint32_t>(refilled) - cost);
+        if (slot.state.compare_exchange_weak(old, next, std::memory_order_acq_rel)) return 0;
+    }
+}
@@ -0,0 +1,117 @@
+/**
+ * @file replica_router.cpp
+ * @brief Implementation of the read replica routing state.
+ */
+#include "replica_router.hpp"
+
+#include <QDateTime>
+#include <QHash>
+#include <QStringList>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace {
+
+    std::mutex mutex;
+    std::vector<ReplicaRouter::Replica> replicaList;
+    bool configured = false;
+    std::atomic<unsigned> roundRobin{0};
+
+    QHash<QString, qint64> writtenUntil; ///< Folder -> end of primary-only window (ms since epoch).
+
+    double maxLag() {
+        static const double value = [] {
+            bool ok = false;
+            double v = qEnvironmentVariable("PG_REPLICA_MAX_LAG").toDouble(&ok);
+            return ok && v > 0 ? v : 5.0;
+        }();
+        return value;
+    }
+
+    qint64 readAfterWriteMs() {
+        static const qint64 value = [] {
+            int v = qEnvironmentVariableIntValue("PG_READ_AFTER_WRITE_MS");
+            return v > 0 ? static_cast<qint64>(v) : 5000;
+        }();
+        return value;
+    }
+
+    // Parses PG_REPLICA_HOSTS once (caller holds the mutex)
+    void ensureConfigured() {
+        if (configured) return;
+        configured = true;
+
+        int defaultPort = qEnvironmentVariable("PG_PORT", "5432").toInt();
+        const QStringList hosts = qEnvironmentVariable("PG_REPLICA_HOSTS").split(',', Qt::SkipEmptyParts);
+        for (const QString& entry : hosts) {
+            ReplicaRouter::Replica r;
+            QStringList parts = entry.trimmed().split(':');
+            r.host = parts.value(0);
+            r.port = parts.size() > 1 ? parts.value(1).toInt() : defaultPort;
+            if (!r.host.isEmpty()) replicaList.push_back(r);
+        }
+    }
+}
+
+std::vector<ReplicaRouter::Replica> ReplicaRouter::replicas() {
+    std::lock_guard lock(mutex);
+    ensureConfigured();
+    return replicaList;
+}
+
+int ReplicaRouter::pick() {
+    std::lock_guard lock(mutex);
+    ensureConfigured();
+    if (replicaList.empty()) return -1;
+
+    const int count = static_cast<int>(replicaList.size());
+    const int start = static_cast<int>(roundRobin.fetch_add(1, std::memory_order_relaxed) % count);
+    for (int i = 0; i < count; ++i) {
+        int index = (start + i) % count;
+        if (replicaList[index].healthy) return index;
+    }
+    return -1;
+}
+
+void ReplicaRouter::reportHealth(int index, bool reachable, double lagSeconds) {
+    std::lock_guard lock(mutex);
+    ensureConfigured();
+    if (index < 0 || index >= static_cast<int>(replicaList.size())) return;
+    replicaList[index].lagSeconds = lagSeconds;
+    replicaList[index].healthy = reachable && lagSeconds <= maxLag();
+}
+
+void ReplicaRouter::markWrite(const QString& path) {
+    std::lock_guard lock(mutex);
+    ensureConfigured();
+    if (replicaList.empty()) return; // Everything goes to the primary anyway
+
+    double lag = 0.0;
+    for (const auto& r : replicaList) lag = std::max(lag, r.lagSeconds);
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qint64 until = now + readAfterWriteMs() + static_cast<qint64>(lag * 1000.0);
+
+    // Drop expired marks from time to time
+    if (writtenUntil.size() > 10000) {
+        writtenUntil.removeIf([now](QHash<QString, qint64>::iterator it) { return it.value() < now; });
+    }
+
+    // Folder itself + all parents ("a/b/c" -> "a/b/c", "a/b", "a", "")
+    QString folder = path;
+    for (;;) {
+        writtenUntil.insert(folder, until);
+        if (folder.isEmpty()) break;
+        qsizetype slash = folder.lastIndexOf('/');
+        folder = slash < 0 ? QString() : folder.left(slash);
+    }
+}
+
+bool ReplicaRouter::recentlyWritten(const QString& path) {
+    std::lock_guard lock(mutex);
+    auto it = writtenUntil.constFind(path);
+    return it != writtenUntil.constEnd() && it.value() >= QDateTime::currentMSecsSinceEpoch();
+}
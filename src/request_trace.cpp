@@ -0,0 +1,209 @@
+/**
+ * @file request_trace.cpp
+ * @brief Implementation of the per-request stage timings and OTLP/JSON export.
+ */
+#include "request_trace.hpp"
+#include "json_writer.hpp"
+#include "rz_config.hpp"
+
+#include <QDebug>
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string_view>
+#include <thread>
+
+namespace {
+
+    bool serverTimingEnabled() {
+        static const bool on = [] {
+            const char* env = std::getenv("SERVER_TIMING");
+            return !env || std::string_view(env) != "0";
+        }();
+        return on;
+    }
+
+    // Background writer: request threads only append to 'queue'
+    std::mutex queueMutex;
+    std::condition_variable queueWake;
+    std::vector<std::string> queue;
+    bool stopping = false;
+    std::thread writer;
+
+    void writeLines(std::FILE* file) {
+        std::vector<std::string> batch;
+        for (;;) {
+            {
+                std::unique_lock lock(queueMutex);
+                queueWake.wait(lock, [] { return stopping || !queue.empty(); });
+                if (queue.empty()) return; // stopping, everything written
+                batch.swap(queue);
+            }
+            for (const std::string& line : batch) std::fwrite(line.data(), 1, line.size(), file);
+            std::fflush(file);
+            batch.clear();
+        }
+    }
+
+    void stopWriter() {
+        {
+            std::lock_guard lock(queueMutex);
+            stopping = true;
+        }
+        queueWake.notify_one();
+        if (writer.joinable()) writer.join();
+    }
+
+    // TRACE_FILE: one OTLP/JSON line per request (append); starts the writer thread
+    bool traceEnabled() {
+        static const bool enabled = [] {
+            const char* path = std::getenv("TRACE_FILE");
+            if (!path || !*path) return false;
+            std::FILE* f = std::fopen(path, "a");
+            if (!f) {
+                qWarning() << "Cannot open TRACE_FILE" << path;
+                return false;
+            }
+            writer = std::thread(writeLines, f);
+            std::atexit(stopWriter);
+            return true;
+        }();
+        return enabled;
+    }
+
+    void enqueue(std::string line) {
+        static const std::size_t limit = [] {
+            const int value = qEnvironmentVariableIntValue("TRACE_QUEUE_MAX");
+            return static_cast<std::size_t>(value > 0 ? value : 4096);
+        }();
+        static auto& dropped = Metrics::counter("trace_lines_dropped_total", "OTLP lines dropped because the TRACE_FILE writer fell behind");
+        {
+            std::lock_guard lock(queueMutex);
+            if (queue.size() >= limit) {
+                dropped.inc();
+                return;
+            }
+            queue.push_back(std::move(line));
+        }
+        queueWake.notify_one();
+    }
+
+    std::string randomHex(std::size_t bytes) {
+        thread_local std::mt19937_64 rng(std::random_device{}());
+        static constexpr char hex[] = "0123456789abcdef";
+        std::string out;
+        out.reserve(bytes * 2);
+        while (out.size() < bytes * 2) {
+            std::uint64_t r = rng();
+            for (int i = 0; i < 16 && out.size() < bytes * 2; ++i, r >>= 4) out += hex[r & 15];
+        }
+        return out;
+    }
+
+    std::string unixNanos(std::chrono::system_clock::time_point t) {
+        return std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count());
+    }
+
+    double millis(std::chrono::steady_clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    void writeSpan(JsonWriter& w, const std::string& traceId, const std::string& spanId, const std::string& parentId,
+                   std::string_view name, std::chrono::system_clock::time_point start,
+                   std::chrono::steady_clock::duration duration) {
+        w.beginObject();
+        w.key("traceId").value(traceId);
+        w.key("spanId").value(spanId);
+        if (!parentId.empty()) w.key("parentSpanId").value(parentId);
+        w.key("name").value(name);
+        w.key("kind").value(parentId.empty() ? 2 : 1); // SERVER / INTERNAL
+        w.key("startTimeUnixNano").value(unixNanos(start));
+        w.key("endTimeUnixNano").value(unixNanos(start + std::chrono::duration_cast<std::chrono::system_clock::duration>(duration)));
+        w.endObject();
+    }
+}
+
+// --- Stage ---
+
+RequestTrace::Stage::Stage(RequestTrace& trace, const char* name, Metrics::Histogram* histogram)
+    : trace_(&trace), name_(name), histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+void RequestTrace::Stage::end() {
+    if (!trace_) return;
+    const auto now = std::chrono::steady_clock::now();
+    if (histogram_) histogram_->observe(std::chrono::duration<double>(now - start_).count());
+    trace_->add(name_, start_, now);
+    trace_ = nullptr;
+}
+
+// --- RequestTrace ---
+
+RequestTrace::RequestTrace(std::string name)
+    : name_(std::move(name)), start_(std::chrono::steady_clock::now()), wallStart_(std::chrono::system_clock::now()) {
+    spans_.reserve(8);
+}
+
+std::shared_ptr<RequestTrace> RequestTrace::start(std::string name) {
+    return std::shared_ptr<RequestTrace>(new RequestTrace(std::move(name)));
+}
+
+void RequestTrace::add(const char* name, std::chrono::steady_clock::time_point start,
+                       std::chrono::steady_clock::time_point end) {
+    std::lock_guard lock(mutex_);
+    if (!finished_) spans_.push_back({name, start, end});
+}
+
+void RequestTrace::finish(crow::response& res) {
+    const auto end = std::chrono::steady_clock::now();
+    std::vector<Span> spans;
+    {
+        std::lock_guard lock(mutex_);
+        if (finished_) return;
+        finished_ = true;
+        spans.swap(spans_);
+    }
+
+    if (serverTimingEnabled()) {
+        std::string header;
+        char buf[64];
+        for (const Span& s : spans) {
+            std::snprintf(buf, sizeof(buf), "%s;dur=%.3f, ", s.name, millis(s.end - s.start));
+            header += buf;
+        }
+        std::snprintf(buf, sizeof(buf), "total;dur=%.3f", millis(end - start_));
+        header += buf;
+        res.set_header("Server-Timing", header);
+    }
+
+    if (!traceEnabled()) return;
+
+    const std::string traceId = randomHex(16);
+    const std::string rootId = randomHex(8);
+
+    JsonWriter w(1024 + spans.size() * 256);
+    w.beginObject().key("resourceSpans").beginArray().beginObject();
+    w.key("resource").beginObject().key("attributes").beginArray();
+    w.beginObject().key("key").value("service.name");
+    w.key("value").beginObject().key("stringValue").value(PROJECT_NAME).endObject();
+    w.endObject();
+    w.endArray().endObject();
+
+    w.key("scopeSpans").beginArray().beginObject();
+    w.key("scope").beginObject().key("name").value("request_trace").endObject();
+    w.key("spans").beginArray();
+    // Steady offsets from the trace start, placed on the wall clock read once in the constructor
+    auto wall = [this](std::chrono::steady_clock::time_point t) {
+        return wallStart_ + std::chrono::duration_cast<std::chrono::system_clock::duration>(t - start_);
+    };
+    writeSpan(w, traceId, rootId, {}, name_, wallStart_, end - start_);
+    for (const Span& s : spans) writeSpan(w, traceId, randomHex(8), rootId, s.name, wall(s.start), s.end - s.start);
+    w.endArray();
+    w.endObject().endArray();
+
+    w.endObject().endArray().endObject();
+    std::string line = w.take();
+    line += '\n';
+    enqueue(std::move(line));
+}
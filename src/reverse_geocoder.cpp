@@ -0,0 +1,169 @@
+/**
+ * @file reverse_geocoder.cpp
+ * @brief Implementation of the k-d tree reverse geocoder.
+ */
+#include "reverse_geocoder.hpp"
+
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+namespace {
+
+    constexpr double EARTH_RADIUS_KM = 6371.0;
+
+    struct PlaceEntry {
+        std::array<double, 3> pos; ///< Unit vector.
+        QString name;
+        QString countryCode;
+        QString admin1Code;
+    };
+
+    // k-d tree stored implicitly: the median of every range is its root
+    std::vector<PlaceEntry> tree;
+    QHash<QString, QString> countryNames; ///< "DE" -> "Germany"
+    QHash<QString, QString> admin1Names; ///< "DE.02" -> "Bavaria"
+    double maxChordSquared = 0.0;
+
+    std::array<double, 3> toUnitVector(double lat, double lon) {
+        const double phi = lat * std::numbers::pi / 180.0;
+        const double lambda = lon * std::numbers::pi / 180.0;
+        return {std::cos(phi) * std::cos(lambda), std::cos(phi) * std::sin(lambda), std::sin(phi)};
+    }
+
+    double distanceSquared(const std::array<double, 3>& a, const std::array<double, 3>& b) {
+        const double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    void build(std::size_t begin, std::size_t end, int depth) {
+        if (end - begin <= 1) return;
+        const int axis = depth % 3;
+        const std::size_t mid = begin + (end - begin) / 2;
+        std::nth_element(tree.begin() + begin, tree.begin() + mid, tree.begin() + end,
+                         [axis](const PlaceEntry& a, const PlaceEntry& b) { return a.pos[axis] < b.pos[axis]; });
+        build(begin, mid, depth + 1);
+        build(mid + 1, end, depth + 1);
+    }
+
+    void nearest(std::size_t begin, std::size_t end, int depth, const std::array<double, 3>& target,
+                 std::size_t& best, double& bestDist) {
+        if (begin >= end) return;
+        const int axis = depth % 3;
+        const std::size_t mid = begin + (end - begin) / 2;
+
+        const double d = distanceSquared(tree[mid].pos, target);
+        if (d < bestDist) {
+            bestDist = d;
+            best = mid;
+        }
+
+        const double delta = target[axis] - tree[mid].pos[axis];
+        if (delta < 0) {
+            nearest(begin, mid, depth + 1, target, best, bestDist);
+            if (delta * delta < bestDist) nearest(mid + 1, end, depth + 1, target, best, bestDist);
+        } else {
+            nearest(mid + 1, end, depth + 1, target, best, bestDist);
+            if (delta * delta < bestDist) nearest(begin, mid, depth + 1, target, best, bestDist);
+        }
+    }
+
+    // Reads a tab separated GeoNames file line by line (lines starting with '#' are comments)
+    template <typename Fn>
+    bool readTsv(const QString& path, Fn onRow) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "Gazetteer file not readable:" << path;
+            return false;
+        }
+        while (!file.atEnd()) {
+            QByteArray line = file.readLine();
+            if (line.isEmpty() || line.startsWith('#')) continue;
+            if (line.endsWith('\n')) line.chop(1);
+            if (line.endsWith('\r')) line.chop(1);
+            onRow(line.split('\t'));
+        }
+        return true;
+    }
+}
+
+void ReverseGeocoder::load() {
+    const QString citiesFile = qEnvironmentVariable("GEONAMES_FILE");
+    if (citiesFile.isEmpty()) return;
+
+    double maxKm = qEnvironmentVariable("GEOCODER_MAX_KM", "30").toDouble();
+    if (maxKm <= 0) maxKm = 30.0;
+    // Chord length of the great circle distance on the unit sphere
+    const double chord = 2.0 * std::sin(std::min(maxKm / EARTH_RADIUS_KM, std::numbers::pi) / 2.0);
+    maxChordSquared = chord * chord;
+
+    // cities*.txt: 1 name, 4 latitude, 5 longitude, 8 country code, 10 admin1 code
+    std::vector<PlaceEntry> places;
+    readTsv(citiesFile, [&places](const QList<QByteArray>& f) {
+        if (f.size() < 11) return;
+        bool okLat = false, okLon = false;
+        const double lat = f[4].toDouble(&okLat);
+        const double lon = f[5].toDouble(&okLon);
+        if (!okLat || !okLon) return;
+        places.push_back(PlaceEntry{toUnitVector(lat, lon), QString::fromUtf8(f[1]),
+                                    QString::fromUtf8(f[8]), QString::fromUtf8(f[10])});
+    });
+
+    // countryInfo.txt: 0 ISO code, 4 country name
+    const QString countryFile = qEnvironmentVariable("GEONAMES_COUNTRY_INFO");
+    if (!countryFile.isEmpty()) {
+        readTsv(countryFile, [](const QList<QByteArray>& f) {
+            if (f.size() >= 5) countryNames.insert(QString::fromUtf8(f[0]), QString::fromUtf8(f[4]));
+        });
+    }
+
+    // admin1CodesASCII.txt: 0 "CC.code", 1 name
+    const QString admin1File = qEnvironmentVariable("GEONAMES_ADMIN1");
+    if (!admin1File.isEmpty()) {
+        readTsv(admin1File, [](const QList<QByteArray>& f) {
+            if (f.size() >= 2) admin1Names.insert(QString::fromUtf8(f[0]), QString::fromUtf8(f[1]));
+        });
+    }
+
+    tree = std::move(places);
+    build(0, tree.size(), 0);
+    qInfo() << "Reverse geocoder loaded" << tree.size() << "places from" << citiesFile;
+}
+
+bool ReverseGeocoder::isLoaded() {
+    return !tree.empty();
+}
+
+std::size_t ReverseGeocoder::size() {
+    return tree.size();
+}
+
+std::optional<ReverseGeocoder::Place> ReverseGeocoder::lookup(double lat, double lon) {
+    if (tree.empty()) return std::nullopt;
+    if (lat == 0.0 && lon == 0.0) return std::nullopt; // no GPS position
+    if (!std::isfinite(lat) || !std::isfinite(lon) || std::abs(lat) > 90.0 || std::abs(lon) > 180.0) {
+        return std::nullopt;
+    }
+
+    // Starting with the distance limit prunes everything farther away right away
+    std::size_t best = tree.size();
+    double bestDist = maxChordSquared;
+    nearest(0, tree.size(), 0, toUnitVector(lat, lon), best, bestDist);
+    if (best == tree.size()) return std::nullopt;
+
+    const PlaceEntry& entry = tree[best];
+    Place place;
+    place.city = entry.name;
+    place.countryCode = entry.countryCode;
+    place.country = countryNames.value(entry.countryCode, entry.countryCode);
+    place.province = admin1Names.value(entry.countryCode + "." + entry.admin1Code);
+    return place;
+}
@@ -0,0 +1,229 @@
+/**
+ * @file roaring_bitmap.cpp
+ * @brief Implementation of the compressed ID bitmap.
+ */
+#include "roaring_bitmap.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+namespace {
+    constexpr std::uint16_t highBits(std::uint32_t id) { return static_cast<std::uint16_t>(id >> 16); }
+    constexpr std::uint16_t lowBits(std::uint32_t id) { return static_cast<std::uint16_t>(id & 0xFFFF); }
+
+    bool testBit(const std::vector<std::uint64_t>& bits, std::uint16_t v) {
+        return (bits[v >> 6] >> (v & 63)) & 1;
+    }
+}
+
+std::vector<RoaringBitmap::Chunk>::iterator RoaringBitmap::findChunk(std::uint16_t key) {
+    return std::lower_bound(chunks.begin(), chunks.end(), key,
+                            [](const Chunk& c, std::uint16_t k) { return c.key < k; });
+}
+
+std::vector<RoaringBitmap::Chunk>::const_iterator RoaringBitmap::findChunk(std::uint16_t key) const {
+    return std::lower_bound(chunks.begin(), chunks.end(), key,
+                            [](const Chunk& c, std::uint16_t k) { return c.key < k; });
+}
+
+void RoaringBitmap::toBitset(Chunk& chunk) {
+    chunk.bits.assign(BITSET_WORDS, 0);
+    for (std::uint16_t v : chunk.values) chunk.bits[v >> 6] |= std::uint64_t{1} << (v & 63);
+    chunk.values.clear();
+    chunk.values.shrink_to_fit();
+}
+
+void RoaringBitmap::toArray(Chunk& chunk) {
+    chunk.values.clear();
+    chunk.values.reserve(chunk.count);
+    for (std::size_t w = 0; w < chunk.bits.size(); ++w) {
+        std::uint64_t word = chunk.bits[w];
+        while (word) {
+            chunk.values.push_back(static_cast<std::uint16_t>(w * 64 + std::countr_zero(word)));
+            word &= word - 1;
+        }
+    }
+    chunk.bits.clear();
+    chunk.bits.shrink_to_fit();
+}
+
+void RoaringBitmap::add(std::uint32_t id) {
+    const std::uint16_t key = highBits(id);
+    const std::uint16_t v = lowBits(id);
+
+    auto it = findChunk(key);
+    if (it == chunks.end() || it->key != key) {
+        Chunk chunk;
+        chunk.key = key;
+        it = chunks.insert(it, std::move(chunk));
+    }
+
+    if (it->isBitset()) {
+        std::uint64_t& word = it->bits[v >> 6];
+        std::uint64_t mask = std::uint64_t{1} << (v & 63);
+        if (!(word & mask)) {
+            word |= mask;
+            ++it->count;
+        }
+        return;
+    }
+
+    auto pos = std::lower_bound(it->values.begin(), it->values.end(), v);
+    if (pos != it->values.end() && *pos == v) return;
+    it->values.insert(pos, v);
+    ++it->count;
+    if (it->count > ARRAY_MAX) toBitset(*it);
+}
+
+bool RoaringBitmap::remove(std::uint32_t id) {
+    const std::uint16_t key = highBits(id);
+    const std::uint16_t v = lowBits(id);
+
+    auto it = findChunk(key);
+    if (it == chunks.end() || it->key != key) return false;
+
+    if (it->isBitset()) {
+        std::uint64_t& word = it->bits[v >> 6];
+        std::uint64_t mask = std::uint64_t{1} << (v & 63);
+        if (!(word & mask)) return false;
+        word &= ~mask;
+        --it->count;
+        if (it->count < BITSET_MIN) toArray(*it);
+    } else {
+        auto pos = std::lower_bound(it->values.begin(), it->values.end(), v);
+        if (pos == it->values.end() || *pos != v) return false;
+        it->values.erase(pos);
+        --it->count;
+    }
+
+    if (it->count == 0) chunks.erase(it);
+    return true;
+}
+
+bool RoaringBitmap::contains(std::uint32_t id) const {
+    const std::uint16_t key = highBits(id);
+    const std::uint16_t v = lowBits(id);
+
+    auto it = findChunk(key);
+    if (it == chunks.end() || it->key != key) return false;
+    if (it->isBitset()) return testBit(it->bits, v);
+    return std::binary_search(it->values.begin(), it->values.end(), v);
+}
+
+std::uint64_t RoaringBitmap::cardinality() const {
+    std::uint64_t total = 0;
+    for (const auto& chunk : chunks) total += chunk.count;
+    return total;
+}
+
+// ------------------------------------------------------------------
+// INTERSECTION
+// ------------------------------------------------------------------
+
+std::uint32_t RoaringBitmap::intersectCount(const Chunk& a, const Chunk& b) {
+    if (a.isBitset() && b.isBitset()) {
+        std::uint32_t count = 0;
+        for (std::size_t w = 0; w < BITSET_WORDS; ++w) count += std::popcount(a.bits[w] & b.bits[w]);
+        return count;
+    }
+    if (a.isBitset() || b.isBitset()) {
+        const Chunk& arr = a.isBitset() ? b : a;
+        const Chunk& set = a.isBitset() ? a : b;
+        std::uint32_t count = 0;
+        for (std::uint16_t v : arr.values) count += testBit(set.bits, v);
+        return count;
+    }
+
+    // Merge of two sorted arrays
+    std::uint32_t count = 0;
+    auto i = a.values.begin();
+    auto j = b.values.begin();
+    while (i != a.values.end() && j != b.values.end()) {
+        if (*i < *j) ++i;
+        else if (*j < *i) ++j;
+        else { ++count; ++i; ++j; }
+    }
+    return count;
+}
+
+RoaringBitmap::Chunk RoaringBitmap::intersect(const Chunk& a, const Chunk& b) {
+    Chunk result;
+    result.key = a.key;
+
+    if (a.isBitset() && b.isBitset()) {
+        result.bits.resize(BITSET_WORDS);
+        for (std::size_t w = 0; w < BITSET_WORDS; ++w) {
+            result.bits[w] = a.bits[w] & b.bits[w];
+            result.count += std::popcount(result.bits[w]);
+        }
+        if (result.count < BITSET_MIN) toArray(result);
+        return result;
+    }
+    if (a.isBitset() || b.isBitset()) {
+        const Chunk& arr = a.isBitset() ? b : a;
+        const Chunk& set = a.isBitset() ? a : b;
+        for (std::uint16_t v : arr.values) {
+            if (testBit(set.bits, v)) result.values.push_back(v);
+        }
+    } else {
+        std::set_intersection(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                              std::back_inserter(result.values));
+    }
+    result.count = static_cast<std::uint32_t>(result.values.size());
+    return result;
+}
+
+RoaringBitmap& RoaringBitmap::operator&=(const RoaringBitmap& other) {
+    std::vector<Chunk> result;
+    auto i = chunks.begin();
+    auto j = other.chunks.begin();
+    while (i != chunks.end() && j != other.chunks.end()) {
+        if (i->key < j->key) ++i;
+        else if (j->key < i->key) ++j;
+        else {
+            Chunk chunk = intersect(*i, *j);
+            if (chunk.count > 0) result.push_back(std::move(chunk));
+            ++i;
+            ++j;
+        }
+    }
+    chunks = std::move(result);
+    return *this;
+}
+
+std::uint64_t RoaringBitmap::andCardinality(const RoaringBitmap& other) const {
+    std::uint64_t total = 0;
+    auto i = chunks.begin();
+    auto j = other.chunks.begin();
+    while (i != chunks.end() && j != other.chunks.end()) {
+        if (i->key < j->key) ++i;
+        else if (j->key < i->key) ++j;
+        else {
+            total += intersectCount(*i, *j);
+            ++i;
+            ++j;
+        }
+    }
+    return total;
+}
+
+std::vector<std::uint32_t> RoaringBitmap::toVector() const {
+    std::vector<std::uint32_t> ids;
+    ids.reserve(cardinality());
+    for (const auto& chunk : chunks) {
+        const std::uint32_t base = static_cast<std::uint32_t>(chunk.key) << 16;
+        if (chunk.isBitset()) {
+            for (std::size_t w = 0; w < BITSET_WORDS; ++w) {
+                std::uint64_t word = chunk.bits[w];
+                while (word) {
+                    ids.push_back(base | static_cast<std::uint32_t>(w * 64 + std::countr_zero(word)));
+                    word &= word - 1;
+                }
+            }
+        } else {
+            for (std::uint16_t v : chunk.values) ids.push_back(base | v);
+        }
+    }
+    return ids;
+}
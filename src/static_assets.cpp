@@ -0,0 +1,136 @@
+/**
+ * @file static_assets.cpp
+ * @brief Implementation of the in-memory static asset store.
+ */
+#include "static_assets.hpp"
+#include "directory_watcher.hpp"
+#include "compression.hpp"
+#include "crow.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+    using AssetMap = std::unordered_map<std::string, std::shared_ptr<const StaticAssets::Asset>>;
+
+    std::shared_mutex mutex;
+    std::shared_ptr<const AssetMap> assets = std::make_shared<AssetMap>();
+    std::size_t totalBytes = 0;
+
+    qint64 maxFileBytes() {
+        bool ok = false;
+        qint64 kb = qEnvironmentVariable("STATIC_MAX_FILE_KB").toLongLong(&ok);
+        return (ok && kb > 0 ? kb : 8192) * 1024;
+    }
+
+    // "main.3f2a9c0d1e4b5a67.js" (webpack / Angular < 17) or "chunk-AB12CD34.js" (esbuild)
+    bool isFingerprinted(const QString& fileName) {
+        static const QRegularExpression hexHash(R"(\.[0-9a-f]{8,}\.[^.]+$)");
+        static const QRegularExpression esbuildHash(R"(-(?=[A-Z0-9]*[0-9])[A-Z0-9]{8}\.[^.]+$)");
+        return hexHash.match(fileName).hasMatch() || esbuildHash.match(fileName).hasMatch();
+    }
+
+    // "app.js.gz" next to "app.js": a precompressed variant of a large file, not an asset
+    bool isDiskVariant(const QString& path) {
+        for (auto encoding : {Compression::Encoding::Gzip, Compression::Encoding::Zstd}) {
+            const QString suffix = Compression::fileSuffix(encoding);
+            if (path.endsWith(suffix) && QFileInfo::exists(path.chopped(suffix.size()))) return true;
+        }
+        return false;
+    }
+
+    std::string mimeType(const QString& fileName) {
+        const std::string ext = QFileInfo(fileName).suffix().toLower().toStdString();
+        auto mime = crow::mime_types.find(ext);
+        return mime != crow::mime_types.end() ? mime->second : "text/plain";
+    }
+}
+
+void StaticAssets::load(const QString& dir) {
+    auto next = std::make_shared<AssetMap>();
+    std::size_t nextBytes = 0;
+    const qint64 maxBytes = maxFileBytes();
+
+    QDir root(dir);
+    QDirIterator it(dir, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        QFileInfo info(path);
+        if (info.size() > maxBytes || isDiskVariant(path)) continue; // served from disk
+
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "Cannot read static asset:" << path;
+            continue;
+        }
+        const QByteArray content = file.readAll();
+
+        auto asset = std::make_shared<Asset>();
+        asset->body.assign(content.constData(), static_cast<std::size_t>(content.size()));
+        asset->contentType = mimeType(path);
+        asset->hash = QCryptographicHash::hash(content, QCryptographicHash::Sha256).toHex().left(16).toStdString();
+        asset->etag = "\"" + asset->hash + "\"";
+        asset->fingerprinted = isFingerprinted(info.fileName());
+
+        if (Compression::isCompressible(asset->contentType) && asset->body.size() >= Compression::minBytes()) {
+            if (auto gz = Compression::compress(asset->body, Compression::Encoding::Gzip, true)) {
+                asset->gzip = std::move(*gz);
+            }
+            if (auto zst = Compression::compress(asset->body, Compression::Encoding::Zstd, true)) {
+                asset->zstd = std::move(*zst);
+            }
+        }
+
+        nextBytes += asset->body.size() + asset->gzip.size() + asset->zstd.size();
+        next->emplace(root.relativeFilePath(path).toStdString(), std::move(asset));
+    }
+
+    // Files left on disk get .gz / .zst siblings instead (rebuilt only when stale)
+    Compression::precompressDirectory(dir, maxBytes + 1);
+
+    const std::size_t count = next->size();
+    {
+        std::unique_lock lock(mutex);
+        assets = std::move(next);
+        totalBytes = nextBytes;
+    }
+    qInfo() << "Loaded" << count << "static assets from" << dir << "(" << nextBytes / 1024 << "KB )";
+}
+
+void StaticAssets::watch(const QString& dir) {
+    if (qEnvironmentVariable("STATIC_RELOAD") != "1") return;
+
+    // 300ms: a deployment touches many files at once
+    DirectoryWatcher::watch(dir, 300, [dir]() { load(dir); });
+    qInfo() << "Watching" << dir << "for changes";
+}
+
+std::shared_ptr<const StaticAssets::Asset> StaticAssets::find(const std::string& relPath) {
+    std::shared_ptr<const AssetMap> current;
+    {
+        std::shared_lock lock(mutex);
+        current = assets;
+    }
+    auto it = current->find(relPath);
+    return it != current->end() ? it->second : nullptr;
+}
+
+std::size_t StaticAssets::count() {
+    std::shared_lock lock(mutex);
+    return assets->size();
+}
+
+std::size_t StaticAssets::bytes() {
+    std::shared_lock lock(mutex);
+    return totalBytes;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file template_registry.cpp
+ * @brief Implementation of the compiled Mustache template registry.
+ */
+#include "template_registry.hpp"
+#include "directory_watcher.hpp"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+    struct Snapshot {
+        std::unordered_map<std::string, std::string> sources; ///< For partials.
+        std::unordered_map<std::string, std::shared_ptr<const TemplateRegistry::Template>> compiled;
+    };
+
+    std::shared_mutex mutex;
+    std::shared_ptr<const Snapshot> current = std::make_shared<Snapshot>();
+
+    std::shared_ptr<const Snapshot> snapshot() {
+        std::shared_lock lock(mutex);
+        return current;
+    }
+}
+
+void TemplateRegistry::load(const QString& dir) {
+    auto next = std::make_shared<Snapshot>();
+
+    QDir root(dir);
+    QDirIterator it(dir, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "Cannot read template:" << path;
+            continue;
+        }
+        const std::string name = root.relativeFilePath(path).toStdString();
+        std::string source = file.readAll().toStdString();
+
+        try {
+            next->compiled.emplace(name, std::make_shared<const Template>(crow::mustache::compile(source)));
+        } catch (const crow::mustache::invalid_template_exception& e) {
+            qWarning() << "Template" << path << "does not compile:" << e.what();
+        }
+        next->sources.emplace(name, std::move(source));
+    }
+
+    const std::size_t compiled = next->compiled.size();
+    {
+        std::unique_lock lock(mutex);
+        current = std::move(next);
+    }
+
+    // Partials are resolved by crow::mustache at render time: serve them from memory.
+    // Installed once, the loader always reads the current snapshot.
+    static std::once_flag loaderInstalled;
+    std::call_once(loaderInstalled, [] {
+        crow::mustache::set_loader([](std::string name) {
+            auto s = snapshot();
+            auto it = s->sources.find(name);
+            return it != s->sources.end() ? it->second : std::string();
+        });
+    });
+
+    qInfo() << "Compiled" << compiled << "templates from" << dir;
+}
+
+void TemplateRegistry::watch(const QString& dir) {
+    if (qEnvironmentVariable("TEMPLATE_RELOAD") != "1") return;
+
+    // 200ms: editors write a file in several steps
+    DirectoryWatcher::watch(dir, 200, [dir]() { load(dir); });
+    qInfo() << "Watching" << dir << "for template changes";
+}
+
+std::shared_ptr<const TemplateRegistry::Template> TemplateRegistry::get(const std::string& name) {
+    auto s = snapshot();
+    auto it = s->compiled.find(name);
+    return it != s->compiled.end() ? it->second : nullptr;
+}
+
+std::size_t TemplateRegistry::count() {
+    return snapshot()->compiled.size();
+}
@@ -3,6 +3,7 @@
  * @brief Parameter implementations.
  */
 #include "utils.hpp"
+#include "crow.h"
 
 #include <set>
 #include <algorithm>
@@ -44,9 +45,60 @@ namespace utils {
         return result;
     }
 
-    std::string getJwtSecret() {
-        const char* env_secret = std::getenv("JWT_SECRET");
-        return env_secret ? std::string(env_secret) : "mein_sehr_geheimes_secret_key_12345";
+    const std::string& getJwtSecret() {
+        static const std::string secret = [] {
+            const char* env_secret = std::getenv("JWT_SECRET");
+            return env_secret ? std::string(env_secret) : std::string("mein_sehr_geheimes_secret_key_12345");
+        }();
+        return secret;
     }
 
-}
\ No newline at end of file
+    std::string clientIp(const crow::request& req) {
+        static const bool trustProxy = [] {
+            const char* env = std::getenv("TRUST_PROXY");
+            return env && std::string(env) == "1";
+        }();
+
+        if (trustProxy) {
+            const std::string& realIp = req.get_header_value("X-Real-IP");
+            if (!realIp.empty()) return realIp;
+
+            // First entry of "client, proxy1, proxy2"
+            const std::string& forwarded = req.get_header_value("X-Forwarded-For");
+            if (!forwarded.empty()) {
+                std::string first = forwarded.substr(0, forwarded.find(','));
+                first.erase(0, first.find_first_not_of(' '));
+                first.erase(first.find_last_not_of(' ') + 1);
+                if (!first.empty()) return first;
+            }
+        }
+        return req.remote_ip_address;
+    }
+
+    bool etagMatches(std::string_view ifNoneMatch, std::string_view etag) {
+        if (etag.starts_with("W/")) etag.remove_prefix(2);
+
+        std::size_t pos = 0;
+        while (pos < ifNoneMatch.size()) {
+            // Skip separators and whitespace between list members
+            while (pos < ifNoneMatch.size() && (ifNoneMatch[pos] == ',' || ifNoneMatch[pos] == ' ' || ifNoneMatch[pos] == '\t')) ++pos;
+            if (pos >= ifNoneMatch.size()) break;
+
+            if (ifNoneMatch[pos] == '*') return true;
+            if (ifNoneMatch.substr(pos).starts_with("W/")) pos += 2;
+
+            // A quoted tag runs to its closing quote, a malformed one to the next comma
+            std::size_t end;
+            if (pos < ifNoneMatch.size() && ifNoneMatch[pos] == '"') {
+                end = ifNoneMatch.find('"', pos + 1);
+                end = end == std::string_view::npos ? ifNoneMatch.size() : end + 1;
+            } else {
+                end = std::min(ifNoneMatch.find(',', pos), ifNoneMatch.size());
+            }
+            if (ifNoneMatch.substr(pos, end - pos) == etag) return true;
+            pos = end;
+        }
+        return false;
+    }
+
+}
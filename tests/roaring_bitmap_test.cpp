@@ -0,0 +1,244 @@
+/**
+ * @file roaring_bitmap_test.cpp
+ * @brief Unit tests of RoaringBitmap: add, remove and intersect, checked against std::set.
+ *
+ * Covers both chunk layouts (sorted array and bitset) and the conversions
+ * between them (array -> bitset above 4096 entries, back below 3072). Run via
+ * ctest or directly; exit code 1 on failure.
+ */
+#include "roaring_bitmap.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+    int failures = 0;
+
+#define CHECK(expr)                                                                       \
+    do {                                                                                  \
+        if (!(expr)) {                                                                    \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #expr); \
+            ++failures;                                                                   \
+        }                                                                                 \
+    } while (false)
+
+    RoaringBitmap fromSet(const std::set<std::uint32_t>& ids) {
+        RoaringBitmap bitmap;
+        for (std::uint32_t id : ids) bitmap.add(id);
+        return bitmap;
+    }
+
+    bool equals(const RoaringBitmap& bitmap, const std::set<std::uint32_t>& expected) {
+        const std::vector<std::uint32_t> ids = bitmap.toVector();
+        return bitmap.cardinality() == expected.size() && std::equal(ids.begin(), ids.end(), expected.begin(), expected.end());
+    }
+
+    std::set<std::uint32_t> intersection(const std::set<std::uint32_t>& a, const std::set<std::uint32_t>& b) {
+        std::set<std::uint32_t> result;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::inserter(result, result.end()));
+        return result;
+    }
+
+    // 'count' random IDs in chunk 'key' (0..65535 low bits)
+    std::set<std::uint32_t> randomChunk(std::mt19937& rng, std::uint16_t key, std::size_t count) {
+        std::uniform_int_distribution<std::uint32_t> low(0, 0xFFFF);
+        std::set<std::uint32_t> ids;
+        while (ids.size() < count) ids.insert((static_cast<std::uint32_t>(key) << 16) | low(rng));
+        return ids;
+    }
+
+    void testAddContains() {
+        RoaringBitmap bitmap;
+        CHECK(bitmap.empty());
+        CHECK(!bitmap.contains(42));
+
+        bitmap.add(42);
+        bitmap.add(42); // duplicate
+        bitmap.add(7);
+        bitmap.add(0x10000); // second chunk
+        bitmap.add(0xFFFFFFFF); // last ID
+        CHECK(!bitmap.empty());
+        CHECK(bitmap.cardinality() == 4);
+        CHECK(bitmap.contains(7) && bitmap.contains(42) && bitmap.contains(0x10000) && bitmap.contains(0xFFFFFFFF));
+        CHECK(!bitmap.contains(43) && !bitmap.contains(0x10001));
+        CHECK(equals(bitmap, {7, 42, 0x10000, 0xFFFFFFFF}));
+    }
+
+    void testRemove() {
+        RoaringBitmap bitmap = fromSet({1, 2, 3, 0x20000});
+        CHECK(bitmap.remove(2));
+        CHECK(!bitmap.remove(2)); // already gone
+        CHECK(!bitmap.remove(99)); // never there
+        CHECK(!bitmap.remove(0x30000)); // chunk does not exist
+        CHECK(equals(bitmap, {1, 3, 0x20000}));
+
+        // Emptied chunks disappear
+        CHECK(bitmap.remove(0x20000));
+        CHECK(bitmap.remove(1));
+        CHECK(bitmap.remove(3));
+        CHECK(bitmap.empty());
+        CHECK(bitmap.cardinality() == 0);
+    }
+
+    // Array -> bitset above 4096 entries and back below 3072
+    void testChunkConversion() {
+        std::set<std::uint32_t> expected;
+        RoaringBitmap bitmap;
+        for (std::uint32_t v = 0; v < 5000; ++v) {
+            bitmap.add(v * 13 % 65536);
+            expected.insert(v * 13 % 65536);
+        }
+        CHECK(equals(bitmap, expected));
+        CHECK(bitmap.contains(13 * 4999 % 65536));
+
+        // Down across both thresholds again (5000 -> 3000)
+        std::vector<std::uint32_t> ids(expected.begin(), expected.end());
+        for (std::size_t i = 0; i < 2000; ++i) {
+            CHECK(bitmap.remove(ids[i * 2]));
+            expected.erase(ids[i * 2]);
+            if (expected.size() == 3500) CHECK(equals(bitmap, expected)); // between 3072 and 4096
+        }
+        CHECK(equals(bitmap, expected));
+        CHECK(!bitmap.contains(ids[0]));
+        CHECK(bitmap.contains(ids[1]));
+    }
+
+    // A chunk around 4096 entries stays a bitset; between 3072 and 4096 both
+    // layouts occur and must behave the same
+    void testHysteresis() {
+        std::set<std::uint32_t> expected;
+        RoaringBitmap bitmap;
+        for (std::uint32_t v = 0; v <= 4096; ++v) {
+            bitmap.add(v * 7);
+            expected.insert(v * 7);
+        }
+
+        // Oscillating across 4096
+        for (int i = 0; i < 1000; ++i) {
+            CHECK(bitmap.remove(7));
+            CHECK(!bitmap.contains(7));
+            bitmap.add(7);
+            CHECK(bitmap.contains(7));
+        }
+        CHECK(equals(bitmap, expected));
+
+        // Down to 3072 (still a bitset), then 3071 (array)
+        while (expected.size() > 3072) {
+            CHECK(bitmap.remove(*expected.rbegin()));
+            expected.erase(std::prev(expected.end()));
+        }
+        CHECK(equals(bitmap, expected));
+        CHECK(!bitmap.remove(3)); // never there
+        CHECK(bitmap.remove(0));
+        expected.erase(0);
+        CHECK(equals(bitmap, expected));
+
+        // An array and a bitset with the same 3500 entries
+        std::set<std::uint32_t> band;
+        for (std::uint32_t v = 0; v < 3500; ++v) band.insert(v * 11);
+        RoaringBitmap array = fromSet(band);
+        RoaringBitmap bitset = fromSet(band);
+        for (std::uint32_t v = 0; v < 700; ++v) bitset.add(v * 11 + 1);
+        for (std::uint32_t v = 0; v < 700; ++v) bitset.remove(v * 11 + 1);
+        CHECK(equals(array, band) && equals(bitset, band));
+        CHECK(array.andCardinality(bitset) == band.size());
+        RoaringBitmap both = bitset;
+        both &= array;
+        CHECK(equals(both, band));
+
+        // Intersection of two bitsets inside the band, then growing and shrinking it
+        RoaringBitmap other = fromSet(band);
+        for (std::uint32_t v = 0; v < 700; ++v) other.add(v * 11 + 2);
+        both = bitset;
+        both &= other;
+        CHECK(equals(both, band));
+        both.add(5);
+        CHECK(both.contains(5) && both.cardinality() == band.size() + 1);
+        CHECK(both.remove(5) && both.remove(0));
+        std::set<std::uint32_t> rest = band;
+        rest.erase(0);
+        CHECK(equals(both, rest));
+    }
+
+    void testIntersect() {
+        std::mt19937 rng(20260118);
+
+        // Chunk 0: array & array, chunk 1: array & bitset, chunk 2: bitset & bitset,
+        // chunk 3 / 4: only on one side
+        std::set<std::uint32_t> a, b;
+        for (const auto& part : {randomChunk(rng, 0, 300), randomChunk(rng, 1, 500), randomChunk(rng, 2, 30000),
+                                 randomChunk(rng, 3, 100)}) {
+            a.insert(part.begin(), part.end());
+        }
+        for (const auto& part : {randomChunk(rng, 0, 400), randomChunk(rng, 1, 20000), randomChunk(rng, 2, 40000),
+                                 randomChunk(rng, 4, 100)}) {
+            b.insert(part.begin(), part.end());
+        }
+        const std::set<std::uint32_t> expected = intersection(a, b);
+
+        const RoaringBitmap ra = fromSet(a);
+        const RoaringBitmap rb = fromSet(b);
+        CHECK(ra.andCardinality(rb) == expected.size());
+        CHECK(rb.andCardinality(ra) == expected.size());
+
+        RoaringBitmap result = ra;
+        result &= rb;
+        CHECK(equals(result, expected));
+
+        // Disjoint and empty operands
+        RoaringBitmap disjoint = fromSet({1, 2, 3});
+        disjoint &= fromSet({4, 5, 0x10001});
+        CHECK(disjoint.empty());
+        CHECK(ra.andCardinality(RoaringBitmap()) == 0);
+
+        // The result stays usable: add / remove after an intersection
+        result.add(0x00050001);
+        CHECK(result.contains(0x00050001));
+        if (!expected.empty()) {
+            CHECK(result.remove(*expected.begin()));
+            CHECK(!result.contains(*expected.begin()));
+        }
+    }
+
+    // Random add / remove sequence against std::set
+    void testRandomOperations() {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<std::uint32_t> id(0, 3 * 65536); // three chunks, dense enough for bitsets
+        std::bernoulli_distribution adding(0.7);
+
+        RoaringBitmap bitmap;
+        std::set<std::uint32_t> expected;
+        for (int i = 0; i < 200000; ++i) {
+            const std::uint32_t v = id(rng);
+            if (adding(rng)) {
+                bitmap.add(v);
+                expected.insert(v);
+            } else {
+                CHECK(bitmap.remove(v) == (expected.erase(v) == 1));
+            }
+        }
+        CHECK(equals(bitmap, expected));
+    }
+}
+
+int main() {
+    testAddContains();
+    testRemove();
+    testChunkConversion();
+    testHysteresis();
+    testIntersect();
+    testRandomOperations();
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("roaring_bitmap_test: all checks passed\n");
+    return 0;
+}